@@ -0,0 +1,17 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/quill-populate"
+  "CMakeFiles/quill-populate-complete"
+  "quill-populate-prefix/src/quill-populate-stamp/quill-populate-build"
+  "quill-populate-prefix/src/quill-populate-stamp/quill-populate-configure"
+  "quill-populate-prefix/src/quill-populate-stamp/quill-populate-download"
+  "quill-populate-prefix/src/quill-populate-stamp/quill-populate-install"
+  "quill-populate-prefix/src/quill-populate-stamp/quill-populate-mkdir"
+  "quill-populate-prefix/src/quill-populate-stamp/quill-populate-patch"
+  "quill-populate-prefix/src/quill-populate-stamp/quill-populate-test"
+  "quill-populate-prefix/src/quill-populate-stamp/quill-populate-update"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang )
+  include(CMakeFiles/quill-populate.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -37,8 +37,8 @@ int main(int argc, char *argv[]) {
   CLI11_PARSE(app, argc, argv);
 
   auto poller = std::make_shared<xsl::Poller>();
-  auto executor = std::make_shared<NewThreadExecutor>();
-  echo<NewThreadExecutor>(ip, port, poller).detach(std::move(executor));
+  auto executor = std::make_shared<WorkStealingExecutor>();
+  echo(ip, port, poller).detach(std::move(executor));
   // echo(ip, port, poller).detach();
   while (true) {
     poller->poll();
@@ -12,15 +12,17 @@ using namespace xsl::feature;
 using namespace xsl::coro;
 using namespace xsl;
 
-template <class Executor = ExecutorBase>
-Lazy<void, Executor> run(std::string_view ip, std::string_view port,
-                         std::shared_ptr<xsl::Poller> poller) {
+auto builder() {
   auto server_builder = http::ServerBuilder<Tcp<Ip<4>>>{};
   server_builder.redirect(http::Method::GET, "/", "/index.html");
   server_builder.add_static("/", {"./build/html/", {"br"}});
-  auto server = std::move(server_builder).build(ip, port, poller).value();
-  co_await server.template run<Executor>();
-  poller->shutdown();
+  return server_builder;
+}
+
+Lazy<void> run(std::string_view ip, std::string_view port, xsl::Runtime& runtime) {
+  auto server = builder().build(ip, port, runtime).value();
+  co_await server.run();
+  runtime.stop();
   co_return;
 }
 
@@ -28,14 +30,24 @@ int main(int argc, char* argv[]) {
   CLI::App app{"Echo server"};
   app.add_option("-i,--ip", ip, "IP address");
   app.add_option("-p,--port", port, "Port");
+  std::size_t threads = 0;
+  app.add_option("-t,--threads", threads, "Reactor threads, 0 means one per core");
+  bool sharded = false;
+  app.add_flag("-s,--sharded", sharded, "One SO_REUSEPORT listener per reactor");
   CLI11_PARSE(app, argc, argv);
 
-  auto poller = std::make_shared<xsl::Poller>();
-  auto executor = std::make_shared<NewThreadExecutor>();
-  // run<NewThreadExecutor>(ip, port, poller).detach(std::move(executor));
-  run(ip, port, poller).detach();
-  while (poller->valid()) {
-    poller->poll();
+  xsl::Runtime runtime{threads};
+  if (sharded) {
+    // every reactor accepts its own connections, steered to the cpu which received them
+    auto server = builder().build(ip, port, runtime, tcp::ReusePortSteering::CBPF).value();
+    server.run();
+    runtime.start();
+    runtime.join();
+    return 0;
   }
+  // the listener lives on the first reactor, the connections are spread over all of them
+  run(ip, port, runtime).detach(runtime.reactor(0));
+  runtime.start();
+  runtime.join();
   return 0;
 }
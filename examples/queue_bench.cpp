@@ -0,0 +1,130 @@
+#include <CLI/CLI.hpp>
+#include <xsl/logctl.h>
+#include <xsl/sync/mpmc.h>
+#include <xsl/sync/mpsc.h>
+#include <xsl/sync/spsc.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace xsl::sync;
+
+std::uint64_t items = 10000000;
+std::size_t threads = 4;
+
+struct Item : MPSCNode {
+  std::uint64_t value = 0;
+};
+
+template <class F>
+void report(const char *name, std::uint64_t count, F &&f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::printf("%-24s %10.2f Mitems/s\n", name, static_cast<double>(count) / elapsed / 1e6);
+}
+
+void spsc(std::size_t batch) {
+  auto queue = std::make_unique<SPSC<std::uint64_t, 4096>>();
+  std::thread producer([&] {
+    std::vector<std::uint64_t> buffer(batch);
+    for (std::uint64_t i = 0; i < items;) {
+      auto n = batch == 1 ? static_cast<std::size_t>(queue->push(std::uint64_t{i}))
+                          : queue->push_n(buffer.begin(), std::min(batch, items - i));
+      if (n == 0) {
+        std::this_thread::yield();
+      }
+      i += n;
+    }
+  });
+  std::vector<std::uint64_t> buffer(batch);
+  for (std::uint64_t i = 0; i < items;) {
+    std::size_t n = 0;
+    if (batch == 1) {
+      n = queue->pop().has_value();
+    } else {
+      n = queue->pop_n(buffer.begin(), batch);
+    }
+    if (n == 0) {
+      std::this_thread::yield();
+    }
+    i += n;
+  }
+  producer.join();
+}
+
+void mpmc(std::size_t producers, std::size_t consumers) {
+  auto queue = std::make_unique<MPMC<std::uint64_t, 4096>>();
+  auto per_producer = items / producers;
+  auto per_consumer = per_producer * producers / consumers;
+  std::vector<std::thread> workers;
+  for (std::size_t p = 0; p < producers; ++p) {
+    workers.emplace_back([&] {
+      for (std::uint64_t i = 0; i < per_producer;) {
+        if (queue->push(std::uint64_t{i})) {
+          ++i;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (std::size_t c = 0; c < consumers; ++c) {
+    workers.emplace_back([&] {
+      for (std::uint64_t i = 0; i < per_consumer;) {
+        if (queue->pop()) {
+          ++i;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+void mpsc(std::size_t producers) {
+  MPSC<Item> queue;
+  auto per_producer = items / producers;
+  std::vector<Item> nodes(per_producer * producers);
+  std::vector<std::thread> workers;
+  for (std::size_t p = 0; p < producers; ++p) {
+    workers.emplace_back([&, p] {
+      for (std::uint64_t i = 0; i < per_producer; ++i) {
+        queue.push(&nodes[p * per_producer + i]);
+      }
+    });
+  }
+  for (std::uint64_t i = 0; i < per_producer * producers;) {
+    if (queue.pop()) {
+      ++i;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+int main(int argc, char *argv[]) {
+  CLI::App app{"Queue microbenchmarks"};
+  app.add_option("-n,--items", items, "Items to move in every case");
+  app.add_option("-t,--threads", threads, "Producers and consumers of the multi-thread cases");
+  CLI11_PARSE(app, argc, argv);
+  xsl::no_log();
+
+  report("spsc", items, [] { spsc(1); });
+  report("spsc batch 64", items, [] { spsc(64); });
+  report("mpmc 1p1c", items, [] { mpmc(1, 1); });
+  report("mpmc np nc", items / threads * threads, [] { mpmc(threads, threads); });
+  report("mpsc np", items / threads * threads, [] { mpsc(threads); });
+  return 0;
+}
@@ -11,3 +11,10 @@ target("http_server")do
     add_deps("xsl")
     add_packages("cli11")
 end
+
+target("queue_bench")do
+    set_kind("binary")
+    add_files("queue_bench.cpp")
+    add_deps("xsl")
+    add_packages("cli11")
+end
@@ -2,17 +2,27 @@
 #ifndef XSL_CORO
 #  define XSL_CORO
 #  include "xsl/coro/await.h"
+#  include "xsl/coro/channel.h"
 #  include "xsl/coro/executor.h"
+#  include "xsl/coro/frame.h"
 #  include "xsl/coro/lazy.h"
+#  include "xsl/coro/pool.h"
 #  include "xsl/coro/semaphore.h"
 #  include "xsl/coro/task.h"
+#  include "xsl/coro/when.h"
 namespace xsl::coro {
+  using _coro::Channel;
   using _coro::CountingSemaphore;
   using _coro::ExecutorBase;
+  using _coro::FrameArena;
   using _coro::GetExecutor;
   using _coro::Lazy;
   using _coro::NewThreadExecutor;
   using _coro::NoopExecutor;
+  using _coro::StopGuard;
   using _coro::Task;
+  using _coro::when_all;
+  using _coro::when_any;
+  using _coro::WorkStealingExecutor;
 }  // namespace xsl::coro
 #endif
@@ -3,9 +3,12 @@
 #  define XSL_CORO_BASE
 #  include "xsl/coro/chain.h"
 #  include "xsl/coro/def.h"
+#  include "xsl/coro/frame.h"
 #  include "xsl/logctl.h"
 
 #  include <cassert>
+#  include <cstddef>
+#  include <memory>
 #  include <optional>
 #  include <type_traits>
 #  include <utility>
@@ -17,6 +20,34 @@ public:
   using executor_type = void;
 
   PromiseBase() : _result(std::nullopt) {}
+  /**
+   * @brief allocate the frame from the cache of the current thread
+   *
+   */
+  static void *operator new(std::size_t size) { return impl_frame::allocate(size, nullptr); }
+  /**
+   * @brief allocate the frame from the arena, for the coroutine taking `std::allocator_arg, arena`
+   * as the first arguments
+   *
+   */
+  template <class... Args>
+  static void *operator new(std::size_t size, std::allocator_arg_t, FrameArena &arena, Args &&...) {
+    return impl_frame::allocate(size, &arena);
+  }
+  /**
+   * @brief allocate the frame from the arena, for the member coroutine taking `std::allocator_arg,
+   * arena` as the first arguments
+   *
+   */
+  template <class Self, class... Args>
+  static void *operator new(std::size_t size, Self &&, std::allocator_arg_t, FrameArena &arena,
+                            Args &&...) {
+    return impl_frame::allocate(size, &arena);
+  }
+
+  static void operator delete(void *ptr, std::size_t size) noexcept {
+    impl_frame::deallocate(ptr, size);
+  }
 
   auto get_return_object(this auto &&self) noexcept {
     LOG6("get_return_object");
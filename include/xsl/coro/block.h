@@ -21,6 +21,31 @@ private:
 public:
   using coro_type = Block<ResultType>;
   using typename Base::result_type;
+
+  class FinalAwaiter {
+  public:
+    bool await_ready() const noexcept { return false; }
+
+    template <class Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+      // the waiting thread may destroy the frame at once, it is safe only after suspended
+      handle.promise()._sem->release();
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+
+  FinalAwaiter final_suspend() noexcept { return {}; }
+  /**
+   * @brief set the semaphore released when the coroutine is done
+   *
+   */
+  void notify(std::binary_semaphore *sem) noexcept { this->_sem = sem; }
+
+private:
+  std::binary_semaphore *_sem = nullptr;
 };
 
 template <class ResultType>
@@ -39,7 +64,18 @@ public:
 
   Block(Block &&task) noexcept : _handle(std::exchange(task._handle, {})) {}
 
-  result_type operator*() { return *_handle.promise(); }
+  /**
+   * @brief run the coroutine and block the current thread until it is done
+   *
+   * @return result_type
+   */
+  result_type wait() {
+    std::binary_semaphore sem{0};
+    _handle.promise().notify(&sem);
+    _handle.resume();
+    sem.acquire();
+    return *_handle.promise();
+  }
 
   ~Block() {
     assert(!_handle || _handle.done());
@@ -56,18 +92,8 @@ template <class Awaiter>
   requires Awaitable<Awaiter, Block<typename awaiter_traits<Awaiter>::result_type>>
 auto block(Awaiter &awaiter) -> typename awaiter_traits<Awaiter>::result_type {
   using result_type = typename awaiter_traits<Awaiter>::result_type;
-  std::binary_semaphore sem{0};
-  auto final = [&sem](Awaiter &awaiter) -> Block<result_type> {
-    struct Release {
-      std::binary_semaphore &sem;
-      ~Release() { sem.release(); }
-    } release{sem};
-
-    co_return co_await awaiter;
-  }(awaiter);
-
-  sem.acquire();
-  return *final;
+  auto final = [](Awaiter &awaiter) -> Block<result_type> { co_return co_await awaiter; }(awaiter);
+  return final.wait();
 }
 template <class Awaiter>
   requires(!std::is_lvalue_reference_v<Awaiter>)
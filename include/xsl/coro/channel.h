@@ -0,0 +1,420 @@
+#pragma once
+#ifndef XSL_CORO_CHANNEL
+#  define XSL_CORO_CHANNEL
+#  include "xsl/coro/def.h"
+#  include "xsl/logctl.h"
+
+#  include <array>
+#  include <cassert>
+#  include <coroutine>
+#  include <cstddef>
+#  include <mutex>
+#  include <optional>
+#  include <utility>
+XSL_CORO_NB
+namespace impl_channel {
+  using resume_type = void (*)(std::coroutine_handle<>);
+
+  template <class Promise>
+  void resume(std::coroutine_handle<> handle) {
+    auto h = std::coroutine_handle<Promise>::from_address(handle.address());
+    h.promise().resume(h);
+  }
+  /**
+   * @brief the link of a suspended sender or receiver
+   *
+   */
+  class Waiter {
+  public:
+    Waiter() noexcept : _next(nullptr), _handle(), _resume(nullptr) {}
+
+    template <class Promise>
+    void prepare(std::coroutine_handle<Promise> handle) noexcept {
+      this->_handle = handle;
+      this->_resume = &resume<Promise>;
+    }
+
+    void wake() { this->_resume(this->_handle); }
+
+    Waiter *_next;
+
+  private:
+    std::coroutine_handle<> _handle;
+    resume_type _resume;
+  };
+  /**
+   * @brief an intrusive FIFO queue of waiters
+   *
+   * @tparam T the waiter type, derived from Waiter
+   */
+  template <class T>
+  class WaitQueue {
+  public:
+    WaitQueue() noexcept : _head(nullptr), _tail(nullptr) {}
+
+    bool empty() const noexcept { return this->_head == nullptr; }
+
+    void push(T *waiter) noexcept {
+      waiter->_next = nullptr;
+      if (this->_tail == nullptr) {
+        this->_head = waiter;
+      } else {
+        this->_tail->_next = waiter;
+      }
+      this->_tail = waiter;
+    }
+
+    T *pop() noexcept {
+      auto waiter = this->_head;
+      if (waiter != nullptr) {
+        this->_head = static_cast<T *>(waiter->_next);
+        if (this->_head == nullptr) {
+          this->_tail = nullptr;
+        }
+      }
+      return waiter;
+    }
+    /**
+     * @brief take all waiters
+     *
+     * @return T* the first waiter, linked by _next
+     */
+    T *take() noexcept {
+      this->_tail = nullptr;
+      return std::exchange(this->_head, nullptr);
+    }
+
+  private:
+    T *_head;
+    T *_tail;
+  };
+}  // namespace impl_channel
+
+template <class T, std::size_t N>
+class Channel;
+
+template <class T, std::size_t N>
+class SendAwaiter : public impl_channel::Waiter {
+public:
+  using executor_type = void;
+
+  SendAwaiter(Channel<T, N> &chan, T &&value)
+      : Waiter(), _chan(chan), _value(std::move(value)), _sent(false) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  template <class Promise>
+  bool await_suspend(std::coroutine_handle<Promise> handle) {
+    this->prepare(handle);
+    return this->_chan.send_or_wait(this);
+  }
+  /**
+   * @brief the result of sending
+   *
+   * @return true if the value is sent, false if the channel is closed and the value is dropped
+   */
+  bool await_resume() noexcept { return this->_sent; }
+
+private:
+  friend class Channel<T, N>;
+
+  Channel<T, N> &_chan;
+  T _value;
+  bool _sent;
+};
+
+template <class T, std::size_t N>
+class RecvAwaiter : public impl_channel::Waiter {
+public:
+  using executor_type = void;
+
+  RecvAwaiter(Channel<T, N> &chan) : Waiter(), _chan(chan), _value(std::nullopt) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  template <class Promise>
+  bool await_suspend(std::coroutine_handle<Promise> handle) {
+    this->prepare(handle);
+    return this->_chan.recv_or_wait(this);
+  }
+  /**
+   * @brief the received value
+   *
+   * @return std::optional<T> nullopt if the channel is closed and drained
+   */
+  std::optional<T> await_resume() noexcept { return std::move(this->_value); }
+
+protected:
+  friend class Channel<T, N>;
+
+  Channel<T, N> &_chan;
+  std::optional<T> _value;
+};
+
+template <class T, std::size_t N, class OutputIt>
+class RecvManyAwaiter : public RecvAwaiter<T, N> {
+private:
+  using Base = RecvAwaiter<T, N>;
+
+public:
+  RecvManyAwaiter(Channel<T, N> &chan, OutputIt out, std::size_t max)
+      : Base(chan), _out(std::move(out)), _max(max), _count(0) {}
+
+  template <class Promise>
+  bool await_suspend(std::coroutine_handle<Promise> handle) {
+    this->prepare(handle);
+    this->_count = this->_chan.take_many(this->_out, this->_max);
+    if (this->_count != 0) {
+      return false;
+    }
+    return this->_chan.recv_or_wait(this);
+  }
+  /**
+   * @brief the number of received values
+   *
+   * @return std::size_t 0 if the channel is closed and drained
+   */
+  std::size_t await_resume() {
+    if (this->_value) {
+      *this->_out = std::move(*this->_value);
+      ++this->_out;
+      ++this->_count;
+    }
+    return this->_count;
+  }
+
+private:
+  OutputIt _out;
+  std::size_t _max;
+  std::size_t _count;
+};
+/**
+ * @brief A bounded channel between coroutines, safe with any number of senders and receivers on
+ * any executors
+ *
+ * @note the values are buffered in a ring of N slots. A sender suspends while the ring is full, a
+ * receiver suspends while it is empty, and they are resumed in FIFO order by their own executors.
+ * After close, the sends fail and the receivers drain the ring, then get nullopt
+ * @tparam T the value type, only needs to be move constructible
+ * @tparam N the capacity of the buffer
+ */
+template <class T, std::size_t N>
+class Channel {
+  static_assert(N > 0, "Channel capacity must be greater than 0");
+
+  using send_awaiter_type = SendAwaiter<T, N>;
+  using recv_awaiter_type = RecvAwaiter<T, N>;
+
+public:
+  Channel() : _mtx(), _buffer(), _head(0), _size(0), _closed(false), _senders(), _receivers() {}
+  Channel(const Channel &) = delete;
+  Channel &operator=(const Channel &) = delete;
+  ~Channel() {
+    assert(this->_senders.empty() && this->_receivers.empty() && "destroyed with waiters");
+  }
+  /**
+   * @brief send the value, suspend while the buffer is full
+   *
+   * @param value the value
+   * @return SendAwaiter<T, N> resumes with false if the channel is closed
+   */
+  send_awaiter_type send(T value) { return send_awaiter_type{*this, std::move(value)}; }
+  /**
+   * @brief receive a value, suspend while the buffer is empty
+   *
+   * @return RecvAwaiter<T, N> resumes with nullopt if the channel is closed and drained
+   */
+  recv_awaiter_type recv() { return recv_awaiter_type{*this}; }
+  /**
+   * @brief receive at least one and at most max values
+   *
+   * @param out the output iterator
+   * @param max the max number of values, must be greater than 0
+   * @return RecvManyAwaiter resumes with the number of values, 0 if closed and drained
+   */
+  template <class OutputIt>
+  RecvManyAwaiter<T, N, OutputIt> recv_many(OutputIt out, std::size_t max) {
+    assert(max > 0 && "must receive at least one value");
+    return RecvManyAwaiter<T, N, OutputIt>{*this, std::move(out), max};
+  }
+  /**
+   * @brief send the value without waiting
+   *
+   * @return std::optional<T> the value back if the buffer is full or the channel is closed
+   */
+  std::optional<T> try_send(T value) {
+    std::unique_lock guard(this->_mtx);
+    if (this->_closed) {
+      return std::make_optional(std::move(value));
+    }
+    if (auto receiver = this->_receivers.pop()) {
+      receiver->_value.emplace(std::move(value));
+      guard.unlock();
+      receiver->wake();
+      return std::nullopt;
+    }
+    if (this->_size == N) {
+      return std::make_optional(std::move(value));
+    }
+    this->push_back(std::move(value));
+    return std::nullopt;
+  }
+  /**
+   * @brief receive a value without waiting
+   *
+   * @return std::optional<T> nullopt if the buffer is empty
+   */
+  std::optional<T> try_recv() {
+    std::optional<T> value;
+    auto out = &value;
+    this->take_many(out, 1);
+    return value;
+  }
+  /**
+   * @brief close the channel, the waiting senders fail and the waiting receivers get nullopt
+   *
+   */
+  void close() {
+    std::unique_lock guard(this->_mtx);
+    if (this->_closed) {
+      return;
+    }
+    this->_closed = true;
+    auto senders = this->_senders.take();
+    auto receivers = this->_receivers.take();
+    guard.unlock();
+    LOG5("channel closed");
+    wake_all(senders);
+    wake_all(receivers);
+  }
+
+  bool closed() {
+    std::lock_guard guard(this->_mtx);
+    return this->_closed;
+  }
+
+  std::size_t size() {
+    std::lock_guard guard(this->_mtx);
+    return this->_size;
+  }
+
+  static constexpr std::size_t capacity() noexcept { return N; }
+
+private:
+  friend send_awaiter_type;
+  friend recv_awaiter_type;
+  template <class, std::size_t, class>
+  friend class RecvManyAwaiter;
+
+  std::mutex _mtx;
+  std::array<std::optional<T>, N> _buffer;
+  std::size_t _head;  ///< the index of the first value
+  std::size_t _size;
+  bool _closed;
+  impl_channel::WaitQueue<send_awaiter_type> _senders;    ///< waiting for a free slot
+  impl_channel::WaitQueue<recv_awaiter_type> _receivers;  ///< waiting for a value
+
+  void push_back(T &&value) {
+    this->_buffer[(this->_head + this->_size) % N].emplace(std::move(value));
+    ++this->_size;
+  }
+
+  T pop_front() {
+    auto &slot = this->_buffer[this->_head];
+    T value = std::move(*slot);
+    slot.reset();
+    this->_head = (this->_head + 1) % N;
+    --this->_size;
+    return value;
+  }
+
+  static void wake_all(impl_channel::Waiter *waiter) {
+    while (waiter != nullptr) {
+      auto next = waiter->_next;
+      waiter->wake();
+      waiter = next;
+    }
+  }
+  /**
+   * @brief send the value of the awaiter or queue it
+   *
+   * @return true if the sender is queued
+   */
+  bool send_or_wait(send_awaiter_type *sender) {
+    std::unique_lock guard(this->_mtx);
+    if (this->_closed) {
+      return false;
+    }
+    sender->_sent = true;
+    if (auto receiver = this->_receivers.pop()) {
+      // the buffer is empty while a receiver waits, hand the value over directly
+      receiver->_value.emplace(std::move(sender->_value));
+      guard.unlock();
+      receiver->wake();
+      return false;
+    }
+    if (this->_size < N) {
+      this->push_back(std::move(sender->_value));
+      return false;
+    }
+    sender->_sent = false;
+    this->_senders.push(sender);
+    return true;
+  }
+  /**
+   * @brief move at most max values out, refill the buffer from the waiting senders, then unlock
+   * and resume them
+   *
+   * @param guard the locked guard
+   * @return std::size_t the number of values
+   */
+  template <class OutputIt>
+  std::size_t take(std::unique_lock<std::mutex> &guard, OutputIt &out, std::size_t max) {
+    std::size_t count = 0;
+    for (; count < max && this->_size != 0; ++count, ++out) {
+      *out = this->pop_front();
+    }
+    impl_channel::Waiter *woken = nullptr;
+    auto tail = &woken;
+    while (this->_size < N) {
+      auto sender = this->_senders.pop();
+      if (sender == nullptr) {
+        break;
+      }
+      this->push_back(std::move(sender->_value));
+      sender->_sent = true;
+      *tail = sender;
+      tail = &sender->_next;
+    }
+    *tail = nullptr;
+    guard.unlock();
+    wake_all(woken);
+    return count;
+  }
+
+  template <class OutputIt>
+  std::size_t take_many(OutputIt &out, std::size_t max) {
+    std::unique_lock guard(this->_mtx);
+    return this->take(guard, out, max);
+  }
+  /**
+   * @brief receive a value into the awaiter or queue it
+   *
+   * @return true if the receiver is queued
+   */
+  bool recv_or_wait(recv_awaiter_type *receiver) {
+    std::unique_lock guard(this->_mtx);
+    if (this->_size != 0) {
+      auto out = &receiver->_value;
+      this->take(guard, out, 1);
+      return false;
+    }
+    if (this->_closed) {
+      return false;
+    }
+    this->_receivers.push(receiver);
+    return true;
+  }
+};
+XSL_CORO_NE
+#endif
@@ -0,0 +1,183 @@
+#pragma once
+#ifndef XSL_CORO_FRAME
+#  define XSL_CORO_FRAME
+#  include "xsl/coro/def.h"
+
+#  include <array>
+#  include <cstddef>
+#  include <cstdint>
+#  include <new>
+XSL_CORO_NB
+class FrameArena;
+
+namespace impl_frame {
+  /// @brief the header before every frame, keeps the frame aligned as operator new does
+  const std::size_t HEADER_SIZE = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+  /// @brief the smallest size class is 1 << MIN_CLASS_BITS bytes
+  const std::size_t MIN_CLASS_BITS = 6;
+  /// @brief the number of size classes, from 64 to 4096 bytes, larger frames use operator new
+  const std::size_t CLASSES = 7;
+  /// @brief the max number of cached frames of every size class in one thread
+  const uint32_t MAX_THREAD_CACHED = 64;
+
+  static_assert(HEADER_SIZE >= sizeof(FrameArena *), "the header must hold the owner");
+  /**
+   * @brief the size class of the block
+   *
+   * @param size the size of the block, including the header
+   * @return std::size_t CLASSES if the block is too large
+   */
+  constexpr std::size_t size_class(std::size_t size) noexcept {
+    std::size_t idx = 0;
+    while (idx < CLASSES && (std::size_t{1} << (MIN_CLASS_BITS + idx)) < size) {
+      ++idx;
+    }
+    return idx;
+  }
+
+  constexpr std::size_t class_size(std::size_t idx) noexcept {
+    return std::size_t{1} << (MIN_CLASS_BITS + idx);
+  }
+
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+  /**
+   * @brief the free lists of every size class
+   *
+   */
+  class FreeLists {
+  public:
+    FreeLists() noexcept : _heads{}, _counts{} {}
+    FreeLists(const FreeLists &) = delete;
+    FreeLists &operator=(const FreeLists &) = delete;
+    ~FreeLists() { this->release(); }
+
+    void *pop(std::size_t idx) noexcept {
+      auto block = this->_heads[idx];
+      if (block == nullptr) {
+        return nullptr;
+      }
+      this->_heads[idx] = block->next;
+      --this->_counts[idx];
+      return block;
+    }
+    /**
+     * @brief cache the block
+     *
+     * @return true if the block is cached, false if the list has max blocks
+     */
+    bool push(std::size_t idx, void *ptr, uint32_t max) noexcept {
+      if (this->_counts[idx] >= max) {
+        return false;
+      }
+      this->_heads[idx] = new (ptr) FreeBlock{this->_heads[idx]};
+      ++this->_counts[idx];
+      return true;
+    }
+    /**
+     * @brief free all cached blocks
+     *
+     */
+    void release() noexcept {
+      for (std::size_t idx = 0; idx < CLASSES; ++idx) {
+        while (auto block = this->pop(idx)) {
+          ::operator delete(block, class_size(idx));
+        }
+      }
+    }
+
+  private:
+    std::array<FreeBlock *, CLASSES> _heads;
+    std::array<uint32_t, CLASSES> _counts;
+  };
+
+  class ThreadCache : public FreeLists {
+  public:
+    ~ThreadCache();
+  };
+
+  inline thread_local ThreadCache thread_cache;
+  /// @brief false once the cache of the thread is destroyed, the later frames bypass it
+  inline thread_local bool thread_cache_alive = true;
+
+  inline ThreadCache::~ThreadCache() {
+    this->release();
+    thread_cache_alive = false;
+  }
+
+  void *allocate(std::size_t size, FrameArena *arena);
+  void deallocate(void *ptr, std::size_t size) noexcept;
+}  // namespace impl_frame
+
+/**
+ * @brief An arena of coroutine frames, such as for a connection
+ *
+ * @note pass `std::allocator_arg, arena` as the first arguments of a coroutine to allocate its
+ * frame from the arena, after the object for member coroutines. The freed frames are cached in the
+ * arena without limit until it is destroyed, so the same coroutines of the next request reuse them.
+ * Not thread safe, the coroutines of one arena must not run at the same time, and the arena must
+ * outlive them
+ */
+class FrameArena : private impl_frame::FreeLists {
+public:
+  FrameArena() noexcept : FreeLists() {}
+
+private:
+  friend void *impl_frame::allocate(std::size_t size, FrameArena *arena);
+  friend void impl_frame::deallocate(void *ptr, std::size_t size) noexcept;
+};
+
+namespace impl_frame {
+  /**
+   * @brief allocate a frame from the arena, or from the cache of the thread if arena is nullptr
+   *
+   * @param size the size of the frame
+   * @param arena the arena, nullable
+   * @return void* the frame
+   */
+  inline void *allocate(std::size_t size, FrameArena *arena) {
+    auto total = size + HEADER_SIZE;
+    auto idx = size_class(total);
+    void *block = nullptr;
+    if (idx < CLASSES) {
+      if (arena != nullptr) {
+        block = arena->pop(idx);
+      } else if (thread_cache_alive) {
+        block = thread_cache.pop(idx);
+      }
+      if (block == nullptr) {
+        block = ::operator new(class_size(idx));
+      }
+    } else {
+      block = ::operator new(total);
+    }
+    *static_cast<FrameArena **>(block) = arena;
+    return static_cast<std::byte *>(block) + HEADER_SIZE;
+  }
+  /**
+   * @brief free the frame to where it is allocated from
+   *
+   * @note the frames of the thread cache are cached by the freeing thread
+   * @param ptr the frame
+   * @param size the size of the frame
+   */
+  inline void deallocate(void *ptr, std::size_t size) noexcept {
+    auto block = static_cast<std::byte *>(ptr) - HEADER_SIZE;
+    auto total = size + HEADER_SIZE;
+    auto idx = size_class(total);
+    if (idx >= CLASSES) {
+      ::operator delete(block, total);
+      return;
+    }
+    if (auto arena = *reinterpret_cast<FrameArena **>(block); arena != nullptr) {
+      arena->push(idx, block, UINT32_MAX);
+      return;
+    }
+    if (!thread_cache_alive || !thread_cache.push(idx, block, MAX_THREAD_CACHED)) {
+      ::operator delete(block, class_size(idx));
+    }
+  }
+}  // namespace impl_frame
+XSL_CORO_NE
+#endif
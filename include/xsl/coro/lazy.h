@@ -24,9 +24,17 @@ public:
   using typename Base::result_type;
 
   using Base::Base;
-  bool await_ready() {
-    _handle.promise().resume(_handle);
-    return _handle.done();
+  bool await_ready() const noexcept { return false; }
+  /**
+   * @brief set the continuation, then start the lazy coroutine
+   *
+   * @return std::coroutine_handle<> the lazy coroutine if it runs on the executor of the awaiting
+   * coroutine, otherwise it is scheduled to its own executor and noop is returned
+   */
+  template <class _Promise>
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<_Promise> handle) {
+    Base::await_suspend(handle);
+    return _handle.promise().start(_handle, impl_next::executor_of(handle.promise()));
   }
 
 protected:
@@ -6,13 +6,55 @@
 #  include "xsl/coro/def.h"
 #  include "xsl/logctl.h"
 
+#  include <atomic>
 #  include <concepts>
-#  include <functional>
+#  include <coroutine>
+#  include <cstdint>
 #  include <memory>
-#  include <optional>
 #  include <type_traits>
 #  include <utility>
 XSL_CORO_NB
+namespace impl_next {
+  /**
+   * @brief the executor of the promise, used to check if two coroutines run on the same executor
+   *
+   * @return const void* nullptr if the promise has no executor
+   */
+  template <class Promise>
+  const void *executor_of(Promise &promise) noexcept {
+    if constexpr (requires { promise.executor().get(); }) {
+      return promise.executor().get();
+    } else {
+      return nullptr;
+    }
+  }
+  /**
+   * @brief the coroutine to transfer to from a coroutine running on the executor
+   *
+   * @note the coroutine is transferred to directly if it runs on the same executor or has none,
+   * otherwise it is resumed by its own executor
+   * @param handle the coroutine
+   * @param executor the executor of the current coroutine
+   * @return std::coroutine_handle<> the coroutine to transfer to
+   */
+  template <class Promise>
+  std::coroutine_handle<> transfer(std::coroutine_handle<> handle, const void *executor) {
+    auto h = std::coroutine_handle<Promise>::from_address(handle.address());
+    if (auto target = executor_of(h.promise()); target != nullptr && target != executor) {
+      h.promise().resume(h);
+      return std::noop_coroutine();
+    }
+    return h;
+  }
+
+  using transfer_type = std::coroutine_handle<> (*)(std::coroutine_handle<>, const void *);
+
+  enum class NextState : uint8_t {
+    RUNNING,
+    AWAITED,  ///< the continuation is set
+    DONE,     ///< the coroutine reaches the final suspend point
+  };
+}  // namespace impl_next
 
 template <class Promise>
 class NextAwaiter {
@@ -39,10 +81,16 @@ public:
     }
   }
 
+  /**
+   * @brief register the awaiting coroutine as the continuation
+   *
+   * @return std::coroutine_handle<> the awaiting coroutine if the task is already done, so it is
+   * resumed at once, otherwise noop
+   */
   template <class _Promise>
-  void await_suspend(std::coroutine_handle<_Promise> handle) {
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<_Promise> handle) {
     LOG6("await_suspend: {} -> {}", (uint64_t)_handle.address(), (uint64_t)handle.address());
-    this->_handle.promise().next(handle);
+    return this->_handle.promise().next(handle);
   }
 
   result_type await_resume() {
@@ -63,7 +111,33 @@ public:
   using typename Base::result_type;
   using executor_type = Executor;
 
-  NextPromiseBase() : Base(), _next_resume(std::nullopt), _executor(nullptr) {}
+  NextPromiseBase()
+      : Base(),
+        _next(),
+        _next_transfer(nullptr),
+        _state(impl_next::NextState::RUNNING),
+        _executor() {}
+
+  class FinalAwaiter {
+  public:
+    bool await_ready() const noexcept { return false; }
+
+    template <class Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+      return handle.promise().complete();
+    }
+
+    void await_resume() const noexcept {}
+  };
+  /**
+   * @brief hand off to the continuation at the final suspend point, so the chain of co_await is
+   * resumed without growing the stack
+   *
+   */
+  FinalAwaiter final_suspend() noexcept {
+    LOG6("final_suspend");
+    return {};
+  }
 
   auto &&await_transform(this auto &&self, auto &&awaitable) {
     LOG6("await_transform");
@@ -78,17 +152,10 @@ public:
 
   template <class Promise>
   void resume(std::coroutine_handle<Promise> handle) {
-    this->dispatch([handle, this]() mutable {
+    // the continuation is resumed by the final suspend point, not here
+    this->dispatch([handle]() mutable {
       LOG6("task resume {}", (uint64_t)handle.address());
       handle();
-      LOG6("task resume {} done", (uint64_t)handle.address());
-      if (handle.done()) {
-        LOG6("task resume handle done");
-        if (this->_next_resume) {
-          LOG6("task resume next_resume");
-          (*this->_next_resume)();
-        }
-      }
     });
   }
 
@@ -102,10 +169,52 @@ public:
   }
 
   const std::shared_ptr<executor_type> &executor() const noexcept { return _executor; }
-
+  /**
+   * @brief check if the coroutine is done, safe to call while it runs on another thread
+   *
+   */
+  bool done() const noexcept {
+    return this->_state.load(std::memory_order_acquire) == impl_next::NextState::DONE;
+  }
+  /**
+   * @brief set the continuation
+   *
+   * @param handle the awaiting coroutine
+   * @return std::coroutine_handle<> the awaiting coroutine if this one is done, otherwise noop
+   */
   template <class Promise>
-  void next(std::coroutine_handle<Promise> handle) {
-    _next_resume = [handle]() mutable { handle.promise().resume(handle); };
+  std::coroutine_handle<> next(std::coroutine_handle<Promise> handle) {
+    this->_next = handle;
+    this->_next_transfer = &impl_next::transfer<Promise>;
+    if (this->_state.exchange(impl_next::NextState::AWAITED, std::memory_order_acq_rel)
+        == impl_next::NextState::DONE) {
+      return handle;
+    }
+    return std::noop_coroutine();
+  }
+  /**
+   * @brief start the coroutine awaited by the coroutine of the executor
+   *
+   * @param handle this coroutine, suspended at the initial suspend point
+   * @param executor the executor of the awaiting coroutine
+   * @return std::coroutine_handle<> this coroutine if it runs on the same executor, otherwise noop
+   */
+  template <class Promise>
+  std::coroutine_handle<> start(std::coroutine_handle<Promise> handle, const void *executor) {
+    return impl_next::transfer<Promise>(handle, executor);
+  }
+  /**
+   * @brief mark the coroutine done
+   *
+   * @return std::coroutine_handle<> the continuation to transfer to, noop if nobody awaits yet
+   */
+  std::coroutine_handle<> complete() noexcept {
+    if (this->_state.exchange(impl_next::NextState::DONE, std::memory_order_acq_rel)
+        != impl_next::NextState::AWAITED) {
+      return std::noop_coroutine();
+    }
+    // this frame may be destroyed once the continuation is scheduled, so nothing is touched after
+    return this->_next_transfer(this->_next, this->_executor.get());
   }
 
   template <class E>
@@ -116,7 +225,9 @@ public:
   }
 
 protected:
-  std::optional<std::function<void()>> _next_resume;
+  std::coroutine_handle<> _next;
+  impl_next::transfer_type _next_transfer;
+  std::atomic<impl_next::NextState> _state;
 
   std::shared_ptr<executor_type> _executor;
 };
@@ -0,0 +1,205 @@
+#pragma once
+#ifndef XSL_CORO_POOL
+#  define XSL_CORO_POOL
+#  include "xsl/coro/def.h"
+#  include "xsl/coro/executor.h"
+
+#  include <atomic>
+#  include <cstddef>
+#  include <cstdint>
+#  include <deque>
+#  include <memory>
+#  include <mutex>
+#  include <thread>
+#  include <vector>
+XSL_CORO_NB
+namespace impl_pool {
+  /**
+   * @brief A Chase-Lev work stealing deque of pointers
+   *
+   * @note the owner pushes and pops at the bottom, the thieves steal from the top. The buffer
+   * grows when it is full, the old buffers are kept until the deque is destroyed, since a thief may
+   * still read them
+   * @tparam T the element type
+   */
+  template <class T>
+  class WorkDeque {
+    class Buffer {
+    public:
+      explicit Buffer(std::size_t capacity)
+          : _mask(capacity - 1), _slots(std::make_unique<std::atomic<T *>[]>(capacity)) {}
+
+      std::size_t capacity() const noexcept { return this->_mask + 1; }
+
+      T *get(int64_t idx) const noexcept {
+        return this->_slots[static_cast<std::size_t>(idx) & this->_mask].load(
+            std::memory_order_relaxed);
+      }
+
+      void put(int64_t idx, T *value) noexcept {
+        this->_slots[static_cast<std::size_t>(idx) & this->_mask].store(value,
+                                                                        std::memory_order_relaxed);
+      }
+
+    private:
+      std::size_t _mask;
+      std::unique_ptr<std::atomic<T *>[]> _slots;
+    };
+
+  public:
+    /**
+     * @brief Construct a new Work Deque object
+     *
+     * @param capacity the initial capacity, must be power of 2
+     */
+    explicit WorkDeque(std::size_t capacity = 256) : _top(0), _bottom(0), _buffer(), _buffers() {
+      this->_buffers.push_back(std::make_unique<Buffer>(capacity));
+      this->_buffer.store(this->_buffers.back().get(), std::memory_order_relaxed);
+    }
+    WorkDeque(WorkDeque &&) = delete;
+    WorkDeque &operator=(WorkDeque &&) = delete;
+    /**
+     * @brief push the value to the bottom, only the owner may call it
+     *
+     * @param value the value
+     */
+    void push(T *value) {
+      auto b = this->_bottom.load(std::memory_order_relaxed);
+      auto t = this->_top.load(std::memory_order_acquire);
+      auto buffer = this->_buffer.load(std::memory_order_relaxed);
+      if (b - t > static_cast<int64_t>(buffer->capacity()) - 1) {
+        buffer = this->grow(buffer, t, b);
+      }
+      buffer->put(b, value);
+      this->_bottom.store(b + 1, std::memory_order_release);
+    }
+    /**
+     * @brief pop the value from the bottom, only the owner may call it
+     *
+     * @return T* nullptr if the deque is empty
+     */
+    T *pop() noexcept {
+      auto b = this->_bottom.load(std::memory_order_relaxed) - 1;
+      auto buffer = this->_buffer.load(std::memory_order_relaxed);
+      this->_bottom.store(b, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      auto t = this->_top.load(std::memory_order_relaxed);
+      if (t > b) {
+        this->_bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+      }
+      auto value = buffer->get(b);
+      if (t == b) {
+        // the last value, race with the thieves
+        if (!this->_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                std::memory_order_relaxed)) {
+          value = nullptr;
+        }
+        this->_bottom.store(b + 1, std::memory_order_relaxed);
+      }
+      return value;
+    }
+    /**
+     * @brief steal the value from the top, any thread may call it
+     *
+     * @return T* nullptr if the deque is empty or another thread wins the race
+     */
+    T *steal() noexcept {
+      auto t = this->_top.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      auto b = this->_bottom.load(std::memory_order_acquire);
+      if (t >= b) {
+        return nullptr;
+      }
+      auto value = this->_buffer.load(std::memory_order_acquire)->get(t);
+      if (!this->_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                              std::memory_order_relaxed)) {
+        return nullptr;
+      }
+      return value;
+    }
+
+    bool empty() const noexcept {
+      return this->_bottom.load(std::memory_order_acquire)
+             <= this->_top.load(std::memory_order_acquire);
+    }
+
+  private:
+    alignas(64) std::atomic<int64_t> _top;
+    alignas(64) std::atomic<int64_t> _bottom;
+    std::atomic<Buffer *> _buffer;
+    std::vector<std::unique_ptr<Buffer>> _buffers;  ///< all buffers ever used, owned by the owner
+
+    Buffer *grow(Buffer *old, int64_t top, int64_t bottom) {
+      auto buffer = std::make_unique<Buffer>(old->capacity() * 2);
+      for (auto i = top; i < bottom; ++i) {
+        buffer->put(i, old->get(i));
+      }
+      auto raw = buffer.get();
+      this->_buffers.push_back(std::move(buffer));
+      this->_buffer.store(raw, std::memory_order_release);
+      return raw;
+    }
+  };
+}  // namespace impl_pool
+
+/**
+ * @brief A fixed size thread pool executor with work stealing
+ *
+ * @note every worker owns a deque and a LIFO slot. A function scheduled by a worker goes to its
+ * LIFO slot, so a coroutine resumed by another one runs next on the same core, the function in the
+ * slot before is moved to the deque. The functions scheduled by other threads go to a shared
+ * queue. An idle worker steals from the others, spins for a while, then parks until new work
+ * arrives. The executor must not be destroyed by its own workers
+ */
+class WorkStealingExecutor : public ExecutorBase {
+  using job_type = move_only_function<void()>;
+
+  struct Worker {
+    impl_pool::WorkDeque<job_type> deque;
+    std::atomic<job_type *> lifo{nullptr};  ///< the last scheduled job, may be stolen
+    uint32_t tick = 0;
+    uint32_t lifo_streak = 0;  ///< the number of jobs taken from the lifo slot in a row
+    uint32_t seed = 0;         ///< the seed to pick the victim
+    std::thread thread;
+  };
+
+public:
+  /**
+   * @brief Construct a new Work Stealing Executor object, the workers start at once
+   *
+   * @param threads the number of workers, 0 means one per available core
+   */
+  explicit WorkStealingExecutor(std::size_t threads = 0);
+  WorkStealingExecutor(WorkStealingExecutor &&) = delete;
+  WorkStealingExecutor &operator=(WorkStealingExecutor &&) = delete;
+  /**
+   * @brief stop the workers after the queued functions are run
+   *
+   */
+  ~WorkStealingExecutor();
+
+  void schedule(move_only_function<void()> &&func) override;
+
+  std::size_t size() const noexcept { return this->_workers.size(); }
+
+private:
+  std::vector<std::unique_ptr<Worker>> _workers;
+  std::mutex _mtx;
+  std::deque<job_type *> _injected;  ///< the jobs scheduled by other threads
+  std::atomic_size_t _injected_size;
+  std::atomic_size_t _searching;  ///< the number of workers spinning for work
+  std::atomic_size_t _sleepers;   ///< the number of parked workers
+  std::atomic_uint32_t _epoch;    ///< bumped to unpark the workers
+  std::atomic_bool _stopped;
+
+  void run(std::size_t idx);
+  job_type *find(std::size_t idx);
+  job_type *steal(std::size_t idx);
+  job_type *pop_injected();
+  bool has_work() const;
+  void park();
+  void notify();
+};
+XSL_CORO_NE
+#endif
@@ -3,140 +3,349 @@
 #  define XSL_CORO_SEMAPHORE
 #  include "xsl/coro/def.h"
 #  include "xsl/logctl.h"
-#  include "xsl/sync/spsc.h"
 
-#  include <functional>
+#  include <algorithm>
+#  include <atomic>
+#  include <cassert>
+#  include <coroutine>
+#  include <cstddef>
+#  include <cstdint>
+#  include <limits>
 #  include <mutex>
 #  include <optional>
-#  include <semaphore>
+#  include <stop_token>
 #  include <utility>
 XSL_CORO_NB
 
+namespace impl_semaphore {
+  /// @brief no value and no waiter
+  const uintptr_t EMPTY = 0;
+  /// @brief released with false
+  const uintptr_t READY_FALSE = 1;
+  /// @brief released with true
+  const uintptr_t READY_TRUE = 2;
+  /// @brief the wait is cancelled, resumes with false like READY_FALSE
+  const uintptr_t CANCELLED = 3;
+  /// @brief the states below are not waiters, a waiter is the address of its awaiter
+  const uintptr_t STATE_LIMIT = 4;
+
+  using resume_type = void (*)(std::coroutine_handle<>);
+
+  template <class Promise>
+  void resume(std::coroutine_handle<> handle) {
+    auto h = std::coroutine_handle<Promise>::from_address(handle.address());
+    h.promise().resume(h);
+  }
+  /// @brief called once the value is released, with the context given to the wait
+  using callback_type = void (*)(void *);
+
+  template <class Promise>
+  void resume_address(void *address) {
+    auto h = std::coroutine_handle<Promise>::from_address(address);
+    h.promise().resume(h);
+  }
+}  // namespace impl_semaphore
+
+template <std::ptrdiff_t LeastMaxValue = std::numeric_limits<std::ptrdiff_t>::max()>
+class CountingSemaphore;
+
 template <std::ptrdiff_t LeastMaxValue = std::numeric_limits<std::ptrdiff_t>::max()>
 class CountingSemaphoreAwaiter {
 public:
-  CountingSemaphoreAwaiter(std::counting_semaphore<LeastMaxValue> &sem,
-                           sync::SPSC<std::function<void()>> &queue)
-      : _sem(sem), _queue(queue) {}
+  CountingSemaphoreAwaiter(CountingSemaphore<LeastMaxValue> &sem)
+      : _sem(sem), _next(nullptr), _handle(), _resume(nullptr) {}
 
-  bool await_ready() noexcept(noexcept(_sem.try_acquire())) { return _sem.try_acquire(); }
+  bool await_ready() noexcept { return _sem.try_acquire(); }
 
   template <class Promise>
-  void await_suspend(std::coroutine_handle<Promise> handle) {
+  bool await_suspend(std::coroutine_handle<Promise> handle) {
     LOG6("semaphore await_suspend for {}", (uint64_t)handle.address());
-    _queue.push([handle]() mutable {
-      LOG6("semaphore resume for {}", (uint64_t)handle.address());
-      handle.promise().resume(handle);
-    });
+    this->_handle = handle;
+    this->_resume = &impl_semaphore::resume<Promise>;
+    return this->_sem.wait(this);
   }
 
-  void await_resume() {}
+  void await_resume() noexcept {}
 
 private:
-  std::counting_semaphore<LeastMaxValue> &_sem;
-  sync::SPSC<std::function<void()>> &_queue;
-};
+  friend class CountingSemaphore<LeastMaxValue>;
 
-template <std::ptrdiff_t LeastMaxValue = std::numeric_limits<std::ptrdiff_t>::max()>
+  CountingSemaphore<LeastMaxValue> &_sem;
+  CountingSemaphoreAwaiter *_next;  ///< the next waiter in the queue
+  std::coroutine_handle<> _handle;
+  impl_semaphore::resume_type _resume;
+};
+/**
+ * @brief A coroutine semaphore, safe with any number of producers and consumers
+ *
+ * @note the count is the permits minus the waiters, so acquire and release are a single atomic
+ * operation without contention. The waiters are queued in FIFO order in their awaiters, and
+ * resumed by their own executors
+ * @tparam LeastMaxValue the least max value of the count
+ */
+template <std::ptrdiff_t LeastMaxValue>
 class CountingSemaphore {
 private:
-  std::counting_semaphore<LeastMaxValue> _sem;
-  sync::SPSC<std::function<void()>> _queue;
+  using awaiter_type = CountingSemaphoreAwaiter<LeastMaxValue>;
+
+  std::atomic_ptrdiff_t _count;
+  std::mutex _mtx;  ///< protects the queue
+  awaiter_type *_head;
+  awaiter_type *_tail;
+  std::ptrdiff_t _pending;  ///< the permits released to the waiters not queued yet
 
 public:
-  CountingSemaphore(std::ptrdiff_t initial) : _sem(initial), _queue() {}
+  using executor_type = void;
+
+  CountingSemaphore(std::ptrdiff_t initial)
+      : _count(initial), _mtx(), _head(nullptr), _tail(nullptr), _pending(0) {}
   CountingSemaphore() : CountingSemaphore(0) {}
   CountingSemaphore(const CountingSemaphore &) = delete;
   CountingSemaphore(CountingSemaphore &&) = delete;
   CountingSemaphore &operator=(const CountingSemaphore &) = delete;
   CountingSemaphore &operator=(CountingSemaphore &&) = delete;
-  ~CountingSemaphore() {}
+  ~CountingSemaphore() { assert(this->_head == nullptr && "destroyed with waiters"); }
 
-  CountingSemaphoreAwaiter<LeastMaxValue> operator co_await() {
-    return CountingSemaphoreAwaiter<LeastMaxValue>(_sem, _queue);
+  awaiter_type operator co_await() { return awaiter_type(*this); }
+  /**
+   * @brief acquire a permit without waiting
+   *
+   * @return true if a permit is acquired
+   */
+  bool try_acquire() noexcept {
+    auto count = this->_count.load(std::memory_order_relaxed);
+    while (count > 0) {
+      if (this->_count.compare_exchange_weak(count, count - 1, std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
   }
-
+  /**
+   * @brief release the permits, the waiters are resumed in FIFO order
+   *
+   * @param update the number of permits
+   */
   void release(std::ptrdiff_t update = 1) {
-    auto wait_size = this->_queue.size();
-    if (update > wait_size) {
-      update -= wait_size;
-      this->_sem.release(update);
-      for (std::ptrdiff_t i = 0; i < wait_size; i++) {
-        (*this->_queue.pop())();
+    auto prev = this->_count.fetch_add(update, std::memory_order_release);
+    if (prev >= 0) {
+      return;
+    }
+    auto to_wake = std::min(update, -prev);
+    awaiter_type *woken = nullptr;
+    {
+      std::lock_guard guard(this->_mtx);
+      auto tail = &woken;
+      for (; to_wake > 0 && this->_head != nullptr; --to_wake) {
+        *tail = std::exchange(this->_head, this->_head->_next);
+        tail = &(*tail)->_next;
       }
-    } else {
-      for (std::ptrdiff_t i = 0; i < update; i++) {
-        (*this->_queue.pop())();
+      *tail = nullptr;
+      if (this->_head == nullptr) {
+        this->_tail = nullptr;
       }
+      // the waiters counted but not queued yet take the rest when they come
+      this->_pending += to_wake;
+    }
+    // resume outside the lock, the waiters may release again
+    while (woken != nullptr) {
+      auto next = woken->_next;
+      woken->_resume(woken->_handle);
+      woken = next;
+    }
+  }
+
+private:
+  friend awaiter_type;
+  /**
+   * @brief take a permit or queue the waiter
+   *
+   * @return true if the waiter is queued, false if a permit is taken
+   */
+  bool wait(awaiter_type *awaiter) {
+    if (this->_count.fetch_sub(1, std::memory_order_acquire) > 0) {
+      return false;
     }
+    std::lock_guard guard(this->_mtx);
+    if (this->_pending > 0) {
+      --this->_pending;
+      return false;
+    }
+    awaiter->_next = nullptr;
+    if (this->_tail == nullptr) {
+      this->_head = awaiter;
+    } else {
+      this->_tail->_next = awaiter;
+    }
+    this->_tail = awaiter;
+    return true;
   }
 };
 
 template <>
 class CountingSemaphoreAwaiter<1> {
 public:
-  CountingSemaphoreAwaiter(std::mutex &mtx, std::optional<bool> &ready,
-                           std::optional<std::function<void()>> &cb)
-      : _mtx(mtx), _ready(ready), _cb(cb) {}
+  CountingSemaphoreAwaiter(std::atomic_uintptr_t &state)
+      : _state(state), _context(nullptr), _callback(nullptr) {}
 
-  bool await_ready() noexcept(noexcept(_mtx.lock())) {
+  bool await_ready() const noexcept {
     LOG6("semaphore await_ready");
-    this->_mtx.lock();
-    return this->_ready.has_value();
+    return this->_state.load(std::memory_order_acquire) != impl_semaphore::EMPTY;
   }
 
   template <class Promise>
-  void await_suspend(std::coroutine_handle<Promise> handle) {
+  bool await_suspend(std::coroutine_handle<Promise> handle) noexcept {
     LOG6("semaphore await_suspend for {}", (uint64_t)handle.address());
-    this->_cb = [handle]() mutable { handle.promise().resume(handle); };
-    this->_mtx.unlock();
+    return this->wait(handle.address(), &impl_semaphore::resume_address<Promise>);
+  }
+  /**
+   * @brief wait with a callback instead of a coroutine, such as an awaiter retrying its operation
+   * before resuming its coroutine. The value is taken by await_resume afterwards
+   *
+   * @param context the context passed to the callback, such as the waiting awaiter
+   * @param callback called with the context once the value is released
+   * @return true if waiting, false if the value is ready
+   */
+  bool wait(void *context, impl_semaphore::callback_type callback) noexcept {
+    this->_context = context;
+    this->_callback = callback;
+    auto expected = impl_semaphore::EMPTY;
+    if (this->_state.compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(this),
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_acquire)) {
+      return true;
+    }
+    // released in the meantime, it must be a value since there is only one waiter
+    assert(expected < impl_semaphore::STATE_LIMIT);
+    return false;
   }
 
   [[nodiscard("must use the result of await_resume to confirm the semaphore is ready")]] bool
-  await_resume() {
+  await_resume() noexcept {
     LOG6("semaphore await_resume");
-    this->_mtx.unlock();
-    return *std::exchange(this->_ready, std::nullopt);
+    return this->_state.exchange(impl_semaphore::EMPTY, std::memory_order_acq_rel)
+           == impl_semaphore::READY_TRUE;
   }
 
 private:
-  std::mutex &_mtx;
-  std::optional<bool> &_ready;
-  std::optional<std::function<void()>> &_cb;
+  friend class CountingSemaphore<1>;
+
+  std::atomic_uintptr_t &_state;
+  void *_context;
+  impl_semaphore::callback_type _callback;
 };
 
+/**
+ * @brief A semaphore with at most one waiter, the value is a bool telling if the event is ready
+ *
+ * @note lock free and allocation free, the state is a single word holding empty, the value, or the
+ * address of the waiting awaiter
+ */
 template <>
 class CountingSemaphore<1> {
 private:
-  std::mutex _mtx;
-  std::optional<bool> _ready;
-  std::optional<std::function<void()>> _cb;
+  static_assert(alignof(CountingSemaphoreAwaiter<1>) >= impl_semaphore::STATE_LIMIT,
+                "the low bits of the awaiter address are used as the state");
+
+  std::atomic_uintptr_t _state;
+
+  static uintptr_t value(bool ready) noexcept {
+    return ready ? impl_semaphore::READY_TRUE : impl_semaphore::READY_FALSE;
+  }
 
 public:
   using executor_type = void;
+  using awaiter_type = CountingSemaphoreAwaiter<1>;
 
-  CountingSemaphore(std::optional<bool> ready = std::nullopt) : _mtx(), _ready(ready), _cb() {}
+  CountingSemaphore(std::optional<bool> ready = std::nullopt)
+      : _state(ready ? value(*ready) : impl_semaphore::EMPTY) {}
   CountingSemaphore(const CountingSemaphore &) = delete;
   CountingSemaphore(CountingSemaphore &&) = delete;
   CountingSemaphore &operator=(const CountingSemaphore &) = delete;
   CountingSemaphore &operator=(CountingSemaphore &&) = delete;
   ~CountingSemaphore() {}
 
-  CountingSemaphoreAwaiter<1> operator co_await() {
-    return CountingSemaphoreAwaiter<1>(_mtx, _ready, _cb);
-  }
-
+  CountingSemaphoreAwaiter<1> operator co_await() { return CountingSemaphoreAwaiter<1>(_state); }
+  /**
+   * @brief set the value and resume the waiter if any, the last value wins if not consumed yet
+   *
+   * @param ready the value
+   */
   void release(bool ready = true) {
     LOG6("semaphore release {}", ready);
-    this->_mtx.lock();
-    this->_ready = ready;
-    if (this->_cb) {
-      auto cb = std::exchange(this->_cb, std::nullopt);
-      (*cb)();
-    } else {
-      this->_mtx.unlock();
+    auto old = this->_state.exchange(value(ready), std::memory_order_acq_rel);
+    if (old >= impl_semaphore::STATE_LIMIT) {
+      auto awaiter = reinterpret_cast<CountingSemaphoreAwaiter<1> *>(old);
+      awaiter->_callback(awaiter->_context);
     }
   }
+  /**
+   * @brief cancel the wait, the waiter if any is resumed with false
+   *
+   * @note a pending value is kept, otherwise the next wait resumes with false at once until
+   * clear_cancel is called
+   */
+  void cancel() {
+    LOG6("semaphore cancel");
+    auto old = this->_state.load(std::memory_order_acquire);
+    do {
+      if (old == impl_semaphore::READY_FALSE || old == impl_semaphore::READY_TRUE) {
+        return;
+      }
+    } while (!this->_state.compare_exchange_weak(old, impl_semaphore::CANCELLED,
+                                                 std::memory_order_acq_rel,
+                                                 std::memory_order_acquire));
+    if (old >= impl_semaphore::STATE_LIMIT) {
+      auto awaiter = reinterpret_cast<CountingSemaphoreAwaiter<1> *>(old);
+      awaiter->_callback(awaiter->_context);
+    }
+  }
+  /**
+   * @brief clear the cancellation not consumed by a wait
+   *
+   */
+  void clear_cancel() noexcept {
+    auto expected = impl_semaphore::CANCELLED;
+    this->_state.compare_exchange_strong(expected, impl_semaphore::EMPTY,
+                                         std::memory_order_acq_rel, std::memory_order_relaxed);
+  }
+};
+/**
+ * @brief cancel the waits on the semaphore once the stop is requested, while the guard is alive
+ *
+ * @note nothing is registered if the token can never be stopped. The callback runs on the thread
+ * requesting the stop, the destructor waits for it if it is running on another thread
+ */
+class StopGuard {
+  class Cancel {
+  public:
+    Cancel(CountingSemaphore<1> &sem) : _sem(sem) {}
+
+    void operator()() { this->_sem.cancel(); }
+
+  private:
+    CountingSemaphore<1> &_sem;
+  };
+
+public:
+  StopGuard(CountingSemaphore<1> &sem, const std::stop_token &token) : _sem(sem), _callback() {
+    if (token.stop_possible()) {
+      this->_callback.emplace(token, Cancel{sem});
+    }
+  }
+  StopGuard(const StopGuard &) = delete;
+  StopGuard &operator=(const StopGuard &) = delete;
+  ~StopGuard() {
+    if (this->_callback) {
+      this->_callback.reset();
+      this->_sem.clear_cancel();
+    }
+  }
+
+private:
+  CountingSemaphore<1> &_sem;
+  std::optional<std::stop_callback<Cancel>> _callback;
 };
 XSL_CORO_NE
 #endif
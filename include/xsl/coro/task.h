@@ -24,7 +24,7 @@ public:
   using typename Base::result_type;
 
   using Base::Base;
-  bool await_ready() const { return _handle.done(); }
+  bool await_ready() const { return _handle.promise().done(); }
 
 protected:
   using Base::_handle;
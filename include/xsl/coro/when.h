@@ -0,0 +1,422 @@
+#pragma once
+#ifndef XSL_CORO_WHEN
+#  define XSL_CORO_WHEN
+#  include "xsl/coro/await.h"
+#  include "xsl/coro/def.h"
+#  include "xsl/coro/detach.h"
+#  include "xsl/coro/executor.h"
+#  include "xsl/coro/lazy.h"
+
+#  include <atomic>
+#  include <concepts>
+#  include <coroutine>
+#  include <cstddef>
+#  include <exception>
+#  include <functional>
+#  include <memory>
+#  include <optional>
+#  include <ranges>
+#  include <stdexcept>
+#  include <stop_token>
+#  include <tuple>
+#  include <type_traits>
+#  include <utility>
+#  include <variant>
+#  include <vector>
+XSL_CORO_NB
+namespace impl_when {
+  using resume_type = void (*)(std::coroutine_handle<>);
+
+  template <class Promise>
+  void resume(std::coroutine_handle<> handle) {
+    auto h = std::coroutine_handle<Promise>::from_address(handle.address());
+    h.promise().resume(h);
+  }
+
+  /// @brief the awaitable of the child of when_any, made by the factory taking the stop token if so
+  template <class Child>
+  using awaitable_t = typename std::conditional_t<std::invocable<Child, std::stop_token>,
+                                                  std::invoke_result<Child, std::stop_token>,
+                                                  std::type_identity<Child>>::type;
+
+  template <class Awaitable>
+  using result_t = typename awaiter_traits<std::decay_t<Awaitable>>::result_type;
+  /// @brief the result of a void awaitable is std::monostate, so it can be stored
+  template <class T>
+  using value_t = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+  /**
+   * @brief the counter of the unfinished children plus the awaiting coroutine, the last one to
+   * count down resumes the awaiting coroutine
+   *
+   */
+  class Latch {
+  public:
+    using executor_type = void;
+
+    class Awaiter {
+    public:
+      using executor_type = void;
+
+      Awaiter(Latch &latch) : _latch(latch) {}
+
+      bool await_ready() const noexcept { return false; }
+
+      template <class Promise>
+      bool await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+        this->_latch._handle = handle;
+        this->_latch._resume = &resume<Promise>;
+        // the children may all be done already
+        return this->_latch._count.fetch_sub(1, std::memory_order_acq_rel) != 1;
+      }
+
+      void await_resume() const noexcept {}
+
+    private:
+      Latch &_latch;
+    };
+
+    explicit Latch(std::size_t count) : _count(count + 1), _handle(), _resume(nullptr) {}
+
+    Awaiter operator co_await() { return Awaiter{*this}; }
+
+    void count_down() {
+      if (this->_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        this->_resume(this->_handle);
+      }
+    }
+
+  private:
+    std::atomic_size_t _count;
+    std::coroutine_handle<> _handle;
+    resume_type _resume;
+  };
+  /**
+   * @brief run the awaitable and hand its result to the sink
+   *
+   * @note the frame destroys itself at the end, the exception of the awaitable is handed over too
+   */
+  template <class Awaitable, class Sink>
+  Detach<void> run(Awaitable awaitable, Sink sink) {
+    using result_type = result_t<Awaitable>;
+    std::optional<value_t<result_type>> value;
+    std::exception_ptr error;
+    try {
+      if constexpr (std::is_void_v<result_type>) {
+        co_await std::move(awaitable);
+        value.emplace();
+      } else {
+        value.emplace(co_await std::move(awaitable));
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+    if (error) {
+      sink.fail(std::move(error));
+    } else {
+      sink.set(std::move(*value));
+    }
+  }
+  /**
+   * @brief bind the awaitable to the executor of the caller, as await_transform does
+   *
+   */
+  template <class Executor, class Awaitable>
+  decltype(auto) bind(Awaitable &&awaitable, const std::shared_ptr<Executor> &executor) {
+    if constexpr (requires { awaitable.by(executor); }) {
+      if (executor) {
+        awaitable.by(executor);
+      }
+    }
+    return std::forward<Awaitable>(awaitable);
+  }
+  /**
+   * @brief make the awaitable of the child of when_any, handing the stop token to its factory
+   *
+   */
+  template <class Child>
+  decltype(auto) make(Child &&child, std::stop_token token) {
+    if constexpr (std::invocable<Child, std::stop_token>) {
+      return std::invoke(std::forward<Child>(child), std::move(token));
+    } else {
+      return std::forward<Child>(child);
+    }
+  }
+  /**
+   * @brief the state of when_all, lives in the frame of when_all
+   *
+   */
+  template <class Results>
+  class AllState {
+  public:
+    AllState(std::size_t count, Results &&results)
+        : latch(count), results(std::move(results)), _failed(false), _error() {}
+
+    template <std::size_t Index>
+    class TupleSink {
+    public:
+      TupleSink(AllState &state) : _state(&state) {}
+
+      template <class T>
+      void set(T &&value) {
+        std::get<Index>(this->_state->results).emplace(std::forward<T>(value));
+        this->_state->latch.count_down();
+      }
+
+      void fail(std::exception_ptr error) { this->_state->fail(std::move(error)); }
+
+    private:
+      AllState *_state;
+    };
+
+    class IndexSink {
+    public:
+      IndexSink(AllState &state, std::size_t index) : _state(&state), _index(index) {}
+
+      template <class T>
+      void set(T &&value) {
+        this->_state->results[this->_index].emplace(std::forward<T>(value));
+        this->_state->latch.count_down();
+      }
+
+      void fail(std::exception_ptr error) { this->_state->fail(std::move(error)); }
+
+    private:
+      AllState *_state;
+      std::size_t _index;
+    };
+
+    void fail(std::exception_ptr error) {
+      // the first error wins, it is read after the latch so no lock is needed
+      if (!this->_failed.exchange(true, std::memory_order_relaxed)) {
+        this->_error = std::move(error);
+      }
+      this->latch.count_down();
+    }
+
+    void rethrow() {
+      if (this->_error) {
+        std::rethrow_exception(this->_error);
+      }
+    }
+
+    Latch latch;
+    Results results;
+
+  private:
+    std::atomic_bool _failed;
+    std::exception_ptr _error;
+  };
+  /**
+   * @brief the state of when_any, shared by when_any and the children, since the losers may
+   * outlive it
+   *
+   * @note the stop is requested once the first child finishes, so the losers observing the token
+   * are cancelled
+   */
+  template <class Result>
+  class AnyState {
+  public:
+    AnyState() : latch(1), result(), error(), _won(false), _stop() {}
+    /**
+     * @brief the sink of a variadic when_any, the index is the index of the variant
+     *
+     */
+    template <std::size_t Index>
+    class TupleSink {
+    public:
+      TupleSink(std::shared_ptr<AnyState> state) : _state(std::move(state)) {}
+
+      template <class T>
+      void set(T &&value) {
+        if (this->_state->win()) {
+          this->_state->result.emplace(std::in_place_index<Index>, std::forward<T>(value));
+          this->_state->finish();
+        }
+      }
+
+      void fail(std::exception_ptr error) { this->_state->fail(std::move(error)); }
+
+    private:
+      std::shared_ptr<AnyState> _state;
+    };
+
+    class IndexSink {
+    public:
+      IndexSink(std::shared_ptr<AnyState> state, std::size_t index)
+          : _state(std::move(state)), _index(index) {}
+
+      template <class T>
+      void set(T &&value) {
+        if (this->_state->win()) {
+          this->_state->result.emplace(this->_index, std::forward<T>(value));
+          this->_state->finish();
+        }
+      }
+
+      void fail(std::exception_ptr error) { this->_state->fail(std::move(error)); }
+
+    private:
+      std::shared_ptr<AnyState> _state;
+      std::size_t _index;
+    };
+
+    void fail(std::exception_ptr error) {
+      if (this->win()) {
+        this->error = std::move(error);
+        this->finish();
+      }
+    }
+    /// @brief the token handed to the children
+    std::stop_token token() const noexcept { return this->_stop.get_token(); }
+
+    Latch latch;
+    std::optional<Result> result;
+    std::exception_ptr error;
+
+  private:
+    std::atomic_bool _won;
+    std::stop_source _stop;
+
+    bool win() { return !this->_won.exchange(true, std::memory_order_acq_rel); }
+
+    void finish() {
+      // the losers are cancelled before when_any is resumed
+      this->_stop.request_stop();
+      this->latch.count_down();
+    }
+  };
+
+  template <class Range>
+  using range_result_t = result_t<std::ranges::range_value_t<Range>>;
+
+  template <class Range>
+  using any_range_result_t = result_t<awaitable_t<std::ranges::range_value_t<Range>>>;
+}  // namespace impl_when
+
+/**
+ * @brief await all the awaitables concurrently
+ *
+ * @note every awaitable is started at once, on the executor of when_all if it has one, as it would
+ * be when awaited directly. The results are stored in the frame of when_all, so the only other
+ * allocations are the small frames driving the awaitables, which come from the frame cache
+ * @tparam Executor the executor type, default is ExecutorBase
+ * @param awaitables the awaitables, such as Task or Lazy
+ * @return Lazy<std::tuple<...>, Executor> the results in order, std::monostate for void, the first
+ * exception is rethrown after all are done
+ */
+template <class Executor = ExecutorBase, class... Awaitables>
+  requires(!std::ranges::range<Awaitables> && ...)
+Lazy<std::tuple<impl_when::value_t<impl_when::result_t<Awaitables>>...>, Executor> when_all(
+    Awaitables... awaitables) {
+  using results_type
+      = std::tuple<std::optional<impl_when::value_t<impl_when::result_t<Awaitables>>>...>;
+  using state_type = impl_when::AllState<results_type>;
+  auto executor = co_await GetExecutor<Executor>();
+  state_type state{sizeof...(Awaitables), results_type{}};
+  [&]<std::size_t... Index>(std::index_sequence<Index...>) {
+    (impl_when::run(impl_when::bind(std::move(awaitables), executor),
+                    typename state_type::template TupleSink<Index>{state}),
+     ...);
+  }(std::index_sequence_for<Awaitables...>{});
+  co_await state.latch;
+  state.rethrow();
+  co_return std::apply(
+      [](auto &&...results) { return std::make_tuple(std::move(*results)...); }, state.results);
+}
+/**
+ * @brief await all the awaitables in the range concurrently
+ *
+ * @tparam Executor the executor type, default is ExecutorBase
+ * @param awaitables the range of awaitables, moved from
+ * @return Lazy<std::vector<...>, Executor> the results in order, std::monostate for void
+ */
+template <class Executor = ExecutorBase, std::ranges::sized_range Range>
+Lazy<std::vector<impl_when::value_t<impl_when::range_result_t<Range>>>, Executor> when_all(
+    Range awaitables) {
+  using value_type = impl_when::value_t<impl_when::range_result_t<Range>>;
+  using results_type = std::vector<std::optional<value_type>>;
+  using state_type = impl_when::AllState<results_type>;
+  auto executor = co_await GetExecutor<Executor>();
+  auto count = std::ranges::size(awaitables);
+  state_type state{count, results_type(count)};
+  std::size_t index = 0;
+  for (auto &&awaitable : awaitables) {
+    impl_when::run(impl_when::bind(std::move(awaitable), executor),
+                   typename state_type::IndexSink{state, index++});
+  }
+  co_await state.latch;
+  state.rethrow();
+  std::vector<value_type> values;
+  values.reserve(count);
+  for (auto &result : state.results) {
+    values.push_back(std::move(*result));
+  }
+  co_return values;
+}
+/**
+ * @brief await the first of the children to finish
+ *
+ * @note a child is an awaitable, or a factory taking a std::stop_token and returning the
+ * awaitable. The stop is requested once the first child finishes, so the losers observing the
+ * token are cancelled. Otherwise the losers keep running in the background and their results are
+ * dropped, so they must not refer to the frame of the caller
+ * @tparam Executor the executor type, default is ExecutorBase
+ * @param children the children, at least one
+ * @return Lazy<std::variant<...>, Executor> the result of the winner, its index is the index of
+ * the variant, the exception of the winner is rethrown
+ */
+template <class Executor = ExecutorBase, class... Children>
+  requires(sizeof...(Children) > 0 && (!std::ranges::range<Children> && ...))
+Lazy<std::variant<impl_when::value_t<impl_when::result_t<impl_when::awaitable_t<Children>>>...>,
+     Executor>
+when_any(Children... children) {
+  using result_type
+      = std::variant<impl_when::value_t<impl_when::result_t<impl_when::awaitable_t<Children>>>...>;
+  using state_type = impl_when::AnyState<result_type>;
+  auto executor = co_await GetExecutor<Executor>();
+  auto state = std::make_shared<state_type>();
+  [&]<std::size_t... Index>(std::index_sequence<Index...>) {
+    (impl_when::run(
+         impl_when::bind(impl_when::make(std::move(children), state->token()), executor),
+         typename state_type::template TupleSink<Index>{state}),
+     ...);
+  }(std::index_sequence_for<Children...>{});
+  co_await state->latch;
+  if (state->error) {
+    std::rethrow_exception(state->error);
+  }
+  co_return std::move(*state->result);
+}
+/**
+ * @brief await the first of the children in the range to finish
+ *
+ * @note the children are as those of the variadic when_any
+ * @tparam Executor the executor type, default is ExecutorBase
+ * @param children the range of children, moved from
+ * @return Lazy<std::pair<std::size_t, ...>, Executor> the index and the result of the winner
+ * @throw std::invalid_argument if the range is empty, since it would never finish
+ */
+template <class Executor = ExecutorBase, std::ranges::sized_range Range>
+Lazy<std::pair<std::size_t, impl_when::value_t<impl_when::any_range_result_t<Range>>>, Executor>
+when_any(Range children) {
+  using result_type
+      = std::pair<std::size_t, impl_when::value_t<impl_when::any_range_result_t<Range>>>;
+  using state_type = impl_when::AnyState<result_type>;
+  if (std::ranges::empty(children)) {
+    throw std::invalid_argument("when_any of an empty range never finishes");
+  }
+  auto executor = co_await GetExecutor<Executor>();
+  auto state = std::make_shared<state_type>();
+  std::size_t index = 0;
+  for (auto &&child : children) {
+    impl_when::run(impl_when::bind(impl_when::make(std::move(child), state->token()), executor),
+                   typename state_type::IndexSink{state, index++});
+  }
+  co_await state->latch;
+  if (state->error) {
+    std::rethrow_exception(state->error);
+  }
+  co_return std::move(*state->result);
+}
+XSL_CORO_NE
+#endif
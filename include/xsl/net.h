@@ -18,6 +18,7 @@ namespace net {
   // using net::HttpServer;
 }  // namespace net
 namespace tcp {
+  using xsl::_net::ReusePortSteering;
 
   template <class LowerLayer>
   using Server = xsl::_net::TcpServer<LowerLayer>;
@@ -31,16 +32,26 @@ namespace tcp {
   decltype(auto) serv(const char *host, const char *port) {
     return xsl::_net::tcp_serv<Flags...>(host, port);
   };
+
+  template <class... Flags>
+  decltype(auto) serv(const char *host, const char *port, std::span<const int> cpus,
+                      ReusePortSteering steering) {
+    return xsl::_net::tcp_serv<Flags...>(host, port, cpus, steering);
+  };
 }  // namespace tcp
 
 namespace http {
   using xsl::_net::http::create_static_handler;
   using xsl::_net::http::HandleContext;
   using xsl::_net::http::HandleResult;
+  using xsl::_net::http::HeaderMap;
+  using xsl::_net::http::HeaderName;
+  using xsl::_net::http::HTTP_HEADER_NAME_COUNT;
   using xsl::_net::http::Method;
   using xsl::_net::http::ParseData;
   using xsl::_net::http::Parser;
   using xsl::_net::http::ParseUnit;
+  using xsl::_net::http::QueryView;
   using xsl::_net::http::Request;
   using xsl::_net::http::RequestView;
   using xsl::_net::http::Response;
@@ -51,6 +62,8 @@ namespace http {
   using xsl::_net::http::ServerBuilder;
   using xsl::_net::http::StaticFileConfig;
   using xsl::_net::http::Status;
+  using xsl::_net::http::to_reason_phrase;
+  using xsl::_net::http::to_status_line;
   using xsl::_net::http::to_string_view;
   using xsl::_net::http::Version;
   using xsl::_net::io::splice;
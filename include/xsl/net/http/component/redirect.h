@@ -14,7 +14,7 @@ template <ai::AsyncReadDeviceLike<std::byte> ByteReader,
 Handler<ByteReader, ByteWriter> create_redirect_handler(std::string_view path) {
   return [path](HandleContext<ByteReader, ByteWriter>& ctx) -> HandleResult {
     ResponsePart part{Status::MOVED_PERMANENTLY};
-    part.headers.emplace("Location", std::string(path));
+    part.headers.emplace(HeaderName::LOCATION, std::string(path));
     ctx.resp(std::move(part));
     co_return std::nullopt;
   };
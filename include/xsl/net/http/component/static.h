@@ -11,6 +11,7 @@
 #  include "xsl/net/http/proto/accept.h"
 #  include "xsl/net/http/proto/media-type.h"
 #  include "xsl/sys/net/io.h"
+#  include "xsl/sys/net/uring.h"
 #  include "xsl/wheel/vec.h"
 
 #  include <algorithm>
@@ -33,12 +34,19 @@ struct StaticFileConfig {
       : StaticFileConfig(std::move(path), std::move(compress_encodings), true) {}
   StaticFileConfig(std::filesystem::path path,
                    wheel::FixedVector<std::string_view> compress_encodings, bool compress)
+      : StaticFileConfig(std::move(path), std::move(compress_encodings), compress,
+                         sys::net::Coalesce::MORE) {}
+  StaticFileConfig(std::filesystem::path path,
+                   wheel::FixedVector<std::string_view> compress_encodings, bool compress,
+                   sys::net::Coalesce coalesce)
       : path(std::move(path)),
         compress_encodings(std::move(compress_encodings)),
-        compress(compress) {}
+        compress(compress),
+        coalesce(coalesce) {}
   std::filesystem::path path;
   wheel::FixedVector<std::string_view> compress_encodings;
   bool compress;
+  sys::net::Coalesce coalesce = sys::net::Coalesce::MORE;  ///< how the header meets the file
 };
 template <ai::AsyncReadDeviceLike<std::byte> ByteReader,
           ai::AsyncWriteDeviceLike<std::byte> ByteWriter>
@@ -87,7 +95,7 @@ public:
           DEBUG("try_sendfile: path: {} encoding: {}", path.native(), encoding);
           path = path.replace_extension();
           if (!try_sendfile_res) {
-            ctx._response->_part.headers.emplace("Content-Encoding", encoding);
+            ctx._response->_part.headers.emplace(HeaderName::CONTENT_ENCODING, encoding);
             return std::nullopt;
           }
           DEBUG("try_sendfile failed: path: {} error: {}", path.native(),
@@ -124,14 +132,16 @@ protected:
       return Status::INTERNAL_SERVER_ERROR;
     }
     ResponsePart part{Status::OK};
-    part.headers.emplace("Content-Length", std::to_string(file_size));
-    part.headers.emplace("Last-Modified", to_date_string(last_modified));
-    part.headers.emplace("Content-Type", content_type.to_string());
+    part.content_length = file_size;
+    part.headers.emplace(HeaderName::LAST_MODIFIED, to_date_string(last_modified));
+    part.headers.emplace(HeaderName::CONTENT_TYPE, content_type.to_string());
 
     auto send_file = [hint = sys::net::SendfileHint{path.native(), 0, file_size}](ByteWriter& awd) {
-      return sys::net::immediate_sendfile(awd, std::move(hint));
+      return sys::net::sendfile(awd, std::move(hint));
     };
     ctx.resp(std::move(part), std::move(send_file));
+    // the header is held back and goes out with the first segment of the file
+    ctx._response->_coalesce = this->cfg.coalesce;
     return std::nullopt;
   }
 };
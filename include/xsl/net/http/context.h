@@ -8,6 +8,7 @@
 
 #  include <chrono>
 #  include <optional>
+#  include <string>
 XSL_HTTP_NB
 template <ai::AsyncReadDeviceLike<std::byte> ByteReader,
           ai::AsyncWriteDeviceLike<std::byte> ByteWriter>
@@ -34,10 +35,9 @@ public:
   template <class... Args>
     requires std::constructible_from<std::string, Args...>
   void easy_resp(Status status_code, Args&&... args) {
-    this->_response = Response<ByteWriter>{
-        {Version::HTTP_1_1, status_code, to_reason_phrase(status_code)},
-        [body = std::string(std::forward<Args>(args)...)](ByteWriter& awd)
-            -> coro::Task<ai::Result> { return awd.write(std::as_bytes(std::span(body))); }};
+    this->_response
+        = Response<ByteWriter>{{Version::HTTP_1_1, status_code, to_reason_phrase(status_code)},
+                               std::string(std::forward<Args>(args)...)};
   }
 
   void resp(ResponsePart&& part) { this->_response = Response<ByteWriter>{std::move(part)}; }
@@ -50,11 +50,17 @@ public:
   template <class... Args>
     requires std::constructible_from<std::string, Args...>
   void resp(ResponsePart&& part, Args&&... args) {
-    this->_response = Response<ByteWriter>{{std::move(part)},
-                                           [body = std::string(std::forward<Args>(args)...)](
-                                               ByteWriter& awd) -> coro::Task<ai::Result> {
-                                             return awd.write(std::as_bytes(std::span(body)));
-                                           }};
+    this->_response
+        = Response<ByteWriter>{{std::move(part)}, std::string(std::forward<Args>(args)...)};
+  }
+  /**
+   * @brief respond with the blocks of the buffer as the body
+   *
+   * @param part the response part
+   * @param body the body, gathered with the header if the writer supports gather writes
+   */
+  void resp(ResponsePart&& part, io::Buffer<>&& body) {
+    this->_response = Response<ByteWriter>{{std::move(part)}, std::move(body)};
   }
 
   coro::Task<ai::Result> sendto(ByteWriter& awd) {
@@ -64,6 +70,20 @@ public:
     this->check_and_add_date();
     return this->_response->sendto(awd);
   }
+  /**
+   * @brief send the response, the header is serialized into the buffer
+   *
+   * @param awd the writer
+   * @param out the output buffer kept by the connection
+   * @return coro::Task<ai::Result> the size sent
+   */
+  coro::Task<ai::Result> sendto(ByteWriter& awd, std::string& out) {
+    if (!this->_response) {
+      this->easy_resp(Status::INTERNAL_SERVER_ERROR);
+    }
+    this->check_and_add_date();
+    return this->_response->sendto(awd, out);
+  }
 
   std::string_view current_path;
 
@@ -73,8 +93,9 @@ public:
 
 private:
   void check_and_add_date() {
-    if (!_response->_part.headers.contains("Date")) {
-      _response->_part.headers.emplace("Date", to_date_string(std::chrono::system_clock::now()));
+    if (!_response->_part.headers.contains(HeaderName::DATE)) {
+      _response->_part.headers.emplace(HeaderName::DATE,
+                                       to_date_string(std::chrono::system_clock::now()));
     }
   }
 };
@@ -0,0 +1,166 @@
+#pragma once
+#ifndef XSL_NET_HTTP_HEADER
+#  define XSL_NET_HTTP_HEADER
+#  include "xsl/convert.h"
+#  include "xsl/net/http/def.h"
+#  include "xsl/net/http/proto.h"
+#  include "xsl/net/http/scan.h"
+
+#  include <array>
+#  include <cstddef>
+#  include <string_view>
+#  include <utility>
+#  include <vector>
+XSL_HTTP_NB
+/// @brief the count of the well-known fields kept inline by a HeaderMap
+const std::size_t HEADER_INLINE_CAPACITY = 16;
+/**
+ * @brief the fields of a message
+ *
+ * @note the well-known fields are kept inline by their HeaderName, so they are found by comparing
+ * one byte each. The other fields, and the well-known ones beyond the inline capacity, are kept by
+ * their names in the overflow area. The names are compared ignoring the case
+ * @tparam T the type of the values, and of the names in the overflow area, such as
+ * std::string_view for a request and std::string for a response
+ */
+template <class T>
+class HeaderMap {
+public:
+  using value_type = T;
+
+  HeaderMap() : _known_size(0), _known(), _overflow() {}
+  HeaderMap(HeaderMap&&) = default;
+  HeaderMap& operator=(HeaderMap&&) = default;
+  ~HeaderMap() = default;
+  /**
+   * @brief add the field if it is absent
+   *
+   * @param name the name
+   * @param value the value
+   * @return true if added
+   */
+  template <class V>
+  bool emplace(HeaderName name, V&& value) {
+    if (this->find(name) != nullptr) {
+      return false;
+    }
+    this->add(name, std::forward<V>(value));
+    return true;
+  }
+  template <class V>
+  bool emplace(std::string_view name, V&& value) {
+    if (auto id = xsl::from_string_view<HeaderName>(name); id != HeaderName::EXT) {
+      return this->emplace(id, std::forward<V>(value));
+    }
+    if (this->find_overflow(name) != nullptr) {
+      return false;
+    }
+    this->_overflow.emplace_back(T(name), T(std::forward<V>(value)));
+    return true;
+  }
+  /**
+   * @brief set the field, the value present is replaced
+   *
+   * @param name the name
+   * @param value the value
+   */
+  template <class V>
+  void set(HeaderName name, V&& value) {
+    if (auto old = this->find(name); old != nullptr) {
+      *old = T(std::forward<V>(value));
+    } else {
+      this->add(name, std::forward<V>(value));
+    }
+  }
+  template <class V>
+  void set(std::string_view name, V&& value) {
+    if (auto id = xsl::from_string_view<HeaderName>(name); id != HeaderName::EXT) {
+      this->set(id, std::forward<V>(value));
+    } else if (auto old = this->find_overflow(name); old != nullptr) {
+      *old = T(std::forward<V>(value));
+    } else {
+      this->_overflow.emplace_back(T(name), T(std::forward<V>(value)));
+    }
+  }
+  /**
+   * @brief find the value of the field
+   *
+   * @param name the name
+   * @return T* the value, nullptr if absent
+   */
+  T* find(HeaderName name) noexcept {
+    for (std::size_t i = 0; i < this->_known_size; ++i) {
+      if (this->_known[i].first == name) {
+        return &this->_known[i].second;
+      }
+    }
+    if (this->_known_size == HEADER_INLINE_CAPACITY) {
+      return this->find_overflow(to_string_view(name));
+    }
+    return nullptr;
+  }
+  const T* find(HeaderName name) const noexcept {
+    return const_cast<HeaderMap*>(this)->find(name);
+  }
+  T* find(std::string_view name) noexcept {
+    if (auto id = xsl::from_string_view<HeaderName>(name); id != HeaderName::EXT) {
+      return this->find(id);
+    }
+    return this->find_overflow(name);
+  }
+  const T* find(std::string_view name) const noexcept {
+    return const_cast<HeaderMap*>(this)->find(name);
+  }
+
+  bool contains(HeaderName name) const noexcept { return this->find(name) != nullptr; }
+
+  bool contains(std::string_view name) const noexcept { return this->find(name) != nullptr; }
+
+  std::size_t size() const noexcept { return this->_known_size + this->_overflow.size(); }
+
+  bool empty() const noexcept { return this->size() == 0; }
+
+  void clear() noexcept {
+    this->_known_size = 0;
+    this->_overflow.clear();
+  }
+  /**
+   * @brief visit the fields, the well-known ones first
+   *
+   * @param f the visitor, called with the name as std::string_view and the value
+   */
+  template <class F>
+  void for_each(F&& f) const {
+    for (std::size_t i = 0; i < this->_known_size; ++i) {
+      f(to_string_view(this->_known[i].first), this->_known[i].second);
+    }
+    for (const auto& [name, value] : this->_overflow) {
+      f(std::string_view(name), value);
+    }
+  }
+
+private:
+  std::size_t _known_size;
+  std::array<std::pair<HeaderName, T>, HEADER_INLINE_CAPACITY> _known;
+  std::vector<std::pair<T, T>> _overflow;
+
+  template <class V>
+  void add(HeaderName name, V&& value) {
+    if (this->_known_size < HEADER_INLINE_CAPACITY) {
+      this->_known[this->_known_size++] = {name, T(std::forward<V>(value))};
+    } else {
+      this->_overflow.emplace_back(T(to_string_view(name)), T(std::forward<V>(value)));
+    }
+  }
+
+  T* find_overflow(std::string_view name) noexcept {
+    for (auto& [key, value] : this->_overflow) {
+      if (iequal(key, name)) {
+        return &value;
+      }
+    }
+    return nullptr;
+  }
+};
+XSL_HTTP_NE
+#endif
@@ -5,16 +5,25 @@
 #  include "xsl/ai/dev.h"
 #  include "xsl/coro.h"
 #  include "xsl/net/http/def.h"
+#  include "xsl/net/http/header.h"
 #  include "xsl/net/http/proto.h"
+#  include "xsl/net/http/query.h"
 #  include "xsl/net/io/buffer.h"
+#  include "xsl/sys/net/io.h"
 #  include "xsl/wheel.h"
 
+#  include <sys/uio.h>
+
+#  include <array>
+#  include <concepts>
 #  include <cstddef>
 #  include <functional>
 #  include <optional>
+#  include <string>
 #  include <string_view>
 #  include <tuple>
 #  include <utility>
+#  include <variant>
 XSL_HTTP_NB
 
 class ResponseError {
@@ -41,37 +50,183 @@ public:
   Status status_code;
   std::string_view status_message;
   Version version;
-  us_map<std::string> headers;
+  HeaderMap<std::string> headers;
+  std::optional<std::size_t> content_length;  ///< sent unless Content-Length is in the headers
+  /**
+   * @brief append the header to the buffer
+   *
+   * @note the status line with the default reason phrase and the Server field are copied from
+   * the prepared ones, and the content length is formatted in place, so a buffer reused by the
+   * connection is not allocated again
+   * @param out the buffer
+   */
+  void serialize(std::string& out) const;
   std::string to_string();
 };
 
 template <ai::AsyncWriteDeviceLike<std::byte> ByteWriter>
 class Response {
 public:
+  using body_type = std::function<coro::Task<ai::Result>(ByteWriter&)>;
+  /// @brief the body known before sending, it can be gathered with the header
+  using content_type = std::variant<std::monostate, std::string, io::Buffer<>>;
+
   template <class... Args>
+    requires std::constructible_from<body_type, Args...>
   Response(ResponsePart&& part, Args&&... args)
-      : _part(std::move(part)), _body(std::forward<Args>(args)...) {}
+      : _part(std::move(part)),
+        _content(),
+        _body(std::forward<Args>(args)...),
+        _coalesce(sys::net::Coalesce::NONE) {}
+  Response(ResponsePart&& part, std::string&& content)
+      : _part(std::move(part)),
+        _content(std::move(content)),
+        _body(),
+        _coalesce(sys::net::Coalesce::NONE) {}
+  Response(ResponsePart&& part, io::Buffer<>&& content)
+      : _part(std::move(part)),
+        _content(std::move(content)),
+        _body(),
+        _coalesce(sys::net::Coalesce::NONE) {}
   Response(Response&&) = default;
   Response& operator=(Response&&) = default;
   ~Response() {}
+  /**
+   * @brief send the response
+   *
+   * @tparam Executor default is coro::ExecutorBase
+   * @param awd the writer
+   * @return coro::Task<ai::Result, Executor> the size sent
+   */
   template <class Executor = coro::ExecutorBase>
   coro::Task<ai::Result, Executor> sendto(ByteWriter& awd) {
-    auto str = this->_part.to_string();
-    auto [sz, err] = co_await awd.template write<Executor>(std::as_bytes(std::span(str)));
+    std::string out;
+    co_return co_await this->sendto<Executor>(awd, out);
+  }
+  /**
+   * @brief send the response, the header is serialized into the buffer
+   *
+   * @note if the writer supports gather writes, the header and the known content are sent by one
+   * gather write, unless the content is large enough for the zero copy sends of the writer,
+   * otherwise they are written one by one. A body sent by the callback is coalesced with the
+   * header as _coalesce tells, if the writer is a socket
+   * @tparam Executor default is coro::ExecutorBase
+   * @param awd the writer
+   * @param out the buffer kept by the connection, it is cleared first
+   * @return coro::Task<ai::Result, Executor> the size sent
+   */
+  template <class Executor = coro::ExecutorBase>
+  coro::Task<ai::Result, Executor> sendto(ByteWriter& awd, std::string& out) {
+    if (!this->_part.content_length) {
+      this->_part.content_length = this->content_size();
+    }
+    out.clear();
+    this->_part.serialize(out);
+    auto header = std::as_bytes(std::span(out));
+    // a content sent by zero copy is sent by itself, rather than gathered with the header
+    if constexpr (sys::net::AsyncWritevDeviceLike<ByteWriter>) {
+      if (!this->zerocopy_content(awd)) {
+        if (auto content = std::get_if<std::string>(&this->_content)) {
+          auto data = std::as_bytes(std::span(*content));
+          std::array<iovec, 2> iov{{{const_cast<std::byte*>(header.data()), header.size()},
+                                    {const_cast<std::byte*>(data.data()), data.size()}}};
+          co_return co_await awd.write(std::span<const iovec>(iov));
+        }
+        if (auto content = std::get_if<io::Buffer<>>(&this->_content)) {
+          co_return co_await content->write(awd, header);
+        }
+      }
+    }
+    if constexpr (sys::net::AsyncSendDeviceLike<ByteWriter>) {
+      // an empty body sends nothing that pushes the header held back
+      if (this->_body && this->_coalesce != sys::net::Coalesce::NONE
+          && this->_part.content_length != 0) {
+        co_return co_await this->coalesce_to(awd, header);
+      }
+    }
+    auto [sz, err] = co_await awd.template write<Executor>(header);
     if (err) {
       co_return std::make_tuple(sz, err);
     };
-    if (!_body) {
-      co_return std::make_tuple(sz, std::nullopt);
-    }
-    auto [bodySize, bodyError] = co_await this->_body(awd);
+    auto [bodySize, bodyError] = co_await this->write_body(awd);
     if (bodyError) {
       co_return std::make_tuple(sz + bodySize, bodyError);
     }
     co_return std::make_tuple(sz + bodySize, std::nullopt);
   }
   ResponsePart _part;
-  std::function<coro::Task<ai::Result>(ByteWriter&)> _body;
+  content_type _content;
+  body_type _body;
+  sys::net::Coalesce _coalesce;  ///< how the header is coalesced with the body of the callback
+
+private:
+  /// @brief the size of the body if known before sending, no body is empty
+  std::optional<std::size_t> content_size() const {
+    if (auto content = std::get_if<std::string>(&this->_content)) {
+      return content->size();
+    }
+    if (auto content = std::get_if<io::Buffer<>>(&this->_content)) {
+      std::size_t size = 0;
+      for (auto& block : content->_blocks) {
+        size += block.valid_size;
+      }
+      return size;
+    }
+    if (!this->_body) {
+      return 0;
+    }
+    return std::nullopt;
+  }
+  /// @brief whether the known content is large enough for the zero copy sends of the writer
+  bool zerocopy_content(ByteWriter& awd) {
+    if constexpr (requires { awd.zerocopy(); }) {
+      return awd.zerocopy() != 0 && this->content_size().value_or(0) >= awd.zerocopy();
+    }
+    return false;
+  }
+
+  coro::Task<ai::Result> coalesce_to(ByteWriter& awd, std::span<const std::byte> header) {
+    // the header is pushed on every exit, by the uncork or by the push unless the body sent it
+    std::optional<sys::net::TcpCork> cork;
+    std::optional<sys::net::TcpPush> push;
+    int flags = 0;
+    if (this->_coalesce == sys::net::Coalesce::CORK) {
+      cork.emplace(awd.raw());
+    } else {
+      push.emplace(awd.raw());
+      flags = MSG_MORE;
+    }
+    auto [sz, err] = co_await awd.send(header, {}, flags);
+    if (err) {
+      co_return std::make_tuple(sz, err);
+    }
+    auto [bodySize, bodyError] = co_await this->_body(awd);
+    if (push && !bodyError && bodySize != 0) {
+      push->release();
+    }
+    co_return std::make_tuple(sz + bodySize, bodyError);
+  }
+
+  coro::Task<ai::Result> write_body(ByteWriter& awd) {
+    if (auto content = std::get_if<std::string>(&this->_content)) {
+      co_return co_await awd.write(std::as_bytes(std::span(*content)));
+    }
+    if (auto content = std::get_if<io::Buffer<>>(&this->_content)) {
+      std::size_t total_size = 0;
+      for (auto& block : content->_blocks) {
+        auto [size, err] = co_await awd.write(block.span());
+        total_size += size;
+        if (err) {
+          co_return std::make_tuple(total_size, err);
+        }
+      }
+      co_return std::make_tuple(total_size, std::nullopt);
+    }
+    if (!_body) {
+      co_return std::make_tuple(0, std::nullopt);
+    }
+    co_return co_await this->_body(awd);
+  }
 };
 
 class RequestView {
@@ -85,10 +240,10 @@ public:
   std::string_view scheme;
   std::string_view authority;
   std::string_view path;
-  std::unordered_map<std::string_view, std::string_view> query;
+  QueryView query;
 
   std::string_view version;
-  std::unordered_map<std::string_view, std::string_view> headers;
+  HeaderMap<std::string_view> headers;
   std::string to_string();
 
   void clear();
@@ -110,11 +265,10 @@ public:
 
   [[nodiscard]]
   inline std::optional<std::string_view> get_header(std::string_view key) {
-    auto iter = this->view.headers.find(key);
-    if (iter == this->view.headers.end()) {
-      return std::nullopt;
+    if (auto value = this->view.headers.find(key); value != nullptr) {
+      return *value;
     }
-    return iter->second;
+    return std::nullopt;
   }
 
   Method method;
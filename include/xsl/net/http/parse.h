@@ -6,6 +6,7 @@
 #  include "xsl/net/http/def.h"
 #  include "xsl/net/http/msg.h"
 #  include "xsl/net/io/buffer.h"
+#  include "xsl/sys/net/io.h"
 
 #  include <cstddef>
 #  include <expected>
@@ -28,6 +29,8 @@ public:
    @return the parsed request or the error
    @note if the return value is an error and the kind is InvalidFormat, will update the len to the
    last correct position
+   @note if the request is incomplete, the len is the position of the incomplete line. The next
+   call must be given the data from there, the bytes scanned already are not scanned again
    @par Example
    @details
     "GET / HTTP/1.1"
@@ -50,7 +53,13 @@ public:
   void clear();
 
 private:
-  void parse_request_target(std::string_view target);
+  /// @brief the length after the returned position already scanned without a line end
+  /// @note so the next call, given the data from the returned position, resumes the scan there
+  std::size_t _scanned;
+
+  bool parse_request_line(std::string_view line);
+  bool parse_field_line(std::string_view line);
+  bool parse_request_target(std::string_view target);
 };
 
 const std::size_t HTTP_BUFFER_BLOCK_SIZE = 1024;
@@ -80,13 +89,20 @@ public:
   template <class Executor = coro::ExecutorBase, ai::AsyncReadDeviceLike<std::byte> Reader>
   coro::Task<std::expected<void, std::errc>, Executor> read(Reader& reader, ParseData& buf) {
     while (true) {
-      auto [sz, err]
-          = co_await reader.template read<Executor>(this->buffer.front().span(this->used_size));
+      auto span = this->buffer.front().span(this->used_size);
+      ai::Result res;
+      // the awaiter of a native device needs no frame of its own
+      if constexpr (sys::net::AsyncRecvDeviceLike<Reader>) {
+        res = co_await reader.recv(span);
+      } else {
+        res = co_await reader.template read<Executor>(span);
+      }
+      auto [sz, err] = res;
       if (err) {
         co_return std::unexpected{*err};
       }
       this->used_size += sz;
-      auto req = this->parse_request(sz, buf);
+      auto req = this->parse_request(buf);
       if (req || req.error() != std::errc::resource_unavailable_try_again) {
         this->used_size = 0;
         this->parsed_size = 0;
@@ -108,8 +124,10 @@ private:
   std::size_t parsed_size;
   parser_type parser;
 
-  std::expected<void, std::errc> parse_request(std::size_t sz, ParseData& buf) {
+  std::expected<void, std::errc> parse_request(ParseData& buf) {
     auto& front = this->buffer.front();
+    // the incomplete line left by the last call is given again
+    std::size_t sz = this->used_size - this->parsed_size;
     auto [len, req] = this->parser.parse(
         reinterpret_cast<const char*>(front.data.get() + this->parsed_size), sz);
     if (req) {
@@ -65,6 +65,68 @@ const std::array<std::string_view, CHARSET_COUNT> CHARSET_STRINGS = {
 };
 
 std::string_view to_string_view(const Charset& charset);
+/// @brief the well-known field names, they are kept by the id rather than the name
+enum class HeaderName : uint8_t {
+  ACCEPT,
+  ACCEPT_ENCODING,
+  ACCEPT_LANGUAGE,
+  AUTHORIZATION,
+  CACHE_CONTROL,
+  CONNECTION,
+  CONTENT_ENCODING,
+  CONTENT_LENGTH,
+  CONTENT_TYPE,
+  COOKIE,
+  DATE,
+  ETAG,
+  EXPECT,
+  HOST,
+  IF_MODIFIED_SINCE,
+  IF_NONE_MATCH,
+  KEEP_ALIVE,
+  LAST_MODIFIED,
+  LOCATION,
+  RANGE,
+  REFERER,
+  SERVER,
+  SET_COOKIE,
+  TRANSFER_ENCODING,
+  UPGRADE,
+  USER_AGENT,
+  EXT = 0xff,
+};
+
+const int HTTP_HEADER_NAME_COUNT = 26;
+const std::array<std::string_view, HTTP_HEADER_NAME_COUNT> HTTP_HEADER_NAME_STRINGS = {
+    "Accept",
+    "Accept-Encoding",
+    "Accept-Language",
+    "Authorization",
+    "Cache-Control",
+    "Connection",
+    "Content-Encoding",
+    "Content-Length",
+    "Content-Type",
+    "Cookie",
+    "Date",
+    "ETag",
+    "Expect",
+    "Host",
+    "If-Modified-Since",
+    "If-None-Match",
+    "Keep-Alive",
+    "Last-Modified",
+    "Location",
+    "Range",
+    "Referer",
+    "Server",
+    "Set-Cookie",
+    "Transfer-Encoding",
+    "Upgrade",
+    "User-Agent",
+};
+
+std::string_view to_string_view(const HeaderName& name);
 
 enum class Status : uint16_t {
   CONTINUE = 100,
@@ -115,7 +177,7 @@ enum class Status : uint16_t {
 };
 
 const int HTTP_STATUS_COUNT = 45;
-const std::array<std::string_view, HTTP_STATUS_COUNT> HTTP_STATUS_STRINGS = {
+constexpr std::array<std::string_view, HTTP_STATUS_COUNT> HTTP_STATUS_STRINGS = {
     "100", "101", "200", "201", "202", "203", "204", "205", "206",     "300", "301", "302",
     "303", "304", "305", "307", "308", "400", "401", "402", "403",     "404", "405", "406",
     "407", "408", "409", "410", "411", "412", "413", "414", "415",     "416", "417", "421",
@@ -172,6 +234,14 @@ const std::array<std::string_view, HTTP_STATUS_COUNT> HTTP_REASON_PHRASES = {
 };
 
 std::string_view to_reason_phrase(Status status);
+/**
+ * @brief the status line with the default reason phrase, such as "HTTP/1.1 200 OK\r\n"
+ *
+ * @param version the version, only HTTP/1.0 and HTTP/1.1 have the lines
+ * @param status the status
+ * @return std::string_view the line, empty if there is none
+ */
+std::string_view to_status_line(Version version, Status status);
 
 template <class Clock, class Duration>
 [[nodiscard("The return http date string should be used")]]
@@ -189,5 +259,8 @@ _net::http::Version from_string_view(std::string_view type);
 
 template <>
 _net::http::Method from_string_view(std::string_view type);
+/// @brief the case is ignored, HeaderName::EXT if not well-known
+template <>
+_net::http::HeaderName from_string_view(std::string_view type);
 XSL_NE
 #endif
@@ -0,0 +1,111 @@
+#pragma once
+#ifndef XSL_NET_HTTP_QUERY
+#  define XSL_NET_HTTP_QUERY
+#  include "xsl/net/http/def.h"
+
+#  include <cstddef>
+#  include <iterator>
+#  include <optional>
+#  include <string>
+#  include <string_view>
+#  include <utility>
+XSL_HTTP_NB
+/**
+ * @brief decode the percent-encoded octets, and '+' as SP if it is a form value
+ *
+ * @note an invalid escape is kept as it is
+ * @param data the encoded data
+ * @param plus_as_space whether '+' is SP, as in application/x-www-form-urlencoded
+ * @return std::string the decoded data
+ */
+std::string percent_decode(std::string_view data, bool plus_as_space = true);
+/**
+ * @brief the query of the request target
+ *
+ * @note nothing is split or decoded by the parser. The pairs are split when iterated, without
+ * allocation, and are kept encoded, a value is decoded only by get
+ */
+class QueryView {
+public:
+  using value_type = std::pair<std::string_view, std::string_view>;
+  /// @brief the iterator over the encoded pairs, the empty ones between '&' are skipped
+  class Iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = QueryView::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    Iterator() noexcept : _rest(), _pair(), _end(true) {}
+    explicit Iterator(std::string_view raw) noexcept : _rest(raw), _pair(), _end(false) {
+      this->next();
+    }
+
+    reference operator*() const noexcept { return this->_pair; }
+
+    pointer operator->() const noexcept { return &this->_pair; }
+
+    Iterator& operator++() noexcept {
+      this->next();
+      return *this;
+    }
+
+    Iterator operator++(int) noexcept {
+      auto tmp = *this;
+      this->next();
+      return tmp;
+    }
+
+    bool operator==(const Iterator& rhs) const noexcept {
+      return this->_end == rhs._end && (this->_end || this->_rest.data() == rhs._rest.data());
+    }
+
+  private:
+    std::string_view _rest;  ///< the pairs after the current one
+    value_type _pair;
+    bool _end;
+
+    void next() noexcept;
+  };
+
+  QueryView() noexcept : _raw() {}
+  explicit QueryView(std::string_view raw) noexcept : _raw(raw) {}
+  QueryView(const QueryView&) noexcept = default;
+  QueryView& operator=(const QueryView&) noexcept = default;
+  ~QueryView() = default;
+  /// @brief the query as it is in the request target, without '?'
+  std::string_view raw() const noexcept { return this->_raw; }
+
+  Iterator begin() const noexcept { return Iterator{this->_raw}; }
+
+  Iterator end() const noexcept { return Iterator{}; }
+
+  bool empty() const noexcept { return this->begin() == this->end(); }
+  /// @brief the count of the pairs, they are walked through
+  std::size_t size() const noexcept {
+    return static_cast<std::size_t>(std::distance(this->begin(), this->end()));
+  }
+  /**
+   * @brief find the first value of the key
+   *
+   * @note the key is compared with the decoded names, without allocation
+   * @param key the decoded key
+   * @return std::optional<std::string_view> the encoded value
+   */
+  std::optional<std::string_view> find(std::string_view key) const noexcept;
+  /**
+   * @brief find and decode the first value of the key
+   *
+   * @param key the decoded key
+   * @return std::optional<std::string> the decoded value
+   */
+  std::optional<std::string> get(std::string_view key) const;
+
+  bool contains(std::string_view key) const noexcept { return this->find(key).has_value(); }
+
+private:
+  std::string_view _raw;
+};
+XSL_HTTP_NE
+#endif
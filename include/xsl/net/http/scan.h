@@ -0,0 +1,249 @@
+#pragma once
+#ifndef XSL_NET_HTTP_SCAN
+#  define XSL_NET_HTTP_SCAN
+#  include "xsl/net/http/def.h"
+
+#  if defined(__AVX2__) || defined(__SSE4_2__)
+#    include <immintrin.h>
+#  endif
+
+#  include <array>
+#  include <cstddef>
+#  include <cstdint>
+#  include <string_view>
+XSL_HTTP_NB
+namespace impl_scan {
+  /// @brief tchar of RFC 9110, the characters of a method or a field name
+  constexpr bool is_tchar(unsigned char c) noexcept {
+    if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+      return true;
+    }
+    switch (c) {
+      case '!':
+      case '#':
+      case '$':
+      case '%':
+      case '&':
+      case '\'':
+      case '*':
+      case '+':
+      case '-':
+      case '.':
+      case '^':
+      case '_':
+      case '`':
+      case '|':
+      case '~':
+        return true;
+      default:
+        return false;
+    }
+  }
+  /// @brief the control characters except HTAB, they end or break a line
+  constexpr bool is_ctl(unsigned char c) noexcept { return (c < 0x20 && c != '\t') || c == 0x7f; }
+
+  constexpr auto TCHAR_TABLE = [] {
+    std::array<bool, 256> table{};
+    for (std::size_t c = 0; c < table.size(); ++c) {
+      table[c] = is_tchar(static_cast<unsigned char>(c));
+    }
+    return table;
+  }();
+
+  constexpr auto CTL_TABLE = [] {
+    std::array<bool, 256> table{};
+    for (std::size_t c = 0; c < table.size(); ++c) {
+      table[c] = is_ctl(static_cast<unsigned char>(c));
+    }
+    return table;
+  }();
+  /**
+   * @brief the tchar class of the low nibbles
+   *
+   * @note each bit stands for a high nibble from 2 to 7, a byte is a tchar if the bit of its high
+   * nibble is set in the entry of its low nibble. So a vector is classified by two shuffles
+   */
+  constexpr auto TCHAR_LOW_NIBBLE = [] {
+    std::array<std::uint8_t, 16> table{};
+    for (unsigned c = 0x20; c < 0x80; ++c) {
+      if (is_tchar(static_cast<unsigned char>(c))) {
+        table[c & 0xf] |= static_cast<std::uint8_t>(1 << ((c >> 4) - 2));
+      }
+    }
+    return table;
+  }();
+  /// @brief the tchar class of the high nibbles, no tchar has a high nibble out of 2 to 7
+  constexpr std::array<std::uint8_t, 16> TCHAR_HIGH_NIBBLE
+      = {0, 0, 1, 2, 4, 8, 16, 32, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  constexpr char to_lower(char c) noexcept {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c;
+  }
+
+#  if defined(__AVX2__)
+  /// @brief set the case bit of the upper case letters, the bytes over 0x7f are negative
+  inline __m256i to_lower(__m256i v) noexcept {
+    __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v));
+    return _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+  }
+
+  inline __m256i broadcast_nibbles(const std::array<std::uint8_t, 16>& table) noexcept {
+    return _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(table.data())));
+  }
+#  endif
+#  if defined(__SSE4_2__)
+  inline __m128i to_lower(__m128i v) noexcept {
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                                  _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), v));
+    return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+  }
+#  endif
+}  // namespace impl_scan
+/**
+ * @brief find the first control character, that is, the end of a line
+ *
+ * @note HTAB and obs-text are allowed, CR and LF are found like the other control characters, so
+ * the caller checks the byte found. The bytes are checked 32 at a time with AVX2, 16 at a time with
+ * SSE4.2, and one by one for the tail or without them
+ * @param data the data
+ * @param len the length of the data
+ * @return std::size_t the position of the character, len if not found
+ */
+inline std::size_t scan_ctl(const char* data, std::size_t len) noexcept {
+  std::size_t i = 0;
+#  if defined(__AVX2__)
+  {
+    const __m256i max_ctl = _mm256_set1_epi8(0x1f);
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    for (; i + 32 <= len; i += 32) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+      __m256i ctl = _mm256_cmpeq_epi8(_mm256_min_epu8(v, max_ctl), v);
+      ctl = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, tab), ctl);
+      ctl = _mm256_or_si256(ctl, _mm256_cmpeq_epi8(v, del));
+      if (auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(ctl)); mask != 0) {
+        return i + __builtin_ctz(mask);
+      }
+    }
+  }
+#  endif
+#  if defined(__SSE4_2__)
+  {
+    // the ranges of the control characters, HTAB is left out
+    const __m128i ranges = _mm_setr_epi8(0x00, 0x08, 0x0a, 0x1f, 0x7f, 0x7f, 0, 0, 0, 0, 0, 0, 0,
+                                         0, 0, 0);
+    for (; i + 16 <= len; i += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+      int pos = _mm_cmpestri(ranges, 6, v, 16,
+                             _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+      if (pos != 16) {
+        return i + pos;
+      }
+    }
+  }
+#  endif
+  for (; i < len; ++i) {
+    if (impl_scan::CTL_TABLE[static_cast<unsigned char>(data[i])]) {
+      break;
+    }
+  }
+  return i;
+}
+/**
+ * @brief find the first character which is not a tchar, that is, the end of a token
+ *
+ * @note the bytes are classified by the nibble tables with two shuffles, 32 at a time with AVX2,
+ * 16 at a time with SSE4.2, and one by one for the tail or without them
+ * @param data the data
+ * @param len the length of the data
+ * @return std::size_t the position of the character, len if not found
+ */
+inline std::size_t scan_token(const char* data, std::size_t len) noexcept {
+  std::size_t i = 0;
+#  if defined(__AVX2__)
+  {
+    const __m256i low = impl_scan::broadcast_nibbles(impl_scan::TCHAR_LOW_NIBBLE);
+    const __m256i high = impl_scan::broadcast_nibbles(impl_scan::TCHAR_HIGH_NIBBLE);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    for (; i + 32 <= len; i += 32) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+      __m256i cls = _mm256_and_si256(
+          _mm256_shuffle_epi8(low, _mm256_and_si256(v, nibble)),
+          _mm256_shuffle_epi8(high, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble)));
+      __m256i bad = _mm256_cmpeq_epi8(cls, _mm256_setzero_si256());
+      if (auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(bad)); mask != 0) {
+        return i + __builtin_ctz(mask);
+      }
+    }
+  }
+#  endif
+#  if defined(__SSE4_2__)
+  {
+    const __m128i low
+        = _mm_loadu_si128(reinterpret_cast<const __m128i*>(impl_scan::TCHAR_LOW_NIBBLE.data()));
+    const __m128i high
+        = _mm_loadu_si128(reinterpret_cast<const __m128i*>(impl_scan::TCHAR_HIGH_NIBBLE.data()));
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    for (; i + 16 <= len; i += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+      __m128i cls
+          = _mm_and_si128(_mm_shuffle_epi8(low, _mm_and_si128(v, nibble)),
+                          _mm_shuffle_epi8(high, _mm_and_si128(_mm_srli_epi16(v, 4), nibble)));
+      __m128i bad = _mm_cmpeq_epi8(cls, _mm_setzero_si128());
+      if (auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(bad)); mask != 0) {
+        return i + __builtin_ctz(mask);
+      }
+    }
+  }
+#  endif
+  for (; i < len; ++i) {
+    if (!impl_scan::TCHAR_TABLE[static_cast<unsigned char>(data[i])]) {
+      break;
+    }
+  }
+  return i;
+}
+/**
+ * @brief compare two strings ignoring the case of the ASCII letters, such as the field names
+ *
+ * @note the letters are lowered by vectors as the scanners do
+ * @param lhs one string
+ * @param rhs another string
+ * @return true if equal
+ */
+inline bool iequal(std::string_view lhs, std::string_view rhs) noexcept {
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+  std::size_t i = 0, len = lhs.size();
+#  if defined(__AVX2__)
+  for (; i + 32 <= len; i += 32) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs.data() + i));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs.data() + i));
+    __m256i eq = _mm256_cmpeq_epi8(impl_scan::to_lower(a), impl_scan::to_lower(b));
+    if (static_cast<std::uint32_t>(_mm256_movemask_epi8(eq)) != 0xffffffff) {
+      return false;
+    }
+  }
+#  endif
+#  if defined(__SSE4_2__)
+  for (; i + 16 <= len; i += 16) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs.data() + i));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs.data() + i));
+    __m128i eq = _mm_cmpeq_epi8(impl_scan::to_lower(a), impl_scan::to_lower(b));
+    if (_mm_movemask_epi8(eq) != 0xffff) {
+      return false;
+    }
+  }
+#  endif
+  for (; i < len; ++i) {
+    if (impl_scan::to_lower(lhs[i]) != impl_scan::to_lower(rhs[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+XSL_HTTP_NE
+#endif
@@ -12,14 +12,18 @@
 #  include "xsl/net/http/parse.h"
 #  include "xsl/net/http/proto.h"
 #  include "xsl/net/http/router.h"
+#  include "xsl/net/http/scan.h"
 #  include "xsl/net/tcp.h"
+#  include "xsl/sync/runtime.h"
 
 #  include <cstddef>
 #  include <expected>
 #  include <memory>
+#  include <string>
 #  include <string_view>
 #  include <unordered_map>
 #  include <utility>
+#  include <vector>
 
 XSL_HTTP_NB
 namespace impl_server {
@@ -27,10 +31,11 @@ namespace impl_server {
   template <RouterLike<std::size_t> R, ai::AsyncReadDeviceLike<std::byte> In,
             ai::AsyncWriteDeviceLike<std::byte> Out>
   struct InnerDetails {
-    InnerDetails() : router(), handlers(), status_handlers() {}
+    InnerDetails() : router(), handlers(), status_handlers(), zerocopy_threshold(0) {}
     R router;
     std::unordered_map<std::size_t, Handler<In, Out>> handlers;
     std::unordered_map<Status, Handler<In, Out>> status_handlers;
+    std::size_t zerocopy_threshold;  ///< the min size sent by MSG_ZEROCOPY, 0 if disabled
   };
 
   /**
@@ -50,8 +55,18 @@ namespace impl_server {
     using handler_type = Handler<in_dev_type, out_dev_type>;
     using details_type = InnerDetails<R, in_dev_type, out_dev_type>;
 
-    Server(lower_type&& server, std::unique_ptr<details_type>&& details)
-        : server(std::move(server)), details(std::move(details)) {}
+    Server(lower_type&& server, std::shared_ptr<details_type>&& details)
+        : Server(std::move(server), std::move(details), nullptr) {}
+    /**
+     * @brief Construct a new Server object
+     *
+     * @param server the lower server
+     * @param details the routes and handlers
+     * @param runtime the runtime to distribute the connections to, nullptr to keep them on the
+     * poller of the lower server
+     */
+    Server(lower_type&& server, std::shared_ptr<details_type>&& details, sync::Runtime* runtime)
+        : server(std::move(server)), details(std::move(details)), runtime(runtime) {}
 
     Server(Server&&) = default;
     Server& operator=(Server&&) = default;
@@ -67,6 +82,17 @@ namespace impl_server {
     coro::Lazy<std::expected<void, std::errc>, Executor> run() {
       LOG4("HttpServer start at: {}:{}", this->server.host, this->server.port);
       while (true) {
+        if (this->runtime != nullptr) {
+          // the connection is owned by the reactor, both its events and its coroutine run there
+          auto& reactor = this->runtime->next();
+          auto res = co_await this->server.template accept<Executor>(nullptr, *reactor->poller());
+          if (!res) {
+            LOG2("accept error: {}", std::make_error_code(res.error()).message());
+            continue;
+          }
+          http_connection<coro::ExecutorBase>(std::move(*res)).detach(reactor);
+          continue;
+        }
         auto res = co_await this->server.template accept<Executor>(nullptr);
         if (!res) {
           LOG2("accept error: {}", std::make_error_code(res.error()).message());
@@ -78,13 +104,24 @@ namespace impl_server {
 
   private:
     lower_type server;
-    std::unique_ptr<details_type> details;
+    std::shared_ptr<details_type> details;  ///< shared by the shards of a sharded server
+    sync::Runtime* runtime;
 
     template <class Executor = coro::ExecutorBase>
     coro::Lazy<void, Executor> http_connection(io_dev_type dev) {
       auto [ard, awd] = std::move(dev).split();
+      if constexpr (requires { awd.set_zerocopy(std::size_t{}); }) {
+        if (auto threshold = this->details->zerocopy_threshold; threshold != 0) {
+          if (auto res = awd.set_zerocopy(threshold); !res) {
+            LOG3("set zerocopy error: {}", std::make_error_code(res.error()).message());
+          }
+        }
+      }
       auto parser = Parser<HttpParseTrait>{};
       ParseData parse_data{};
+      // the header of every response is serialized into it, so it is allocated once
+      std::string out;
+      out.reserve(HTTP_BUFFER_BLOCK_SIZE);
       while (true) {
         {
           auto res = co_await parser.template read<Executor>(ard, parse_data);
@@ -97,11 +134,8 @@ namespace impl_server {
           LOG4("New request: {} {}", parse_data.request.method, parse_data.request.path);
         }
 
-        bool keep_alive = true;
-        if (auto iter = parse_data.request.headers.find("Connection");
-            iter == parse_data.request.headers.end() || iter->second != "keep-alive") {
-          keep_alive = false;
-        }
+        auto connection = parse_data.request.headers.find(HeaderName::CONNECTION);
+        bool keep_alive = connection != nullptr && iequal(*connection, "keep-alive");
 
         Request<in_dev_type> request{std::move(parse_data.buffer), std::move(parse_data.request),
                                      parse_data.content_part, ard};
@@ -130,7 +164,7 @@ namespace impl_server {
             }
           }
         }
-        auto [sz, err] = co_await ctx.sendto(awd);
+        auto [sz, err] = co_await ctx.sendto(awd, out);
         if (err) {
           LOG3("send error: {}", std::make_error_code(*err).message());
         }
@@ -140,6 +174,40 @@ namespace impl_server {
       }
     }
   };
+
+  /**
+   * @brief ShardedServer, one Server per reactor, every one accepts on its own listener
+   *
+   * @tparam LowerServer the lower server type, such as TcpServer
+   * @tparam R the router type, such as Router
+   */
+  template <class LowerServer, RouterLike<std::size_t> R = Router>
+  class ShardedServer {
+  public:
+    using server_type = Server<LowerServer, R>;
+
+    ShardedServer(std::vector<server_type>&& shards, sync::Runtime& runtime)
+        : shards(std::move(shards)), runtime(&runtime) {}
+    ShardedServer(ShardedServer&&) = default;
+    ShardedServer& operator=(ShardedServer&&) = default;
+
+    std::size_t size() const noexcept { return this->shards.size(); }
+    /**
+     * @brief Run every shard on its reactor, the connections stay on the reactor accepting them
+     *
+     * @note the shards are referred by the running coroutines, so the server must outlive the
+     * runtime threads
+     */
+    void run() {
+      for (std::size_t i = 0; i < this->shards.size(); ++i) {
+        this->shards[i].run().detach(this->runtime->reactor(i));
+      }
+    }
+
+  private:
+    std::vector<server_type> shards;
+    sync::Runtime* runtime;
+  };
 }  // namespace impl_server
 
 /**
@@ -224,6 +292,16 @@ public:
   void set_status_handler(Status kind, handler_type&& handler) {
     this->details->status_handlers.try_emplace(kind, std::move(handler));
   }
+  /**
+   * @brief Send the responses of at least the threshold by MSG_ZEROCOPY
+   *
+   * @note the send completes once the peer acknowledges the data, so it only pays off for large
+   * bodies, such as generated exports
+   * @param threshold the min size, 0 to disable
+   */
+  void set_zerocopy(std::size_t threshold = sys::net::DEFAULT_ZEROCOPY_THRESHOLD) {
+    this->details->zerocopy_threshold = threshold;
+  }
   /**
    * @brief Build the server
    *
@@ -241,6 +319,50 @@ public:
     }
     return impl_server::Server<server_type, R>{std::move(*res), std::move(details)};
   }
+  /**
+   * @brief Build the server on a runtime
+   *
+   * @note the listener is registered to the first reactor, so the server should be run there, the
+   * accepted connections are distributed to all reactors in round robin
+   * @param host the host
+   * @param port the port
+   * @param runtime the runtime
+   * @return std::expected<impl_server::Server<server_type, R>, std::error_condition>
+   */
+  std::expected<impl_server::Server<server_type, R>, std::error_condition> build(
+      std::string_view host, std::string_view port, sync::Runtime& runtime) && {
+    auto res = server_type::create(host, port, runtime.reactor(0)->poller());
+    if (!res) {
+      return std::unexpected{res.error()};
+    }
+    return impl_server::Server<server_type, R>{std::move(*res), std::move(details), &runtime};
+  }
+  /**
+   * @brief Build a sharded server on a runtime
+   *
+   * @note every reactor gets its own SO_REUSEPORT listener, so the kernel spreads the connections
+   * and no connection is handed off between reactors
+   * @param host the host
+   * @param port the port
+   * @param runtime the runtime
+   * @param steering how the connections are steered between the listeners
+   * @return std::expected<impl_server::ShardedServer<server_type, R>, std::error_condition>
+   */
+  std::expected<impl_server::ShardedServer<server_type, R>, std::error_condition> build(
+      std::string_view host, std::string_view port, sync::Runtime& runtime,
+      _net::ReusePortSteering steering) && {
+    auto res = server_type::create(host, port, runtime, steering);
+    if (!res) {
+      return std::unexpected{res.error()};
+    }
+    std::shared_ptr<details_type> shared = std::move(details);
+    std::vector<impl_server::Server<server_type, R>> shards;
+    shards.reserve(res->size());
+    for (auto& server : *res) {
+      shards.emplace_back(std::move(server), std::shared_ptr{shared}, nullptr);
+    }
+    return impl_server::ShardedServer<server_type, R>{std::move(shards), runtime};
+  }
 
 private:
   std::size_t tag;
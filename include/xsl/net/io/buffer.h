@@ -14,7 +14,11 @@
 #  include "xsl/ai/dev.h"
 #  include "xsl/feature.h"
 #  include "xsl/net/io/def.h"
+#  include "xsl/sys/net/io.h"
 
+#  include <sys/uio.h>
+
+#  include <array>
 #  include <cstddef>
 #  include <forward_list>
 #  include <memory>
@@ -85,12 +89,43 @@ namespace impl_buffer {
       }
       co_return std::make_tuple(total_size, std::nullopt);
     };
+    /**
+     * @brief write all blocks by gather writes, rather than one write per block
+     *
+     * @tparam Writer the device sending several buffers by one gather write
+     * @param awd the device
+     * @param prefix the data sent before the blocks in the same gather write, such as a header
+     * @return coro::Task<ai::Result> the size sent, including the prefix
+     */
+    template <sys::net::AsyncWritevDeviceLike Writer>
+    coro::Task<ai::Result> write(Writer& awd, std::span<const value_type> prefix = {}) {
+      std::array<iovec, IOV_BATCH> iov;
+      std::size_t count = 0, total_size = 0;
+      if (!prefix.empty()) {
+        iov[count++] = {const_cast<value_type*>(prefix.data()), prefix.size()};
+      }
+      auto it = _blocks.begin();
+      while (count != 0 || it != _blocks.end()) {
+        for (; count < iov.size() && it != _blocks.end(); ++it) {
+          iov[count++] = {it->data.get(), it->valid_size};
+        }
+        auto [size, err] = co_await awd.write(std::span<const iovec>(iov.data(), count));
+        total_size += size;
+        if (err) {
+          co_return std::make_tuple(total_size, err);
+        }
+        count = 0;
+      }
+      co_return std::make_tuple(total_size, std::nullopt);
+    }
 
     BufferCompose<feature::Dyn> to_dyn() { return BufferCompose<feature::Dyn>(std::move(_blocks)); }
 
     std::forward_list<Block> _blocks;
 
   protected:
+    static constexpr std::size_t IOV_BATCH = 16;  ///< the blocks gathered by one write
+
     Buffer(std::forward_list<Block>&& blocks) : _blocks(std::move(blocks)) {}
   };
 }  // namespace impl_buffer
@@ -4,10 +4,18 @@
 #  include "xsl/ai/dev.h"
 #  include "xsl/coro.h"
 #  include "xsl/net/io/def.h"
+#  include "xsl/sys/net/io.h"
+#  include "xsl/sys/pipe.h"
+
+#  include <span>
+#  include <string>
+#  include <tuple>
 XSL_NET_IO_NB
 /**
  * @brief splice data from one device to another
  *
+ * @note if both devices are native fds, the data is relayed by the kernel through a pooled pipe
+ * and the buffer is not used
  * @tparam Executor the executor type
  * @tparam From the device type to read data from
  * @tparam To the device type to write data to
@@ -19,15 +27,30 @@ XSL_NET_IO_NB
 template <class Executor = coro::ExecutorBase, ai::AsyncReadDeviceLike<std::byte> From,
           ai::AsyncWriteDeviceLike<std::byte> To>
 coro::Lazy<void, Executor> splice(From& from, To& to, std::string& buffer) {
+  if constexpr (sys::ReadyDeviceLike<From> && sys::ReadyDeviceLike<To>) {
+    co_await sys::relay<Executor>(from, to);
+    co_return;
+  }
   while (true) {
-    auto [sz, err]
-        = co_await from.template read<Executor>(std::as_writable_bytes(std::span(buffer)));
+    auto buf = std::as_writable_bytes(std::span(buffer));
+    ai::Result res;
+    // the awaiters of the native devices need no frame of their own
+    if constexpr (sys::net::AsyncRecvDeviceLike<From>) {
+      res = co_await from.recv(buf);
+    } else {
+      res = co_await from.template read<Executor>(buf);
+    }
+    auto [sz, err] = res;
     if (err) {
       co_return;
     }
-    auto [s_sz, s_err]
-        = co_await to.template write<Executor>(std::as_bytes(std::span(buffer).subspan(0, sz)));
-    if (s_err) {
+    auto data = std::as_bytes(std::span(buffer).subspan(0, sz));
+    if constexpr (sys::net::AsyncSendDeviceLike<To>) {
+      res = co_await to.send(data);
+    } else {
+      res = co_await to.template write<Executor>(data);
+    }
+    if (std::get<1>(res)) {
       co_return;
     }
   }
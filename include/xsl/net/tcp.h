@@ -6,12 +6,17 @@
 #  include "xsl/net/def.h"
 #  include "xsl/net/transport/accept.h"
 #  include "xsl/sync/poller.h"
+#  include "xsl/sync/runtime.h"
 #  include "xsl/sys.h"
 #  include "xsl/sys/net/def.h"
 #  include "xsl/sys/net/socket.h"
 
+#  include <sys/socket.h>
+
 #  include <expected>
 #  include <memory>
+#  include <span>
+#  include <vector>
 XSL_NET_NB
 template <class... Flags>
 coro::Task<
@@ -47,6 +52,61 @@ std::expected<sys::net::TcpSocket<LowerLayer>, std::error_condition> tcp_serv(co
   return sys::net::TcpSocket<LowerLayer>{std::move(*bind_res)};
 }
 
+/**
+ * @brief How the connections are steered between the listeners of a sharded server
+ *
+ */
+enum class ReusePortSteering : uint8_t {
+  NONE = 0,          ///< the kernel hashes the connections to the listeners
+  CBPF = 1,          ///< a classic bpf program selects the listener of the receiving cpu
+  INCOMING_CPU = 2,  ///< every listener prefers the connections received by its cpu
+};
+
+/**
+ * @brief listen on the same address with one SO_REUSEPORT socket per shard
+ *
+ * @tparam LowerLayer, such as feature::Ip<Version>(Version = 4 or 6)
+ * @param host the host to listen on
+ * @param port the port to listen on
+ * @param cpus the cpu of every shard, -1 if the shard is not bound to a cpu
+ * @param steering how the connections are steered, failing to set it up is not fatal
+ * @return std::expected<std::vector<sys::net::TcpSocket<LowerLayer>>, std::error_condition>
+ */
+template <class LowerLayer>
+std::expected<std::vector<sys::net::TcpSocket<LowerLayer>>, std::error_condition> tcp_serv(
+    const char *host, const char *port, std::span<const int> cpus, ReusePortSteering steering) {
+  auto addr
+      = xsl::net::Resolver{}.resolve<feature::Tcp<LowerLayer>>(host, port, xsl::net::SERVER_FLAGS);
+  if (!addr) {
+    return std::unexpected(addr.error());
+  }
+  std::vector<sys::net::TcpSocket<LowerLayer>> skts;
+  skts.reserve(cpus.size());
+  for (auto cpu : cpus) {
+    auto bind_res = sys::tcp::bind(*addr, true);
+    if (!bind_res) {
+      return std::unexpected(bind_res.error());
+    }
+    if (steering == ReusePortSteering::INCOMING_CPU && cpu >= 0) {
+      if (auto res = sys::tcp::set_incoming_cpu(*bind_res, cpu); !res) {
+        WARN("Failed to set incoming cpu {}, {}", cpu, std::make_error_code(res.error()).message());
+      }
+    }
+    // the listeners join the reuseport group in the listen order, which the cbpf relies on
+    auto lres = sys::tcp::listen(*bind_res, SOMAXCONN);
+    if (!lres) {
+      return std::unexpected(lres.error());
+    }
+    skts.emplace_back(std::move(*bind_res));
+  }
+  if (steering == ReusePortSteering::CBPF && !skts.empty()) {
+    if (auto res = sys::tcp::attach_reuseport_cbpf(skts.front(), cpus); !res) {
+      WARN("Failed to attach reuseport cbpf, {}", std::make_error_code(res.error()).message());
+    }
+  }
+  return skts;
+}
+
 /**
  * @brief TcpServer
  *
@@ -85,6 +145,41 @@ public:
     return TcpServer{host, port, std::move(copy_poller), std::move(*ac)};
   }
 
+  /**
+   * @brief Create one server per reactor, every one has its own SO_REUSEPORT listener
+   *
+   * @note the i-th server is registered to the i-th reactor, and should be run there
+   * @param host the host to listen on
+   * @param port the port to listen on
+   * @param runtime the runtime
+   * @param steering how the connections are steered between the listeners
+   * @return std::expected<std::vector<TcpServer>, std::error_condition>
+   */
+  static std::expected<std::vector<TcpServer>, std::error_condition> create(
+      std::string_view host, std::string_view port, sync::Runtime &runtime,
+      ReusePortSteering steering) {
+    LOG5("Start listening on {}:{} with {} shards", host, port, runtime.size());
+    std::vector<int> cpus(runtime.size());
+    for (std::size_t i = 0; i < cpus.size(); ++i) {
+      cpus[i] = runtime.cpu(i);
+    }
+    auto skts = tcp_serv<lower_layer_type>(host.data(), port.data(), cpus, steering);
+    if (!skts) {
+      return std::unexpected(skts.error());
+    }
+    std::vector<TcpServer> servers;
+    servers.reserve(skts->size());
+    for (std::size_t i = 0; i < skts->size(); ++i) {
+      auto &poller = runtime.reactor(i)->poller();
+      auto ac = transport::Acceptor<lower_layer_type>::create(*poller, std::move((*skts)[i]));
+      if (!ac) {
+        return std::unexpected(ac.error());
+      }
+      servers.emplace_back(host, port, poller, std::move(*ac));
+    }
+    return servers;
+  }
+
   template <class P, class... Args>
   TcpServer(std::string_view host, std::string_view port, P &&poller, Args &&...args)
       : host(host), port(port), poller(std::forward<P>(poller)), _ac(std::forward<Args>(args)...) {}
@@ -99,9 +194,24 @@ public:
    */
   template <class Executor = coro::ExecutorBase>
   decltype(auto) accept(sys::net::SockAddr *addr) noexcept {
-    return this->_ac.template accept<Executor>(addr).transform([this](auto &&res) {
-      return res.transform(
-          [this](auto &&skt) { return io_dev_type{std::move(skt).async(*this->poller)}; });
+    return this->accept<Executor>(addr, *this->poller);
+  }
+  /**
+   * @brief accept a connection and register it to another poller
+   *
+   * @tparam Executor the executor type, default is coro::ExecutorBase
+   * @param addr the address of the local socket
+   * @param target the poller the connection is registered to, such as the poller of a reactor
+   * @return decltype(auto) the io_dev_type
+   */
+  template <class Executor = coro::ExecutorBase>
+  decltype(auto) accept(sys::net::SockAddr *addr, Poller &target) noexcept {
+    return this->_ac.template accept<Executor>(addr).transform([&target](auto &&res) {
+      // the connection is closed if it fails to be registered
+      return res.and_then([&target](auto &&skt) {
+        return std::move(skt).async(target).transform(
+            [](auto &&dev) { return io_dev_type{std::move(dev)}; });
+      });
     });
   }
 
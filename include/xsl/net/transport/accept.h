@@ -5,6 +5,12 @@
 #  include "xsl/sync/poller.h"
 #  include "xsl/sys/net/accept.h"
 #  include "xsl/sys/net/socket.h"
+#  include "xsl/sys/net/uring.h"
+
+#  include <expected>
+#  include <optional>
+#  include <stop_token>
+#  include <system_error>
 TRANSPORT_NB
 
 template <class LowerLayer>
@@ -17,33 +23,54 @@ public:
   static std::expected<Acceptor, std::error_condition> create(sync::Poller &poller,
                                                               layer_type &&socket) {
     auto async = std::move(socket).async(poller);
-    return Acceptor{std::move(async)};
+    if (!async) {
+      return std::unexpected{std::make_error_condition(async.error())};
+    }
+    if (poller.engine() == sync::PollEngine::IO_URING) {
+      auto multishot = sys::net::MultishotAccept(poller, async->raw());
+      return Acceptor{std::move(*async), std::move(multishot)};
+    }
+    return Acceptor{std::move(*async)};
   }
-  Acceptor(async_layer_type &&dev) : _dev(std::move(dev)) {}
+  Acceptor(async_layer_type &&dev) : _dev(std::move(dev)), _multishot(std::nullopt) {}
+  Acceptor(async_layer_type &&dev, sys::net::MultishotAccept &&multishot)
+      : _dev(std::move(dev)), _multishot(std::move(multishot)) {}
   Acceptor(Acceptor &&) = default;
   Acceptor &operator=(Acceptor &&) = default;
   ~Acceptor() {}
+  /**
+   * @brief accept a connection
+   *
+   * @tparam Executor default is coro::ExecutorBase
+   * @param addr the address of the peer, can be nullptr
+   * @param token the stop token, the wait ends with std::errc::operation_canceled once the stop is
+   * requested
+   * @return coro::Task<std::expected<layer_type, std::errc>, Executor>
+   */
   template <class Executor = coro::ExecutorBase>
   coro::Task<std::expected<layer_type, std::errc>, Executor> accept(
-      sys::net::SockAddr *addr) noexcept {
-    while (true) {
-      auto res = sys::net::accept(this->_dev.inner(), addr);
-      if (res) {
-        auto sock = std::move(*res);
-        co_return sock;
-      } else if (res.error() == std::errc::resource_unavailable_try_again
-                 || res.error() == std::errc::operation_would_block) {
-        if (!co_await this->_dev.read_sem()) {
-          co_return std::unexpected{std::errc::operation_canceled};
-        }
-      } else {
+      sys::net::SockAddr *addr, std::stop_token token = {}) noexcept {
+    // the multishot accept can not report the address of every connection
+    if (this->_multishot && addr == nullptr) {
+      auto res = co_await this->_multishot->template accept<Executor>(std::move(token));
+      if (!res) {
         co_return std::unexpected{res.error()};
       }
+      co_return layer_type{*res};
+    }
+    auto res = co_await sys::net::async_accept(this->_dev, addr, std::move(token));
+    if (!res) {
+      // woken with false, the listener is closed
+      co_return std::unexpected{res.error() == std::errc::not_connected
+                                    ? std::errc::operation_canceled
+                                    : res.error()};
     }
+    co_return std::move(*res);
   }
 
 private:
   async_layer_type _dev;
+  std::optional<sys::net::MultishotAccept> _multishot;
 };
 
 TRANSPORT_NE
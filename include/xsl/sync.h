@@ -3,23 +3,41 @@
 #  define XSL_SYNC
 #  include "xsl/coro.h"
 #  include "xsl/def.h"
+#  include "xsl/sync/deadline.h"
+#  include "xsl/sync/mpmc.h"
+#  include "xsl/sync/mpsc.h"
 #  include "xsl/sync/mutex.h"
 #  include "xsl/sync/poller.h"
+#  include "xsl/sync/runtime.h"
+#  include "xsl/sync/sleep.h"
 #  include "xsl/sync/spsc.h"
+#  include "xsl/sync/timer.h"
 
 #  include <array>
 XSL_NB
+using sync::Deadline;
 using sync::IOM_EVENTS;
 using sync::LockGuard;
+using sync::MPMC;
+using sync::MPSC;
+using sync::MPSCNode;
 using sync::poll_add_shared;
 using sync::poll_add_unique;
 using sync::Poller;
 using sync::PollHandleHint;
 using sync::PollHandleHintTag;
 using sync::PollHandler;
+using sync::Reactor;
+using sync::Runtime;
 using sync::ShardGuard;
 using sync::ShardRes;
+using sync::sleep_for;
+using sync::sleep_until;
 using sync::SPSC;
+using sync::Timer;
+using sync::TimerWheel;
+using sync::with_deadline;
+using sync::with_timeout;
 
 namespace sync {
   struct PollTraits {
@@ -55,7 +73,10 @@ namespace sync {
 
     template <std::size_t... I>
     bool handle_event(std::index_sequence<I...>, sync::IOM_EVENTS events) {
-      return (handle_event<Events, I>(events) && ...);
+      // every semaphore is handled, the handler is deleted only if none is waited anymore
+      bool unused = true;
+      ((unused &= handle_event<Events, I>(events)), ...);
+      return unused;
     }
 
     template <IOM_EVENTS E, std::size_t I>
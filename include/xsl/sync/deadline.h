@@ -0,0 +1,129 @@
+#pragma once
+#ifndef XSL_SYNC_DEADLINE
+#  define XSL_SYNC_DEADLINE
+#  include "xsl/logctl.h"
+#  include "xsl/sync/def.h"
+#  include "xsl/sync/poller.h"
+#  include "xsl/sync/timer.h"
+
+#  include <atomic>
+#  include <chrono>
+#  include <memory>
+#  include <optional>
+#  include <stop_token>
+#  include <utility>
+XSL_SYNC_NB
+namespace impl_deadline {
+  using clock_type = TimerWheel::clock_type;
+  /**
+   * @brief the timer requesting the stop at the deadline
+   *
+   * @note the state keeps itself alive while the timer is armed, since the timer may be expiring
+   * on the polling thread when the owner goes away
+   */
+  class Source : public Timer {
+  public:
+    Source(Poller &poller)
+        : Timer(&Source::on_expire), _poller(poller), _source(), _expired(false), _self() {}
+    /**
+     * @brief arm the timer
+     *
+     * @param self the owner of this state
+     * @param deadline the deadline
+     * @return true if the timer is armed
+     */
+    bool arm(std::shared_ptr<Source> self, clock_type::time_point deadline) {
+      this->_self = std::move(self);
+      if (!this->_poller.add_timer(this, deadline)) {
+        this->_self.reset();
+        return false;
+      }
+      return true;
+    }
+
+    void disarm() {
+      if (this->_poller.remove_timer(this)) {
+        this->_self.reset();
+      }
+    }
+
+    std::stop_source &source() noexcept { return this->_source; }
+
+    bool expired() const noexcept { return this->_expired.load(std::memory_order_acquire); }
+
+  private:
+    Poller &_poller;
+    std::stop_source _source;
+    std::atomic_bool _expired;
+    std::shared_ptr<Source> _self;
+
+    static void on_expire(Timer *self) {
+      auto source = static_cast<Source *>(self);
+      auto keep_alive = std::move(source->_self);
+      source->_expired.store(true, std::memory_order_release);
+      source->_source.request_stop();
+    }
+  };
+
+  class Forward {
+  public:
+    Forward(std::stop_source source) : _source(std::move(source)) {}
+
+    void operator()() { this->_source.request_stop(); }
+
+  private:
+    std::stop_source _source;
+  };
+}  // namespace impl_deadline
+
+/**
+ * @brief A stop source requested at the deadline or by the parent token, whichever comes first
+ *
+ * @note pass token() to the operations bounded by the deadline, the timer is disarmed when the
+ * deadline is destroyed. Not movable, keep it in the frame of the coroutine
+ */
+class Deadline {
+public:
+  /**
+   * @brief arm the deadline
+   *
+   * @param poller the poller to arm the timer
+   * @param deadline the deadline
+   * @param parent the token of the caller, its stop is forwarded
+   */
+  Deadline(Poller &poller, impl_deadline::clock_type::time_point deadline,
+           std::stop_token parent = {})
+      : _state(std::make_shared<impl_deadline::Source>(poller)), _parent() {
+    if (!this->_state->arm(this->_state, deadline)) {
+      LOG3("Failed to arm the deadline, the poller is shutdown");
+    }
+    if (parent.stop_possible()) {
+      this->_parent.emplace(parent, impl_deadline::Forward{this->_state->source()});
+    }
+  }
+
+  template <class Rep, class Period>
+  Deadline(Poller &poller, std::chrono::duration<Rep, Period> timeout, std::stop_token parent = {})
+      : Deadline(poller, impl_deadline::clock_type::now() + timeout, std::move(parent)) {}
+
+  Deadline(const Deadline &) = delete;
+  Deadline &operator=(const Deadline &) = delete;
+  ~Deadline() {
+    this->_parent.reset();
+    this->_state->disarm();
+  }
+
+  std::stop_token token() const noexcept { return this->_state->source().get_token(); }
+  /**
+   * @brief check if the stop is requested by the deadline, rather than by the parent
+   *
+   * @return true if the deadline has passed
+   */
+  bool expired() const noexcept { return this->_state->expired(); }
+
+private:
+  std::shared_ptr<impl_deadline::Source> _state;
+  std::optional<std::stop_callback<impl_deadline::Forward>> _parent;
+};
+XSL_SYNC_NE
+#endif
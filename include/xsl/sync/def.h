@@ -3,4 +3,9 @@
 #  define XSL_SYNC_CONFIG
 #  define XSL_SYNC_NB namespace xsl::sync {
 #  define XSL_SYNC_NE }
+#  include <cstddef>
+XSL_SYNC_NB
+/// @brief the size to align the data written by different threads, so they do not share a line
+const std::size_t CACHE_LINE_SIZE = 64;
+XSL_SYNC_NE
 #endif
@@ -0,0 +1,113 @@
+#pragma once
+#ifndef XSL_SYNC_MPMC
+#  define XSL_SYNC_MPMC
+#  include "xsl/sync/def.h"
+
+#  include <atomic>
+#  include <cstddef>
+#  include <cstdint>
+#  include <memory>
+#  include <optional>
+#  include <utility>
+XSL_SYNC_NB
+/**
+ * @brief A bounded multi-producer multi-consumer queue, after Dmitry Vyukov
+ *
+ * @note every cell carries a sequence number telling whether it is ready to push or to pop in the
+ * current lap, so a push or a pop is one CAS on its index plus one store on the cell, and the
+ * producers and the consumers only contend with their own side
+ * @tparam T the element type
+ * @tparam N the capacity, must be power of 2
+ */
+template <class T, std::size_t N = 1024>
+class MPMC {
+  struct Cell {
+    std::atomic<std::size_t> seq;
+    T value;
+  };
+
+public:
+  static_assert(N > 1 && (N & (N - 1)) == 0, "MPMC capacity must be power of 2");
+
+  MPMC() : _enqueue(0), _dequeue(0), _cells(std::make_unique<Cell[]>(N)) {
+    for (std::size_t i = 0; i < N; ++i) {
+      _cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+  MPMC(const MPMC&) = delete;
+  MPMC& operator=(const MPMC&) = delete;
+  /**
+   * @brief push the value
+   *
+   * @return true if pushed, false if the queue is full
+   */
+  bool push(T&& t) {
+    auto pos = _enqueue.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &_cells[pos & MASK];
+      auto seq = cell->seq.load(std::memory_order_acquire);
+      auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+      if (diff == 0) {
+        if (_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // the cell is not popped since the last lap
+        return false;
+      } else {
+        pos = _enqueue.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value = std::move(t);
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+  /**
+   * @brief pop a value
+   *
+   * @return std::optional<T> nullopt if the queue is empty
+   */
+  std::optional<T> pop() {
+    auto pos = _dequeue.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &_cells[pos & MASK];
+      auto seq = cell->seq.load(std::memory_order_acquire);
+      auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // the cell is not pushed in this lap
+        return std::nullopt;
+      } else {
+        pos = _dequeue.load(std::memory_order_relaxed);
+      }
+    }
+    auto t = std::move(cell->value);
+    cell->seq.store(pos + N, std::memory_order_release);
+    return std::make_optional(std::move(t));
+  }
+  /**
+   * @brief the approximate number of values
+   *
+   */
+  std::size_t size() const {
+    auto dequeue = _dequeue.load(std::memory_order_acquire);
+    auto enqueue = _enqueue.load(std::memory_order_acquire);
+    return enqueue > dequeue ? enqueue - dequeue : 0;
+  }
+
+  static constexpr std::size_t capacity() noexcept { return N; }
+
+private:
+  static constexpr std::size_t MASK = N - 1;
+
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _enqueue;  ///< the next position to push
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _dequeue;  ///< the next position to pop
+  alignas(CACHE_LINE_SIZE) std::unique_ptr<Cell[]> _cells;
+};
+XSL_SYNC_NE
+#endif
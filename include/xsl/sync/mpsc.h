@@ -0,0 +1,97 @@
+#pragma once
+#ifndef XSL_SYNC_MPSC
+#  define XSL_SYNC_MPSC
+#  include "xsl/sync/def.h"
+
+#  include <atomic>
+#  include <concepts>
+XSL_SYNC_NB
+/**
+ * @brief The link of a node in MPSC
+ *
+ */
+class MPSCNode {
+public:
+  MPSCNode() noexcept : _next(nullptr) {}
+  MPSCNode(const MPSCNode&) = delete;
+  MPSCNode& operator=(const MPSCNode&) = delete;
+
+private:
+  template <class T>
+    requires std::derived_from<T, MPSCNode>
+  friend class MPSC;
+
+  std::atomic<MPSCNode*> _next;
+};
+
+/**
+ * @brief An intrusive unbounded multi-producer single-consumer queue
+ *
+ * @note push is wait free, pop is lock free but may miss a node whose push is still in progress,
+ * so the producer should notify the consumer after pushing. The nodes are owned by the caller.
+ * @tparam T the node type, derived from MPSCNode
+ */
+template <class T>
+  requires std::derived_from<T, MPSCNode>
+class MPSC {
+public:
+  MPSC() noexcept : _head(&_stub), _tail(&_stub), _stub() {}
+  MPSC(const MPSC&) = delete;
+  MPSC& operator=(const MPSC&) = delete;
+
+  void push(T* node) noexcept { this->push_node(node); }
+  /**
+   * @brief pop a node, only the consumer may call it
+   *
+   * @return T* nullptr if the queue is empty or the next push is still in progress
+   */
+  T* pop() noexcept {
+    auto tail = this->_tail;
+    auto next = tail->_next.load(std::memory_order_acquire);
+    if (tail == &this->_stub) {
+      if (next == nullptr) {
+        return nullptr;
+      }
+      this->_tail = next;
+      tail = next;
+      next = next->_next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+      this->_tail = next;
+      return static_cast<T*>(tail);
+    }
+    if (tail != this->_head.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    // tail is the last node, put the stub behind it so that it can be taken
+    this->push_node(&this->_stub);
+    next = tail->_next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      this->_tail = next;
+      return static_cast<T*>(tail);
+    }
+    return nullptr;
+  }
+  /**
+   * @brief check if the queue is empty, only the consumer may call it
+   *
+   * @note a push in progress makes the queue not empty
+   */
+  bool empty() const noexcept {
+    return this->_tail->_next.load(std::memory_order_acquire) == nullptr
+           && this->_head.load(std::memory_order_acquire) == this->_tail;
+  }
+
+private:
+  std::atomic<MPSCNode*> _head;  ///< the last pushed node, shared by producers
+  MPSCNode* _tail;               ///< the next node to pop, owned by the consumer
+  MPSCNode _stub;
+
+  void push_node(MPSCNode* node) noexcept {
+    node->_next.store(nullptr, std::memory_order_relaxed);
+    auto prev = this->_head.exchange(node, std::memory_order_acq_rel);
+    prev->_next.store(node, std::memory_order_release);
+  }
+};
+XSL_SYNC_NE
+#endif
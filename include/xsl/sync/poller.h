@@ -1,18 +1,42 @@
 #pragma once
 #ifndef XSL_NET_POLLER_
 #  define XSL_NET_POLLER_
+#  include "xsl/coro/executor.h"
 #  include "xsl/sync/def.h"
+#  include "xsl/sync/mpsc.h"
 #  include "xsl/sync/mutex.h"
+#  include "xsl/sync/timer.h"
+#  include "xsl/sync/uring.h"
 
 #  include <sys/epoll.h>
 #  include <sys/socket.h>
 #  include <sys/types.h>
 
 #  include <atomic>
+#  include <chrono>
+#  include <concepts>
 #  include <functional>
 #  include <memory>
+#  include <mutex>
+#  include <optional>
+#  include <thread>
+#  include <vector>
 XSL_SYNC_NB
 const int TIMEOUT = 100;
+const unsigned URING_ENTRIES = 4096;
+
+enum class PollEngine : uint8_t {
+  EPOLL = 0,
+  IO_URING = 1,
+};
+
+#  ifdef XSL_USE_IO_URING
+const PollEngine DEFAULT_POLL_ENGINE = PollEngine::IO_URING;
+#  else
+const PollEngine DEFAULT_POLL_ENGINE = PollEngine::EPOLL;
+#  endif
+
+std::string_view to_string(PollEngine engine);
 #  define USE_EPOLL
 #  ifdef USE_EPOLL
 enum class IOM_EVENTS : uint32_t {
@@ -67,26 +91,301 @@ concept Handler = requires(T t) {
 using PollHandler = std::function<PollHandleHint(int fd, IOM_EVENTS events)>;
 
 using HandleProxy = std::function<PollHandleHint(std::function<PollHandleHint()>&&)>;
+
+/**
+ * @brief the registration of a fd
+ *
+ * @note the poller retires the entry once it is replaced or removed, and no lookup can reach it
+ * anymore. An entry embedded in a larger object overrides retire to drop its reference instead
+ */
+class PollEntry {
+public:
+  PollEntry(IOM_EVENTS events = IOM_EVENTS::NONE) noexcept : events(events), generation(0) {}
+  PollEntry(const PollEntry&) = delete;
+  PollEntry& operator=(const PollEntry&) = delete;
+  virtual ~PollEntry() = default;
+
+  virtual PollHandleHint handle(int fd, IOM_EVENTS events) = 0;
+
+  virtual void retire() noexcept { delete this; }
+
+  IOM_EVENTS events;
+  uint32_t generation;  ///< distinguishes the registrations of a reused fd
+};
+/**
+ * @brief the entry calling a type erased handler
+ *
+ */
+class HandlerEntry final : public PollEntry {
+public:
+  HandlerEntry(IOM_EVENTS events, PollHandler&& handler) noexcept
+      : PollEntry(events), handler(std::move(handler)) {}
+
+  PollHandleHint handle(int fd, IOM_EVENTS events) override { return this->handler(fd, events); }
+
+  PollHandler handler;
+};
+
+/**
+ * @brief A fd indexed table of poll entries
+ *
+ * @note the lookup is lock free, the writers must be serialized by the caller. The replaced
+ * entries are retired and only freed by reclaim, which must not run concurrently with a lookup
+ */
+class PollTable {
+public:
+  static constexpr std::size_t SEGMENT_BITS = 10;
+  static constexpr std::size_t SEGMENT_SIZE = std::size_t{1} << SEGMENT_BITS;
+
+  PollTable();
+  PollTable(PollTable&&) = delete;
+  PollTable& operator=(PollTable&&) = delete;
+  ~PollTable();
+
+  bool in_range(int fd) const noexcept {
+    return fd >= 0 && (static_cast<std::size_t>(fd) >> SEGMENT_BITS) < this->_capacity;
+  }
+
+  PollEntry* load(int fd) const noexcept {
+    auto index = static_cast<std::size_t>(fd) >> SEGMENT_BITS;
+    if (fd < 0 || index >= this->_capacity) [[unlikely]] {
+      return nullptr;
+    }
+    auto segment = this->_segments[index].load(std::memory_order_acquire);
+    if (segment == nullptr) [[unlikely]] {
+      return nullptr;
+    }
+    return segment[fd & (SEGMENT_SIZE - 1)].load(std::memory_order_acquire);
+  }
+  /**
+   * @brief replace the entry of the fd, the old one is retired
+   *
+   * @param fd the fd
+   * @param entry the new entry, nullptr to erase
+   * @return true if the fd is in range
+   */
+  bool store(int fd, PollEntry* entry);
+  /**
+   * @brief free the retired entries
+   *
+   */
+  void reclaim();
+
+  template <std::invocable<int, PollEntry&> F>
+  void for_each(F&& f) {
+    for (std::size_t i = 0; i < this->_capacity; ++i) {
+      auto segment = this->_segments[i].load(std::memory_order_acquire);
+      if (segment == nullptr) {
+        continue;
+      }
+      for (std::size_t j = 0; j < SEGMENT_SIZE; ++j) {
+        if (auto entry = segment[j].load(std::memory_order_acquire); entry != nullptr) {
+          f(static_cast<int>((i << SEGMENT_BITS) | j), *entry);
+        }
+      }
+    }
+  }
+
+private:
+  std::size_t _capacity;  ///< the number of segments
+  std::unique_ptr<std::atomic<std::atomic<PollEntry*>*>[]> _segments;
+  std::vector<PollEntry*> _retired;
+};
+
 class Poller {
 public:
   Poller();
+  Poller(PollEngine engine);
   Poller(std::shared_ptr<HandleProxy>&& proxy);
+  /**
+   * @brief Construct a new Poller object
+   *
+   * @param engine the preferred engine, falls back to epoll if io_uring is not available
+   * @param proxy the proxy to call the handlers
+   */
+  Poller(PollEngine engine, std::shared_ptr<HandleProxy>&& proxy);
   ~Poller();
   bool valid();
+  /**
+   * @brief the engine actually in use
+   *
+   * @return PollEngine
+   */
+  PollEngine engine() const noexcept { return this->poll_engine; }
   bool add(int fd, IOM_EVENTS events, PollHandler&& handler);
+  /**
+   * @brief register the fd with an entry allocated by the caller
+   *
+   * @note the poller takes over the entry, it is retired once replaced or removed. It is visible to
+   * the polling thread before the fd is armed, and retired after the next poll if the arming fails,
+   * or at once if the fd is out of range
+   * @param fd the fd
+   * @param events the events
+   * @param entry the entry, its generation is assigned by the poller
+   * @return true if the fd is registered
+   */
+  bool add(int fd, IOM_EVENTS events, PollEntry* entry);
   bool modify(int fd, IOM_EVENTS events, std::optional<PollHandler>&& handler);
+  /**
+   * @brief poll the events and dispatch them to the handlers
+   *
+   * @note must not be called from more than one thread at the same time. It blocks until an event
+   * arrives, a timer expires, or a function is posted
+   */
   void poll();
   void remove(int fd);
+  /**
+   * @brief submit an operation to the io_uring engine
+   *
+   * @note the sqe is submitted in the next poll if called from the polling thread, otherwise it
+   * is submitted immediately
+   * @param completion the completion invoked when the operation completes
+   * @param prep the function to prepare the sqe, user_data is overwritten
+   * @return true if the operation is submitted
+   * @return false if the engine is not io_uring or the submission queue is full
+   */
+  template <std::invocable<io_uring_sqe*> Prep>
+  bool submit(Completion* completion, Prep&& prep) {
+    return this->submit(completion, std::forward<Prep>(prep), [] { return false; });
+  }
+  /**
+   * @brief submit an operation to the io_uring engine, cancelled at once if stopped meanwhile
+   *
+   * @note the stop racing with the submission would reach the kernel before the operation, so it
+   * is recorded and checked here, and the cancel is queued right after the operation
+   * @param completion the completion invoked when the operation completes
+   * @param prep the function to prepare the sqe, user_data is overwritten
+   * @param stopped called once the sqe is prepared, true if the stop is requested meanwhile
+   * @return true if the operation is submitted
+   * @return false if the engine is not io_uring or the submission queue is full
+   */
+  template <std::invocable<io_uring_sqe*> Prep, std::predicate<> Stopped>
+  bool submit(Completion* completion, Prep&& prep, Stopped&& stopped) {
+    std::lock_guard guard(this->sq_mutex);
+    auto sqe = this->acquire_sqe();
+    if (sqe == nullptr) {
+      return false;
+    }
+    std::forward<Prep>(prep)(sqe);
+    sqe->user_data = reinterpret_cast<uint64_t>(completion);
+    if (std::forward<Stopped>(stopped)()) {
+      this->queue_cancel(completion);
+    }
+    this->kick();
+    return true;
+  }
+  /**
+   * @brief cancel an operation submitted by submit
+   *
+   * @note the completion is still invoked, usually with -ECANCELED
+   * @param completion the completion of the operation
+   * @return true if the cancel request is submitted
+   */
+  bool cancel(Completion* completion);
+  /**
+   * @brief create a ring of provided buffers for the multishot receive
+   *
+   * @param count the number of buffers, must be power of 2
+   * @param size the size of every buffer
+   * @note the buffer ring shares the io_uring, so it can outlive the poller
+   * @return std::shared_ptr<BufferRing> nullptr if the engine is not io_uring or failed
+   */
+  std::shared_ptr<BufferRing> make_buffer_ring(uint16_t count, uint32_t size);
+  /**
+   * @brief arm the timer, the callback is invoked by the polling thread after the deadline
+   *
+   * @note the poll timeout is shortened to the next deadline, the poller is woken up if called from
+   * another thread
+   * @param timer the timer, rearmed if it is already armed
+   * @param deadline the deadline
+   * @return true if the timer is armed
+   */
+  bool add_timer(Timer* timer, TimerWheel::clock_type::time_point deadline);
+  /**
+   * @brief cancel the timer
+   *
+   * @param timer the timer
+   * @return true if the timer is cancelled, false if it is expired or not armed, then the callback
+   * is invoked or being invoked
+   */
+  bool remove_timer(Timer* timer);
+  /**
+   * @brief the poller polled by the current thread
+   *
+   * @return Poller* nullptr if the thread is not polling
+   */
+  static Poller* current() noexcept;
+  /**
+   * @brief check if the caller is the polling thread
+   *
+   */
+  bool in_loop() const noexcept {
+    return this->loop_thread.load(std::memory_order_relaxed) == std::this_thread::get_id();
+  }
+  /**
+   * @brief run the function on the polling thread, in the next poll
+   *
+   * @note the polling thread is woken up if called from another thread
+   * @param func the function to run
+   * @return true if the function is posted
+   * @return false if the poller is shutdown, the function is left untouched
+   */
+  bool post(_coro::move_only_function<void()>&& func);
+  /**
+   * @brief interrupt the blocking poll
+   *
+   * @note the wakeups before the polling thread notices are coalesced into one
+   */
+  void wake();
   /**
    * @brief Shutdown the poller
    *
+   * @note the armed timers are fired, the posted functions are run if called from the polling
+   * thread, otherwise when the poller is destroyed. The pending io_uring operations are cancelled
+   * and completed by the polling thread once it is woken up, or at once if called from it
    */
   void shutdown();
 
 private:
+  struct Posted : MPSCNode {
+    explicit Posted(_coro::move_only_function<void()>&& func) : func(std::move(func)) {}
+    _coro::move_only_function<void()> func;
+  };
+
   std::atomic_int fd;
-  ShardRes<std::unordered_map<int, std::shared_ptr<PollHandler>>> handlers;
+  PollTable handlers;
+  std::mutex handlers_mutex;  ///< serializes the writers of handlers
+  uint32_t generation;
+  std::atomic_bool has_retired;
   std::shared_ptr<HandleProxy> proxy;
+
+  PollEngine poll_engine;
+  std::shared_ptr<IoUring> ring;
+  std::mutex sq_mutex;
+  std::atomic<std::thread::id> loop_thread;
+  std::atomic_uint16_t next_bgid;
+
+  TimerWheel timers;
+  std::mutex timers_mutex;
+
+  MPSC<Posted> posted;
+  int wake_fd;  ///< eventfd to interrupt the poll
+  std::atomic_bool woken;
+
+  void poll_epoll(int timeout);
+  void poll_uring(int timeout);
+  int timeout();
+  void expire();
+  bool run_posted(std::size_t budget);
+  void dispatch(int fd, uint32_t generation, IOM_EVENTS events);
+  void reclaim();
+  void close_ring();
+  PollEntry* replace(int fd, PollEntry* entry);
+  bool arm(int fd, const PollEntry& entry);
+  io_uring_sqe* acquire_sqe();
+  void kick();
+  /// @brief queue the cancel of the operation, must be called with sq_mutex held
+  bool queue_cancel(Completion* completion);
 };
 
 template <Handler T, class... Args>
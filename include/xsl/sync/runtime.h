@@ -0,0 +1,121 @@
+#pragma once
+#ifndef XSL_SYNC_RUNTIME
+#  define XSL_SYNC_RUNTIME
+#  include "xsl/coro/executor.h"
+#  include "xsl/sync/def.h"
+#  include "xsl/sync/poller.h"
+
+#  include <atomic>
+#  include <cstddef>
+#  include <memory>
+#  include <thread>
+#  include <vector>
+XSL_SYNC_NB
+/**
+ * @brief A reactor owns a poller driven by one thread
+ *
+ * @note the reactor is also an executor, the coroutines detached on it are posted to its poller and
+ * resumed on its thread, so the fds they register to the poller are only touched by that thread
+ */
+class Reactor : public _coro::ExecutorBase {
+public:
+  Reactor(PollEngine engine);
+  Reactor(Reactor &&) = delete;
+  Reactor &operator=(Reactor &&) = delete;
+  ~Reactor();
+  /**
+   * @brief schedule the function to the reactor thread
+   *
+   * @note the reactor thread is woken up if called from another thread, the function is run at once
+   * if the reactor is stopped
+   * @param func the function to run
+   */
+  void schedule(_coro::move_only_function<void()> &&func) override;
+
+  const std::shared_ptr<Poller> &poller() const noexcept { return this->_poller; }
+  /**
+   * @brief check if the caller is the reactor thread
+   *
+   */
+  bool in_loop() const noexcept { return this->_poller->in_loop(); }
+  /**
+   * @brief drive the poller until stop is called
+   *
+   * @note must not be called from more than one thread at the same time
+   */
+  void run();
+  /**
+   * @brief stop the reactor, the poller is shutdown by the reactor thread
+   *
+   */
+  void stop();
+
+private:
+  std::shared_ptr<Poller> _poller;
+  std::atomic_bool _stopped;
+};
+
+/**
+ * @brief A runtime of N reactors, every reactor runs on its own thread
+ *
+ */
+class Runtime {
+public:
+  /**
+   * @brief Construct a new Runtime object
+   *
+   * @param threads the number of reactors, 0 means one per available core
+   * @param engine the preferred poll engine of every reactor
+   */
+  Runtime(std::size_t threads = 0, PollEngine engine = DEFAULT_POLL_ENGINE);
+  Runtime(Runtime &&) = delete;
+  Runtime &operator=(Runtime &&) = delete;
+  ~Runtime();
+
+  std::size_t size() const noexcept { return this->_reactors.size(); }
+
+  const std::shared_ptr<Reactor> &reactor(std::size_t idx) const noexcept {
+    return this->_reactors[idx];
+  }
+  /**
+   * @brief the cpu the reactor thread is pinned to
+   *
+   * @param idx the index of the reactor
+   * @return int the cpu, -1 if the reactor is not pinned
+   */
+  int cpu(std::size_t idx) const noexcept {
+    return idx < this->_cpus.size() ? this->_cpus[idx] : -1;
+  }
+  /**
+   * @brief pick the next reactor in round robin, used to distribute the connections
+   *
+   * @return const std::shared_ptr<Reactor>&
+   */
+  const std::shared_ptr<Reactor> &next() noexcept {
+    return this->_reactors[this->_next.fetch_add(1, std::memory_order_relaxed)
+                           % this->_reactors.size()];
+  }
+  /**
+   * @brief start the reactor threads, every thread is pinned to one core if there are enough
+   *
+   */
+  void start();
+  /**
+   * @brief stop all reactors
+   *
+   */
+  void stop();
+  /**
+   * @brief wait for all reactor threads to exit
+   *
+   */
+  void join();
+
+private:
+  std::vector<std::shared_ptr<Reactor>> _reactors;
+  std::vector<std::thread> _threads;
+  std::vector<int> _cpus;  ///< empty if the reactors are not pinned
+  std::atomic_size_t _next;
+};
+XSL_SYNC_NE
+#endif
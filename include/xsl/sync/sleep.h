@@ -0,0 +1,273 @@
+#pragma once
+#ifndef XSL_SYNC_SLEEP
+#  define XSL_SYNC_SLEEP
+#  include "xsl/coro/lazy.h"
+#  include "xsl/coro/task.h"
+#  include "xsl/logctl.h"
+#  include "xsl/sync/def.h"
+#  include "xsl/sync/poller.h"
+#  include "xsl/sync/timer.h"
+
+#  include <cassert>
+#  include <chrono>
+#  include <coroutine>
+#  include <expected>
+#  include <memory>
+#  include <mutex>
+#  include <optional>
+#  include <system_error>
+#  include <type_traits>
+#  include <utility>
+XSL_SYNC_NB
+namespace impl_sleep {
+  using clock_type = TimerWheel::clock_type;
+  using resume_type = void (*)(std::coroutine_handle<>);
+
+  template <class Promise>
+  void resume(std::coroutine_handle<> handle) {
+    auto h = std::coroutine_handle<Promise>::from_address(handle.address());
+    h.promise().resume(h);
+  }
+  /**
+   * @brief the shared state of a task racing against its deadline
+   *
+   * @note the state keeps itself alive while the timer is armed
+   */
+  template <class ResultType>
+  class Race : public Timer {
+  public:
+    using executor_type = void;
+    using result_type = std::expected<ResultType, std::errc>;
+
+    class Awaiter {
+    public:
+      using executor_type = void;
+
+      Awaiter(Race &race) : _race(race) {}
+
+      bool await_ready() {
+        std::lock_guard guard(this->_race._mtx);
+        return this->_race._result.has_value();
+      }
+
+      template <class Promise>
+      bool await_suspend(std::coroutine_handle<Promise> handle) {
+        std::lock_guard guard(this->_race._mtx);
+        if (this->_race._result.has_value()) {
+          return false;
+        }
+        this->_race._handle = handle;
+        this->_race._resume = &resume<Promise>;
+        return true;
+      }
+
+      result_type await_resume() {
+        std::lock_guard guard(this->_race._mtx);
+        return std::move(*this->_race._result);
+      }
+
+    private:
+      Race &_race;
+    };
+
+    Race(Poller &poller)
+        : Timer(&Race::on_expire),
+          _poller(poller),
+          _mtx(),
+          _result(std::nullopt),
+          _handle(),
+          _resume(nullptr),
+          _self() {}
+    /**
+     * @brief arm the deadline
+     *
+     * @param self the owner of this state
+     * @param deadline the deadline
+     * @return true if the deadline is armed
+     */
+    bool arm(std::shared_ptr<Race> self, clock_type::time_point deadline) {
+      this->_self = std::move(self);
+      if (!this->_poller.add_timer(this, deadline)) {
+        this->_self.reset();
+        return false;
+      }
+      return true;
+    }
+    /**
+     * @brief finish the race with the result of the task, ignored if the deadline has passed
+     *
+     * @param result the result of the task
+     */
+    void finish(result_type &&result) {
+      std::unique_lock guard(this->_mtx);
+      if (this->_result.has_value()) {
+        return;
+      }
+      this->_result = std::move(result);
+      auto handle = std::exchange(this->_handle, {});
+      guard.unlock();
+      if (this->_poller.remove_timer(this)) {
+        this->_self.reset();
+      }
+      if (handle) {
+        this->_resume(handle);
+      }
+    }
+
+    Awaiter operator co_await() { return Awaiter{*this}; }
+
+  private:
+    Poller &_poller;
+    std::mutex _mtx;
+    std::optional<result_type> _result;
+    std::coroutine_handle<> _handle;
+    resume_type _resume;
+    std::shared_ptr<Race> _self;
+
+    static void on_expire(Timer *self) {
+      auto race = static_cast<Race *>(self);
+      auto keep_alive = std::move(race->_self);
+      std::unique_lock guard(race->_mtx);
+      if (race->_result.has_value()) {
+        return;
+      }
+      race->_result = std::unexpected{std::errc::timed_out};
+      auto handle = std::exchange(race->_handle, {});
+      guard.unlock();
+      if (handle) {
+        race->_resume(handle);
+      }
+    }
+  };
+
+  template <class ResultType, class Awaitable>
+  _coro::Lazy<void> run(std::shared_ptr<Race<ResultType>> race, Awaitable awaitable) {
+    if constexpr (std::is_void_v<ResultType>) {
+      co_await std::move(awaitable);
+      race->finish({});
+    } else {
+      race->finish(co_await std::move(awaitable));
+    }
+  }
+}  // namespace impl_sleep
+
+/**
+ * @brief the awaiter of sleep_for and sleep_until
+ *
+ * @note the awaiter is the timer itself, so sleeping allocates nothing
+ */
+class SleepAwaiter : public Timer {
+public:
+  using executor_type = void;
+
+  SleepAwaiter(Poller *poller, impl_sleep::clock_type::time_point deadline)
+      : Timer(&SleepAwaiter::on_expire),
+        _poller(poller),
+        _deadline(deadline),
+        _handle(),
+        _resume(nullptr) {}
+
+  bool await_ready() const { return this->_deadline <= impl_sleep::clock_type::now(); }
+
+  template <class Promise>
+  bool await_suspend(std::coroutine_handle<Promise> handle) {
+    this->_handle = handle;
+    this->_resume = &impl_sleep::resume<Promise>;
+    // the timer may fire on the polling thread at once, this must not be touched afterwards
+    return this->_poller->add_timer(this, this->_deadline);
+  }
+
+  void await_resume() const noexcept {}
+
+private:
+  Poller *_poller;
+  impl_sleep::clock_type::time_point _deadline;
+  std::coroutine_handle<> _handle;
+  impl_sleep::resume_type _resume;
+
+  static void on_expire(Timer *self) {
+    auto awaiter = static_cast<SleepAwaiter *>(self);
+    awaiter->_resume(awaiter->_handle);
+  }
+};
+/**
+ * @brief sleep until the deadline
+ *
+ * @param poller the poller to arm the timer, the sleep ends early if it is shutdown
+ * @param deadline the deadline
+ * @return SleepAwaiter
+ */
+inline SleepAwaiter sleep_until(Poller &poller, impl_sleep::clock_type::time_point deadline) {
+  return SleepAwaiter{&poller, deadline};
+}
+/**
+ * @brief sleep until the deadline on the poller of the current thread
+ *
+ * @note must be called on a polling thread, such as a reactor of a Runtime, otherwise pass the
+ * poller explicitly
+ * @param deadline the deadline
+ * @return SleepAwaiter
+ */
+inline SleepAwaiter sleep_until(impl_sleep::clock_type::time_point deadline) {
+  auto poller = Poller::current();
+  assert(poller != nullptr && "not on a polling thread");
+  return SleepAwaiter{poller, deadline};
+}
+
+template <class Rep, class Period>
+SleepAwaiter sleep_for(Poller &poller, std::chrono::duration<Rep, Period> duration) {
+  return sleep_until(poller, impl_sleep::clock_type::now() + duration);
+}
+
+template <class Rep, class Period>
+SleepAwaiter sleep_for(std::chrono::duration<Rep, Period> duration) {
+  return sleep_until(impl_sleep::clock_type::now() + duration);
+}
+/**
+ * @brief await the task with a deadline
+ *
+ * @note the task is not cancelled when the deadline passes, it keeps running in the background and
+ * its result is dropped, so it must not refer to the frame of the caller
+ * @tparam Executor the executor type, default is coro::ExecutorBase
+ * @param poller the poller to arm the deadline
+ * @param awaitable the task, such as coro::Task
+ * @param deadline the deadline
+ * @return coro::Task<std::expected<result_type, std::errc>, Executor> std::errc::timed_out if the
+ * deadline passes first
+ */
+template <class Executor = _coro::ExecutorBase, class Awaitable>
+_coro::Task<std::expected<typename std::decay_t<Awaitable>::result_type, std::errc>, Executor>
+with_deadline(Poller &poller, Awaitable awaitable, impl_sleep::clock_type::time_point deadline) {
+  using result_type = typename std::decay_t<Awaitable>::result_type;
+  auto race = std::make_shared<impl_sleep::Race<result_type>>(poller);
+  if (!race->arm(race, deadline)) {
+    LOG3("Failed to arm the deadline, the poller is shutdown");
+  }
+  impl_sleep::run<result_type>(race, std::move(awaitable)).detach();
+  co_return co_await *race;
+}
+
+/**
+ * @brief await the task with a deadline armed on the poller of the current thread
+ *
+ * @note must be called on a polling thread, such as a reactor of a Runtime
+ */
+template <class Executor = _coro::ExecutorBase, class Awaitable>
+decltype(auto) with_deadline(Awaitable awaitable, impl_sleep::clock_type::time_point deadline) {
+  return with_deadline<Executor>(*Poller::current(), std::move(awaitable), deadline);
+}
+
+template <class Executor = _coro::ExecutorBase, class Awaitable, class Rep, class Period>
+decltype(auto) with_timeout(Poller &poller, Awaitable awaitable,
+                            std::chrono::duration<Rep, Period> timeout) {
+  return with_deadline<Executor>(poller, std::move(awaitable),
+                                 impl_sleep::clock_type::now() + timeout);
+}
+
+template <class Executor = _coro::ExecutorBase, class Awaitable, class Rep, class Period>
+decltype(auto) with_timeout(Awaitable awaitable, std::chrono::duration<Rep, Period> timeout) {
+  return with_deadline<Executor>(*Poller::current(), std::move(awaitable),
+                                 impl_sleep::clock_type::now() + timeout);
+}
+XSL_SYNC_NE
+#endif
@@ -3,49 +3,126 @@
 #  define XSL_WHEEL_SPSC
 #  include "xsl/sync/def.h"
 
+#  include <algorithm>
 #  include <atomic>
 #  include <cstddef>
 #  include <optional>
+#  include <utility>
 XSL_SYNC_NB
+/**
+ * @brief A bounded single-producer single-consumer queue
+ *
+ * @note the indices of both sides live in their own cache lines, and every side caches the index of
+ * the other one, so it only reloads it when the queue looks full or empty. push_n and pop_n move a
+ * batch with one index update
+ * @tparam T the element type
+ * @tparam N the capacity, must be power of 2
+ */
 template <class T, std::size_t N = 1024>
 class SPSC {
 public:
-  static_assert(N > 0, "SPSC buffer size must be greater than 1");
+  static_assert(N > 0 && (N & (N - 1)) == 0, "SPSC capacity must be power of 2");
 
-  SPSC() : _buffer(), _head(0), _tail(0) {}
+  SPSC() : _head(0), _tail_cache(0), _tail(0), _head_cache(0), _buffer() {}
+  SPSC(const SPSC&) = delete;
+  SPSC& operator=(const SPSC&) = delete;
   ~SPSC() {}
-
+  /**
+   * @brief push the value, only the producer may call it
+   *
+   * @return true if pushed, false if the queue is full
+   */
   bool push(T&& t) {
     auto head = _head.load(std::memory_order_relaxed);
-    auto next_head = (head + 1) % (N + 1);
-    if (next_head == _tail.load(std::memory_order_acquire)) {
-      return false;
+    if (head - _tail_cache == N) {
+      _tail_cache = _tail.load(std::memory_order_acquire);
+      if (head - _tail_cache == N) {
+        return false;
+      }
     }
-    _buffer[head] = std::move(t);
-    _head.store(next_head, std::memory_order_release);
+    _buffer[head & MASK] = std::move(t);
+    _head.store(head + 1, std::memory_order_release);
     return true;
   }
-
+  /**
+   * @brief push as many values as possible, only the producer may call it
+   *
+   * @param first the first value, the values are moved from
+   * @param n the number of values
+   * @return std::size_t the number of values pushed
+   */
+  template <class InputIt>
+  std::size_t push_n(InputIt first, std::size_t n) {
+    auto head = _head.load(std::memory_order_relaxed);
+    if (N - (head - _tail_cache) < n) {
+      _tail_cache = _tail.load(std::memory_order_acquire);
+    }
+    auto count = std::min(n, N - (head - _tail_cache));
+    for (std::size_t i = 0; i < count; ++i, ++first) {
+      _buffer[(head + i) & MASK] = std::move(*first);
+    }
+    if (count != 0) {
+      _head.store(head + count, std::memory_order_release);
+    }
+    return count;
+  }
+  /**
+   * @brief pop a value, only the consumer may call it
+   *
+   * @return std::optional<T> nullopt if the queue is empty
+   */
   std::optional<T> pop() {
     auto tail = _tail.load(std::memory_order_relaxed);
-    if (tail == _head.load(std::memory_order_acquire)) {
-      return std::nullopt;
+    if (tail == _head_cache) {
+      _head_cache = _head.load(std::memory_order_acquire);
+      if (tail == _head_cache) {
+        return std::nullopt;
+      }
     }
-    auto t = std::move(_buffer[tail]);
-    _tail.store((tail + 1) % (N + 1), std::memory_order_release);
+    auto t = std::move(_buffer[tail & MASK]);
+    _tail.store(tail + 1, std::memory_order_release);
     return std::make_optional(std::move(t));
   }
+  /**
+   * @brief pop as many values as possible, only the consumer may call it
+   *
+   * @param out the output iterator
+   * @param n the max number of values
+   * @return std::size_t the number of values popped
+   */
+  template <class OutputIt>
+  std::size_t pop_n(OutputIt out, std::size_t n) {
+    auto tail = _tail.load(std::memory_order_relaxed);
+    if (_head_cache - tail < n) {
+      _head_cache = _head.load(std::memory_order_acquire);
+    }
+    auto count = std::min(n, _head_cache - tail);
+    for (std::size_t i = 0; i < count; ++i, ++out) {
+      *out = std::move(_buffer[(tail + i) & MASK]);
+    }
+    if (count != 0) {
+      _tail.store(tail + count, std::memory_order_release);
+    }
+    return count;
+  }
 
   std::size_t size() const {
-    auto head = _head.load(std::memory_order_relaxed);
-    auto tail = _tail.load(std::memory_order_relaxed);
-    return (head + N + 1 - tail) % (N + 1);
+    // the tail first, so it is never ahead of the head
+    auto tail = _tail.load(std::memory_order_acquire);
+    auto head = _head.load(std::memory_order_acquire);
+    return head - tail;
   }
 
+  static constexpr std::size_t capacity() noexcept { return N; }
+
 private:
-  T _buffer[N];
-  std::atomic<std::size_t> _head;
-  std::atomic<std::size_t> _tail;
+  static constexpr std::size_t MASK = N - 1;
+
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _head;  ///< the next slot to push
+  std::size_t _tail_cache;                                  ///< the tail last seen by the producer
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _tail;  ///< the next slot to pop
+  std::size_t _head_cache;                                  ///< the head last seen by the consumer
+  alignas(CACHE_LINE_SIZE) T _buffer[N];
 };
 XSL_SYNC_NE
 #endif
@@ -0,0 +1,132 @@
+#pragma once
+#ifndef XSL_SYNC_TIMER
+#  define XSL_SYNC_TIMER
+#  include "xsl/sync/def.h"
+
+#  include <array>
+#  include <chrono>
+#  include <cstddef>
+#  include <cstdint>
+XSL_SYNC_NB
+/**
+ * @brief A timer armed in a TimerWheel
+ *
+ * @note the timer is intrusive, it must stay alive and must not move while it is armed
+ */
+class Timer {
+public:
+  using callback_type = void (*)(Timer *self);
+
+  explicit Timer(callback_type cb) noexcept
+      : _prev(nullptr), _next(nullptr), _expiry(0), _cb(cb), _level(0), _slot(0), _armed(false) {}
+  Timer(const Timer &) = delete;
+  Timer &operator=(const Timer &) = delete;
+
+  bool armed() const noexcept { return this->_armed; }
+
+  void fire() { this->_cb(this); }
+
+private:
+  friend class TimerWheel;
+
+  Timer *_prev;
+  Timer *_next;
+  uint64_t _expiry;  ///< the tick to fire
+  callback_type _cb;
+  uint8_t _level;
+  uint8_t _slot;
+  bool _armed;
+};
+
+/**
+ * @brief A hierarchical timing wheel with millisecond ticks, arm and cancel are O(1)
+ *
+ * @note not thread safe. The first level has 256 slots of one tick, every other level has 64
+ * slots of the whole span of the level below, so the wheel covers 2^32 ticks, the later timers are
+ * clamped to that.
+ */
+class TimerWheel {
+public:
+  using clock_type = std::chrono::steady_clock;
+
+  static constexpr std::size_t LEVELS = 5;
+  static constexpr std::size_t ROOT_BITS = 8;
+  static constexpr std::size_t LEVEL_BITS = 6;
+  static constexpr std::size_t ROOT_SIZE = std::size_t{1} << ROOT_BITS;
+  static constexpr std::size_t LEVEL_SIZE = std::size_t{1} << LEVEL_BITS;
+  static constexpr uint64_t MAX_TICKS
+      = (uint64_t{1} << (ROOT_BITS + LEVEL_BITS * (LEVELS - 1))) - 1;
+
+  TimerWheel();
+  TimerWheel(TimerWheel &&) = delete;
+  TimerWheel &operator=(TimerWheel &&) = delete;
+  ~TimerWheel();
+  /**
+   * @brief the tick of the time point, rounded up so that no timer fires early
+   *
+   * @param tp the time point
+   * @return uint64_t
+   */
+  uint64_t tick(clock_type::time_point tp) const noexcept;
+
+  bool empty() const noexcept { return this->_count == 0; }
+
+  std::size_t size() const noexcept { return this->_count; }
+  /**
+   * @brief arm the timer, rearm it if it is already armed
+   *
+   * @param timer the timer
+   * @param deadline the deadline, the timer fires in the next advance if it is passed
+   */
+  void arm(Timer *timer, clock_type::time_point deadline);
+  /**
+   * @brief cancel the timer
+   *
+   * @param timer the timer
+   * @return true if the timer is cancelled before it is expired
+   */
+  bool cancel(Timer *timer) noexcept;
+  /**
+   * @brief advance the wheel to the time point
+   *
+   * @param now the time point
+   * @return Timer* the expired timers, linked by next(), they are disarmed but not fired
+   */
+  Timer *advance(clock_type::time_point now);
+  /**
+   * @brief disarm all timers
+   *
+   * @return Timer* the disarmed timers, linked like the result of advance
+   */
+  Timer *clear() noexcept;
+  /**
+   * @brief the next expired timer of the chain returned by advance
+   *
+   */
+  static Timer *next(Timer *timer) noexcept { return timer->_next; }
+  /**
+   * @brief the time until the wheel has to be advanced
+   *
+   * @param now the time point
+   * @param max the max timeout in milliseconds
+   * @return int the timeout in milliseconds, at most max, -1 if max is -1 and no timer is armed
+   */
+  int timeout(clock_type::time_point now, int max) const noexcept;
+
+private:
+  clock_type::time_point _epoch;
+  uint64_t _current;  ///< the next tick to process
+  std::size_t _count;
+  std::array<Timer *, ROOT_SIZE> _root;
+  std::array<std::array<Timer *, LEVEL_SIZE>, LEVELS - 1> _levels;
+  std::array<uint64_t, ROOT_SIZE / 64> _root_bits;  ///< the non-empty slots of the root level
+  std::array<uint64_t, LEVELS - 1> _level_bits;
+
+  uint64_t elapsed(clock_type::time_point now) const noexcept;
+  Timer *&slot(uint8_t level, uint8_t slot) noexcept;
+  void link(Timer *timer);
+  void unlink(Timer *timer) noexcept;
+  void cascade(uint8_t level, uint8_t slot);
+};
+XSL_SYNC_NE
+#endif
@@ -0,0 +1,244 @@
+#pragma once
+#ifndef XSL_SYNC_URING
+#  define XSL_SYNC_URING
+#  include "xsl/sync/def.h"
+
+#  include <linux/io_uring.h>
+#  include <signal.h>
+#  include <sys/socket.h>
+
+#  include <atomic>
+#  include <concepts>
+#  include <cstddef>
+#  include <cstdint>
+#  include <memory>
+#  include <mutex>
+#  include <span>
+XSL_SYNC_NB
+/**
+ * @brief Completion of an operation submitted to the io_uring engine
+ *
+ * @note the completion is intrusive, the object is used as the user_data of the sqe, so it must
+ * stay alive and must not move until the callback is invoked
+ */
+class alignas(8) Completion {
+public:
+  using callback_type = void (*)(Completion *self, int res, uint32_t flags);
+
+  explicit Completion(callback_type cb) noexcept : _cb(cb) {}
+  Completion(const Completion &) = delete;
+  Completion &operator=(const Completion &) = delete;
+
+  void complete(int res, uint32_t flags) { this->_cb(this, res, flags); }
+
+private:
+  callback_type _cb;
+};
+
+/**
+ * @brief A minimal io_uring instance, talks to the kernel directly without liburing
+ *
+ * @note not thread safe, the owner must serialize the access to the submission queue, the
+ * completion queue must be consumed by only one thread
+ */
+class IoUring {
+public:
+  IoUring(unsigned entries);
+  IoUring(IoUring &&) = delete;
+  IoUring &operator=(IoUring &&) = delete;
+  ~IoUring();
+
+  bool valid() const noexcept { return this->_fd != -1; }
+
+  int raw() const noexcept { return this->_fd; }
+  /**
+   * @brief get a free sqe
+   *
+   * @return io_uring_sqe* the zeroed sqe, nullptr if the submission queue is full
+   */
+  io_uring_sqe *get_sqe() noexcept;
+  /**
+   * @brief publish the prepared sqes to the kernel
+   *
+   * @return unsigned the number of sqes waiting to be consumed by the kernel
+   */
+  unsigned flush() noexcept;
+  /**
+   * @brief enter the kernel to submit sqes and/or wait for completions
+   *
+   * @param to_submit the number of sqes to submit, usually the return value of flush
+   * @param wait_nr the number of completions to wait for
+   * @param timeout_ms the timeout in milliseconds, -1 means no timeout
+   * @param mask the signal mask applied while waiting
+   * @return int the number of consumed sqes, or -errno
+   */
+  int enter(unsigned to_submit, unsigned wait_nr, int timeout_ms = -1,
+            const sigset_t *mask = nullptr) noexcept;
+  /**
+   * @brief consume all ready cqes
+   *
+   * @param f the callback for every cqe, the cqe is released before the callback is invoked
+   * @return unsigned the number of consumed cqes
+   */
+  template <std::invocable<const io_uring_cqe &> F>
+  unsigned for_each_cqe(F &&f) {
+    auto head = std::atomic_ref(*this->_cq_head).load(std::memory_order_relaxed);
+    auto tail = std::atomic_ref(*this->_cq_tail).load(std::memory_order_acquire);
+    unsigned count = 0;
+    while (head != tail) {
+      io_uring_cqe cqe = this->_cqes[head & this->_cq_mask];
+      std::atomic_ref(*this->_cq_head).store(++head, std::memory_order_release);
+      f(cqe);
+      ++count;
+      if (head == tail) {
+        tail = std::atomic_ref(*this->_cq_tail).load(std::memory_order_acquire);
+      }
+    }
+    return count;
+  }
+
+  int register_buf_ring(io_uring_buf_ring *ring, unsigned entries, uint16_t bgid) noexcept;
+
+  int unregister_buf_ring(uint16_t bgid) noexcept;
+
+private:
+  int _fd;
+  uint32_t _features;
+
+  void *_sq_ptr;
+  std::size_t _sq_size;
+  void *_cq_ptr;
+  std::size_t _cq_size;
+  io_uring_sqe *_sqes;
+  std::size_t _sqes_size;
+
+  unsigned *_sq_head;
+  unsigned *_sq_tail;
+  unsigned *_sq_array;
+  unsigned _sq_mask;
+  unsigned _sq_entries;
+  unsigned _sqe_head;  ///< the first prepared but unpublished sqe
+  unsigned _sqe_tail;  ///< the next free sqe
+
+  unsigned *_cq_head;
+  unsigned *_cq_tail;
+  io_uring_cqe *_cqes;
+  unsigned _cq_mask;
+};
+
+/**
+ * @brief A ring of provided buffers, used by the multishot receive
+ *
+ * @note the buffer ring shares the io_uring, it is unregistered before the io_uring is closed
+ */
+class BufferRing {
+public:
+  /**
+   * @brief Construct a new Buffer Ring object
+   *
+   * @param ring the io_uring to register to
+   * @param bgid the buffer group id
+   * @param count the number of buffers, must be power of 2
+   * @param size the size of every buffer
+   */
+  BufferRing(std::shared_ptr<IoUring> ring, uint16_t bgid, uint16_t count, uint32_t size);
+  BufferRing(BufferRing &&) = delete;
+  BufferRing &operator=(BufferRing &&) = delete;
+  ~BufferRing();
+
+  bool valid() const noexcept { return this->_br != nullptr; }
+
+  uint16_t group() const noexcept { return this->_bgid; }
+  /**
+   * @brief get the data of the selected buffer
+   *
+   * @param bid the buffer id, from the cqe flags
+   * @param len the length of the valid data
+   * @return std::span<std::byte>
+   */
+  std::span<std::byte> buffer(uint16_t bid, std::size_t len) noexcept {
+    return {this->_bufs + static_cast<std::size_t>(bid) * this->_size, len};
+  }
+  /**
+   * @brief give the buffer back to the kernel
+   *
+   * @param bid the buffer id
+   */
+  void recycle(uint16_t bid) noexcept;
+
+private:
+  std::shared_ptr<IoUring> _ring;
+  io_uring_buf_ring *_br;
+  std::byte *_bufs;
+  uint16_t _bgid;
+  uint16_t _count;
+  uint32_t _size;
+  uint16_t _tail;
+  std::mutex _mtx;
+
+  void push(uint16_t bid) noexcept;
+};
+
+inline void prep_rw(io_uring_sqe *sqe, uint8_t op, int fd, const void *addr, uint32_t len,
+                    uint64_t off) noexcept {
+  sqe->opcode = op;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(addr);
+  sqe->len = len;
+  sqe->off = off;
+}
+
+inline void prep_poll_add(io_uring_sqe *sqe, int fd, uint32_t events, bool multishot) noexcept {
+  prep_rw(sqe, IORING_OP_POLL_ADD, fd, nullptr, multishot ? IORING_POLL_ADD_MULTI : 0, 0);
+  sqe->poll32_events = events;
+}
+
+inline void prep_poll_remove(io_uring_sqe *sqe, uint64_t user_data) noexcept {
+  prep_rw(sqe, IORING_OP_POLL_REMOVE, -1, nullptr, 0, 0);
+  sqe->addr = user_data;
+}
+
+inline void prep_cancel(io_uring_sqe *sqe, uint64_t user_data, uint32_t flags) noexcept {
+  prep_rw(sqe, IORING_OP_ASYNC_CANCEL, -1, nullptr, 0, 0);
+  sqe->addr = user_data;
+  sqe->cancel_flags = flags;
+}
+
+inline void prep_recv(io_uring_sqe *sqe, int fd, void *buf, std::size_t len, int flags) noexcept {
+  prep_rw(sqe, IORING_OP_RECV, fd, buf, static_cast<uint32_t>(len), 0);
+  sqe->msg_flags = static_cast<uint32_t>(flags);
+}
+
+inline void prep_recv_multishot(io_uring_sqe *sqe, int fd, uint16_t bgid, int flags) noexcept {
+  prep_rw(sqe, IORING_OP_RECV, fd, nullptr, 0, 0);
+  sqe->msg_flags = static_cast<uint32_t>(flags);
+  sqe->ioprio |= IORING_RECV_MULTISHOT;
+  sqe->flags |= IOSQE_BUFFER_SELECT;
+  sqe->buf_group = bgid;
+}
+
+inline void prep_send(io_uring_sqe *sqe, int fd, const void *buf, std::size_t len,
+                      int flags) noexcept {
+  prep_rw(sqe, IORING_OP_SEND, fd, buf, static_cast<uint32_t>(len), 0);
+  sqe->msg_flags = static_cast<uint32_t>(flags);
+}
+
+inline void prep_accept(io_uring_sqe *sqe, int fd, sockaddr *addr, socklen_t *addrlen, int flags,
+                        bool multishot) noexcept {
+  prep_rw(sqe, IORING_OP_ACCEPT, fd, addr, 0, reinterpret_cast<uint64_t>(addrlen));
+  sqe->accept_flags = static_cast<uint32_t>(flags);
+  if (multishot) {
+    sqe->ioprio |= IORING_ACCEPT_MULTISHOT;
+  }
+}
+
+inline void prep_splice(io_uring_sqe *sqe, int fd_in, int64_t off_in, int fd_out, int64_t off_out,
+                        std::size_t len, unsigned flags) noexcept {
+  prep_rw(sqe, IORING_OP_SPLICE, fd_out, nullptr, static_cast<uint32_t>(len),
+          static_cast<uint64_t>(off_out));
+  sqe->splice_off_in = static_cast<uint64_t>(off_in);
+  sqe->splice_fd_in = fd_in;
+  sqe->splice_flags = flags;
+}
+XSL_SYNC_NE
+#endif
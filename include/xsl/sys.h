@@ -16,9 +16,13 @@ namespace net {
   using sys::net::SERVER_FLAGS;
 }  // namespace net
 namespace sys::tcp {
+  using sys::net::attach_reuseport_cbpf;
   using sys::net::bind;
   using sys::net::connect;
+  using sys::net::connect_for;
+  using sys::net::connect_until;
   using sys::net::listen;
+  using sys::net::set_incoming_cpu;
 }  // namespace sys::tcp
 XSL_NE
 #endif
@@ -22,6 +22,12 @@ public:
     return *this;
   }
   int raw() const noexcept { return _fd; }
+  /**
+   * @brief give up the ownership of the fd
+   *
+   * @return int the fd, the caller must close it
+   */
+  int release() noexcept { return std::exchange(_fd, -1); }
 
   ~NativeDevice() noexcept {
     if (_fd == -1) {
@@ -60,6 +66,16 @@ protected:
     auto dev = std::move(_dev);
     return {dev, dev};
   }
+  /**
+   * @brief take the fd out of the device
+   *
+   * @note the fd is duplicated if the other half of a split device still refers to it
+   * @return int the fd, the caller must close it
+   */
+  int release() && noexcept {
+    auto dev = std::move(_dev);
+    return dev.use_count() == 1 ? dev->release() : ::dup(dev->raw());
+  }
 };
 
 namespace impl_dev {
@@ -1,10 +1,15 @@
 #pragma once
 #ifndef XSL_SYS_NET_ACCEPT
 #  define XSL_SYS_NET_ACCEPT
+#  include "xsl/coro/semaphore.h"
 #  include "xsl/sys/net/def.h"
+#  include "xsl/sys/net/io.h"
 #  include "xsl/sys/net/socket.h"
 
+#  include <concepts>
 #  include <expected>
+#  include <stop_token>
+#  include <system_error>
 XSL_SYS_NET_NB
 
 template <class Traits>
@@ -26,5 +31,65 @@ std::expected<S, std::errc> accept(S &socket, SockAddr *addr) {
   // }
   return S(tmp_fd);
 }
+/**
+ * @brief the awaiter accepting a connection, the accept is tried before suspending
+ *
+ * @tparam S the socket type of the accepted connection
+ */
+template <SocketLike S>
+class AcceptAwaiter : public impl_io::ReadyAwaiter<AcceptAwaiter<S>> {
+  using Base = impl_io::ReadyAwaiter<AcceptAwaiter<S>>;
+
+public:
+  AcceptAwaiter(int fd, coro::CountingSemaphore<1> &sem, SockAddr *addr, std::stop_token token)
+      : Base(sem, std::move(token)),
+        _fd(fd),
+        _addr(addr),
+        _result(std::unexpected{std::errc::operation_canceled}) {}
+
+  std::expected<S, std::errc> await_resume() noexcept {
+    this->finish();
+    return this->_result.transform([](int fd) { return S(fd); });
+  }
+
+private:
+  friend Base;
+
+  int _fd;
+  SockAddr *_addr;
+  std::expected<int, std::errc> _result;
+
+  bool attempt() {
+    auto [sockaddr, addrlen] = this->_addr == nullptr ? SockAddr::null() : this->_addr->raw();
+    int tmp_fd = ::accept4(this->_fd, sockaddr, addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (tmp_fd >= 0) {
+      LOG5("accept socket {}", tmp_fd);
+      this->_result = tmp_fd;
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return false;
+    } else {
+      this->_result = std::unexpected{std::errc(errno)};
+    }
+    return true;
+  }
+
+  void fail(std::errc err) { this->_result = std::unexpected{err}; }
+};
+/**
+ * @brief accept a connection without a coroutine frame
+ *
+ * @param listener the listening socket registered to the poller
+ * @param addr the address of the peer, can be nullptr
+ * @param token the stop token
+ * @return AcceptAwaiter<Socket<...>> resumes with the accepted socket
+ */
+template <SocketLike A>
+  requires requires(A &a) {
+    { a.read_sem() } -> std::convertible_to<coro::CountingSemaphore<1> &>;
+  }
+AcceptAwaiter<Socket<typename A::socket_traits_type>> async_accept(A &listener, SockAddr *addr,
+                                                                   std::stop_token token = {}) {
+  return {listener.raw(), listener.read_sem(), addr, std::move(token)};
+}
 XSL_SYS_NET_NE
 #endif
@@ -0,0 +1,170 @@
+#pragma once
+#ifndef XSL_SYS_NET_BLOCK
+#  define XSL_SYS_NET_BLOCK
+#  include "xsl/coro/semaphore.h"
+#  include "xsl/logctl.h"
+#  include "xsl/sync/poller.h"
+#  include "xsl/sys/net/def.h"
+
+#  include <unistd.h>
+
+#  include <atomic>
+#  include <cerrno>
+#  include <cstdint>
+#  include <expected>
+#  include <system_error>
+#  include <utility>
+XSL_SYS_NET_NB
+namespace impl_block {
+  /**
+   * @brief the control block of a socket registered to the poller
+   *
+   * @note the fd, the readiness semaphores and the poll entry share one allocation. The users are
+   * the devices, they hold one reference together, and the poller holds another one while the
+   * entry is not retired. The socket is removed from the poller and closed with the last user, the
+   * block is freed with the last reference
+   * @tparam PollTraits the traits checking the events, such as sync::PollTraits
+   */
+  template <class PollTraits>
+  class Block final : public sync::PollEntry {
+  public:
+    using sem_type = coro::CountingSemaphore<1>;
+
+    Block(int fd) noexcept
+        : PollEntry(), read_sem(), write_sem(), _fd(fd), _poller(nullptr), _users(1), _refs(1) {}
+    /**
+     * @brief register the socket to the poller
+     *
+     * @param poller the poller
+     * @param events the events, the readable and writable events release the semaphores
+     * @return the error of the registration, the errno of the poller if any
+     */
+    std::expected<void, std::errc> attach(sync::Poller &poller, sync::IOM_EVENTS events) {
+      this->_poller.store(&poller, std::memory_order_release);
+      // the poller takes the reference even if it fails, it is dropped by retire then
+      this->_refs.fetch_add(1, std::memory_order_relaxed);
+      errno = 0;
+      if (!poller.add(this->_fd, events, this)) {
+        // the fd out of range or the submission queue full sets no errno
+        auto err = errno != 0 ? std::errc{errno} : std::errc::bad_file_descriptor;
+        LOG3("Failed to register fd: {}", this->_fd);
+        this->_poller.store(nullptr, std::memory_order_release);
+        return std::unexpected{err};
+      }
+      return {};
+    }
+
+    int raw() const noexcept { return this->_fd; }
+
+    void acquire() noexcept { this->_users.fetch_add(1, std::memory_order_relaxed); }
+
+    void release() noexcept {
+      if (this->_users.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+      }
+      // removed before closed, otherwise the fd may be reused and registered by others
+      if (auto poller = this->_poller.exchange(nullptr, std::memory_order_acq_rel);
+          poller != nullptr) {
+        poller->remove(this->_fd);
+      }
+      LOG6("close fd: {}", this->_fd);
+      ::close(this->_fd);
+      this->unref();
+    }
+
+    sync::PollHandleHint handle(int, sync::IOM_EVENTS events) override {
+      if (!events) {
+        // the poller is shutting down and drops the entry
+        this->_poller.store(nullptr, std::memory_order_release);
+        this->read_sem.release(false);
+        this->write_sem.release(false);
+        return sync::PollHandleHintTag::DELETE;
+      }
+      // a hang up wakes both sides, the retried syscalls report it. The entry is kept until the
+      // last user removes it, otherwise the poller may remove the fd while it is being closed
+      bool hang_up = PollTraits::poll_check(events) == sync::PollHandleHintTag::DELETE;
+      if (hang_up || !!(events & sync::IOM_EVENTS::IN)) {
+        this->read_sem.release();
+      }
+      // the error queue, such as the completions of the zero copy sends, wakes the writer
+      if (hang_up || !!(events & (sync::IOM_EVENTS::OUT | sync::IOM_EVENTS::ERR))) {
+        this->write_sem.release();
+      }
+      return sync::PollHandleHintTag::NONE;
+    }
+
+    void retire() noexcept override { this->unref(); }
+
+    sem_type read_sem;
+    sem_type write_sem;
+
+  private:
+    int _fd;
+    std::atomic<sync::Poller *> _poller;  ///< null once the entry is dropped by the poller
+    std::atomic_uint32_t _users;
+    std::atomic_uint32_t _refs;
+
+    void unref() noexcept {
+      if (this->_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+      }
+    }
+  };
+}  // namespace impl_block
+/**
+ * @brief the reference of a user to the control block of a socket
+ *
+ * @note copying adds a user, the halves of a split device refer to the same block
+ * @tparam PollTraits the traits checking the events
+ */
+template <class PollTraits>
+class BlockRef {
+  using block_type = impl_block::Block<PollTraits>;
+
+public:
+  using sem_type = typename block_type::sem_type;
+  /**
+   * @brief create the block owning the fd and register it
+   *
+   * @param fd the fd, closed with the last user, so it is closed on failure too
+   * @param poller the poller
+   * @param events the events to poll
+   * @return the reference, or the error of the registration
+   */
+  static std::expected<BlockRef, std::errc> create(int fd, sync::Poller &poller,
+                                                   sync::IOM_EVENTS events) {
+    BlockRef ref{new block_type(fd)};
+    if (auto res = ref._block->attach(poller, events); !res) {
+      return std::unexpected{res.error()};
+    }
+    return ref;
+  }
+  BlockRef(const BlockRef &rhs) noexcept : _block(rhs._block) {
+    if (this->_block != nullptr) {
+      this->_block->acquire();
+    }
+  }
+  BlockRef(BlockRef &&rhs) noexcept : _block(std::exchange(rhs._block, nullptr)) {}
+  BlockRef &operator=(BlockRef rhs) noexcept {
+    std::swap(this->_block, rhs._block);
+    return *this;
+  }
+  ~BlockRef() noexcept {
+    if (this->_block != nullptr) {
+      this->_block->release();
+    }
+  }
+
+  int raw() const noexcept { return this->_block->raw(); }
+
+  sem_type &read_sem() const noexcept { return this->_block->read_sem; }
+
+  sem_type &write_sem() const noexcept { return this->_block->write_sem; }
+
+private:
+  block_type *_block;
+
+  explicit BlockRef(block_type *block) noexcept : _block(block) {}
+};
+XSL_SYS_NET_NE
+#endif
@@ -15,12 +15,18 @@
 #  define XSL_SYS_NET_DEV
 #  include "xsl/ai/dev.h"
 #  include "xsl/feature.h"
+#  include "xsl/sync/deadline.h"
 #  include "xsl/sys/io/dev.h"
+#  include "xsl/sys/net/block.h"
 #  include "xsl/sys/net/def.h"
 #  include "xsl/sys/net/io.h"
+#  include "xsl/sys/net/uring.h"
 
 #  include <cassert>
+#  include <chrono>
 #  include <cstddef>
+#  include <expected>
+#  include <stop_token>
 #  include <tuple>
 
 XSL_SYS_NET_NB
@@ -59,13 +65,17 @@ namespace impl_dev {
     @brief convert to AsyncDevice
 
     @param poller
-    @return AsyncDeviceCompose<feature::In<T>>, aka AsyncDevice<feature::In<T>>
+    @return AsyncDeviceCompose<feature::In<T>>, aka AsyncDevice<feature::In<T>>, or the error
+    of the registration, the socket is closed then
      */
-    inline AsyncDeviceCompose<feature::In<Traits>> async(sync::Poller &poller) && noexcept {
-      auto sem = std::make_shared<coro::CountingSemaphore<1>>();
-      poller.add(this->raw(), sync::IOM_EVENTS::IN | sync::IOM_EVENTS::ET,
-                 sync::PollCallback<typename Traits::poll_traits, sync::IOM_EVENTS::IN>{sem});
-      return {std::move(sem), std::move(*this)};
+    inline std::expected<AsyncDeviceCompose<feature::In<Traits>>, std::errc> async(
+        sync::Poller &poller) && noexcept {
+      auto block = BlockRef<typename Traits::poll_traits>::create(
+          std::move(*this).Base::release(), poller, sync::IOM_EVENTS::IN | sync::IOM_EVENTS::ET);
+      if (!block) {
+        return std::unexpected{block.error()};
+      }
+      return AsyncDeviceCompose<feature::In<Traits>>{&poller, std::move(*block)};
     }
   };
 
@@ -85,13 +95,17 @@ namespace impl_dev {
     @brief convert to AsyncDevice
 
     @param poller
-    @return AsyncDeviceCompose<feature::Out<T>>, aka AsyncDevice<feature::Out<T>>
+    @return AsyncDeviceCompose<feature::Out<T>>, aka AsyncDevice<feature::Out<T>>, or the error
+    of the registration, the socket is closed then
      */
-    inline AsyncDeviceCompose<feature::Out<Traits>> async(sync::Poller &poller) && noexcept {
-      auto sem = std::make_shared<coro::CountingSemaphore<1>>();
-      poller.add(this->raw(), sync::IOM_EVENTS::OUT | sync::IOM_EVENTS::ET,
-                 sync::PollCallback<typename Traits::poll_traits, sync::IOM_EVENTS::OUT>{sem});
-      return {std::move(sem), std::move(*this)};
+    inline std::expected<AsyncDeviceCompose<feature::Out<Traits>>, std::errc> async(
+        sync::Poller &poller) && noexcept {
+      auto block = BlockRef<typename Traits::poll_traits>::create(
+          std::move(*this).Base::release(), poller, sync::IOM_EVENTS::OUT | sync::IOM_EVENTS::ET);
+      if (!block) {
+        return std::unexpected{block.error()};
+      }
+      return AsyncDeviceCompose<feature::Out<Traits>>{&poller, std::move(*block)};
     }
   };
 
@@ -118,16 +132,20 @@ namespace impl_dev {
     /**
     @brief convert to AsyncDevice
 
+    @note the fd, the semaphores and the poll entry are allocated in one control block
     @param poller
-    @return AsyncDeviceCompose<feature::InOut<T>>, aka AsyncDevice<feature::InOut<T>>
+    @return AsyncDeviceCompose<feature::InOut<T>>, aka AsyncDevice<feature::InOut<T>>, or the
+    error of the registration, the socket is closed then
      */
-    inline AsyncDeviceCompose<feature::InOut<Traits>> async(sync::Poller &poller) && noexcept {
-      auto read_sem = std::make_shared<coro::CountingSemaphore<1>>();
-      auto write_sem = std::make_shared<coro::CountingSemaphore<1>>();
-      poller.add(this->raw(), sync::IOM_EVENTS::IN | sync::IOM_EVENTS::OUT | sync::IOM_EVENTS::ET,
-                 sync::PollCallback<typename Traits::poll_traits, sync::IOM_EVENTS::IN,
-                                    sync::IOM_EVENTS::OUT>{read_sem, write_sem});
-      return {std::move(read_sem), std::move(write_sem), std::move(*this)};
+    inline std::expected<AsyncDeviceCompose<feature::InOut<Traits>>, std::errc> async(
+        sync::Poller &poller) && noexcept {
+      auto block = BlockRef<typename Traits::poll_traits>::create(
+          std::move(*this).Base::release(), poller,
+          sync::IOM_EVENTS::IN | sync::IOM_EVENTS::OUT | sync::IOM_EVENTS::ET);
+      if (!block) {
+        return std::unexpected{block.error()};
+      }
+      return AsyncDeviceCompose<feature::InOut<Traits>>{&poller, std::move(*block)};
     }
   };
 
@@ -147,17 +165,21 @@ namespace impl_dev {
     using device_traits_type = feature::In<Traits>;
     using socket_traits_type = Traits;
     using value_type = std::byte;
-    using sem_type = coro::CountingSemaphore<1>;
-
-    template <class Sem, class... Args>
-      requires std::constructible_from<std::shared_ptr<sem_type>, Sem>
-                   && std::constructible_from<Device<device_traits_type>, Args...>
-    AsyncDevice(Sem &&sem, Args &&...args) noexcept
-        : _sem(std::forward<Sem>(sem)), _dev(std::forward<Args>(args)...) {}
+    using block_type = BlockRef<typename Traits::poll_traits>;
+    using sem_type = typename block_type::sem_type;
+    /**
+     * @brief Construct a new Async Device object bound to the poller
+     *
+     * @param poller the poller the device is registered to, operations are submitted to it if
+     * the engine is io_uring
+     * @param block the control block of the socket, shared with the other half if split
+     */
+    AsyncDevice(sync::Poller *poller, block_type block) noexcept
+        : _poller(poller), _block(std::move(block)) {}
 
     template <class... Flags>
     AsyncDevice(AsyncDevice<feature::In<Traits>, Flags...> &&rhs) noexcept
-        : _sem(std::move(rhs._sem)), _dev(std::move(rhs._dev)) {}
+        : _poller(rhs._poller), _block(std::move(rhs._block)) {}
 
     AsyncDevice(AsyncDevice &&rhs) noexcept = default;
 
@@ -165,16 +187,32 @@ namespace impl_dev {
 
     ~AsyncDevice() noexcept {}
 
-    decltype(auto) raw() { return _dev.raw(); }
+    decltype(auto) raw() { return _block.raw(); }
 
-    sem_type &sem() { return *_sem; }
+    sem_type &sem() { return _block.read_sem(); }
+
+    sync::Poller *poller() { return _poller; }
 
     template <class Executor = coro::ExecutorBase>
-    coro::Task<Result, Executor> read(std::span<value_type> buf) {
-      return immediate_recv<Executor>(*this, buf);
+    coro::Task<Result, Executor> read(std::span<value_type> buf, std::stop_token token = {}) {
+      if (_poller != nullptr && _poller->engine() == sync::PollEngine::IO_URING) {
+        return uring_recv<Executor>(*_poller, *this, buf, std::move(token));
+      }
+      return immediate_recv<Executor>(*this, buf, std::move(token));
     }
 
     coro::Task<Result> read(std::span<value_type> buf) { return this->read<>(buf); }
+    /**
+     * @brief receive the available data by an awaiter on the frame of the caller
+     *
+     * @note no coroutine frame and no virtual call, the recv is tried before suspending
+     * @param buf the buffer
+     * @param token the stop token
+     * @return RecvAwaiter
+     */
+    RecvAwaiter recv(std::span<value_type> buf, std::stop_token token = {}) {
+      return RecvAwaiter{this->raw(), this->sem(), buf, std::move(token)};
+    }
 
     AsyncDeviceCompose<device_traits_type, feature::Dyn, U> to_dyn() && noexcept {
       return {std::move(*this)};
@@ -186,8 +224,8 @@ namespace impl_dev {
     }
 
   protected:
-    std::shared_ptr<sem_type> _sem;
-    Device<device_traits_type> _dev;
+    sync::Poller *_poller;
+    block_type _block;
   };
 
   static_assert(
@@ -223,17 +261,21 @@ namespace impl_dev {
     using device_traits_type = feature::Out<Traits>;
     using socket_traits_type = Traits;
     using value_type = std::byte;
-    using sem_type = coro::CountingSemaphore<1>;
-
-    template <class Sem, class... Args>
-      requires std::constructible_from<std::shared_ptr<sem_type>, Sem>
-                   && std::constructible_from<Device<device_traits_type>, Args...>
-    AsyncDevice(Sem &&sem, Args &&...args) noexcept
-        : _sem(std::forward<Sem>(sem)), _dev(std::forward<Args>(args)...) {}
+    using block_type = BlockRef<typename Traits::poll_traits>;
+    using sem_type = typename block_type::sem_type;
+    /**
+     * @brief Construct a new Async Device object bound to the poller
+     *
+     * @param poller the poller the device is registered to, operations are submitted to it if
+     * the engine is io_uring
+     * @param block the control block of the socket, shared with the other half if split
+     */
+    AsyncDevice(sync::Poller *poller, block_type block) noexcept
+        : _poller(poller), _block(std::move(block)), _zerocopy(0) {}
 
     template <class... Flags>
     AsyncDevice(AsyncDevice<feature::Out<Traits>, Flags...> &&rhs) noexcept
-        : _sem(std::move(rhs._sem)), _dev(std::move(rhs._dev)) {}
+        : _poller(rhs._poller), _block(std::move(rhs._block)), _zerocopy(rhs._zerocopy) {}
 
     AsyncDevice(AsyncDevice &&rhs) noexcept = default;
 
@@ -241,16 +283,67 @@ namespace impl_dev {
 
     ~AsyncDevice() noexcept {}
 
-    decltype(auto) raw() { return _dev.raw(); }
+    decltype(auto) raw() { return _block.raw(); }
 
-    sem_type &sem() { return *_sem; }
+    sem_type &sem() { return _block.write_sem(); }
+
+    sync::Poller *poller() { return _poller; }
+
+    /**
+     * @brief send the data of at least the threshold by MSG_ZEROCOPY from now on
+     *
+     * @param threshold the min size, 0 to copy all data again
+     * @return std::expected<void, std::errc> the error if the socket refuses SO_ZEROCOPY
+     */
+    std::expected<void, std::errc> set_zerocopy(std::size_t threshold) {
+      if (threshold != 0) {
+        if (auto res = enable_zerocopy(this->raw()); !res) {
+          return res;
+        }
+      }
+      this->_zerocopy = threshold;
+      return {};
+    }
+    /// @brief the min size sent by MSG_ZEROCOPY, 0 if disabled
+    std::size_t zerocopy() const noexcept { return this->_zerocopy; }
 
     template <class Executor = coro::ExecutorBase>
-    coro::Task<Result, Executor> write(std::span<const value_type> buf) {
-      return immediate_send<Executor>(*this, buf);
+    coro::Task<Result, Executor> write(std::span<const value_type> buf,
+                                       std::stop_token token = {}) {
+      if (_zerocopy != 0 && buf.size() >= _zerocopy) {
+        return zerocopy_send<Executor>(*this, buf, std::move(token));
+      }
+      if (_poller != nullptr && _poller->engine() == sync::PollEngine::IO_URING) {
+        return uring_send<Executor>(*_poller, *this, buf, std::move(token));
+      }
+      return immediate_send<Executor>(*this, buf, std::move(token));
     }
 
     coro::Task<Result> write(std::span<const value_type> buf) { return this->write<>(buf); }
+    /**
+     * @brief send all data by an awaiter on the frame of the caller
+     *
+     * @note no coroutine frame and no virtual call, the send is tried before suspending
+     * @param data the data
+     * @param token the stop token
+     * @param flags the flags besides MSG_NOSIGNAL, such as MSG_MORE
+     * @return SendAwaiter
+     */
+    SendAwaiter send(std::span<const value_type> data, std::stop_token token = {},
+                     int flags = 0) {
+      return SendAwaiter{this->raw(), this->sem(), data, std::move(token), flags};
+    }
+    /**
+     * @brief send all data of the buffers by one gather write on the frame of the caller
+     *
+     * @note the readiness is waited under both engines, the buffers are sent by sendmsg
+     * @param iov the buffers, the array and the data must be alive until the send is done
+     * @param token the stop token
+     * @return WritevAwaiter
+     */
+    WritevAwaiter write(std::span<const iovec> iov, std::stop_token token = {}) {
+      return WritevAwaiter{this->raw(), this->sem(), iov, std::move(token)};
+    }
 
     AsyncDeviceCompose<device_traits_type, feature::Dyn, U> to_dyn() && noexcept {
       return {std::move(*this)};
@@ -262,8 +355,9 @@ namespace impl_dev {
     }
 
   protected:
-    std::shared_ptr<sem_type> _sem;
-    Device<device_traits_type> _dev;
+    sync::Poller *_poller;
+    block_type _block;
+    std::size_t _zerocopy;  ///< the min size sent by MSG_ZEROCOPY, 0 if disabled
   };
 
   static_assert(
@@ -298,23 +392,24 @@ namespace impl_dev {
     using device_traits_type = feature::InOut<Traits>;
     using socket_traits_type = Traits;
     using value_type = std::byte;
-    using sem_type = coro::CountingSemaphore<1>;
-    using inner_type = DeviceCompose<device_traits_type>;
+    using block_type = BlockRef<typename Traits::poll_traits>;
+    using sem_type = typename block_type::sem_type;
 
     template <template <class> class InOut>
     using rebind_type = AsyncDevice<InOut<socket_traits_type>, T, U>;
-
-    template <class ReadSem, class WriteSem, class... Args>
-    AsyncDevice(ReadSem &&read_sem, WriteSem &&write_sem, Args &&...args) noexcept
-        : _read_sem(std::forward<ReadSem>(read_sem)),
-          _write_sem(std::forward<WriteSem>(write_sem)),
-          _dev(std::forward<Args>(args)...) {}
+    /**
+     * @brief Construct a new Async Device object bound to the poller
+     *
+     * @param poller the poller the device is registered to, operations are submitted to it if
+     * the engine is io_uring
+     * @param block the control block of the socket
+     */
+    AsyncDevice(sync::Poller *poller, block_type block) noexcept
+        : _poller(poller), _block(std::move(block)), _zerocopy(0) {}
 
     template <class... Flags>
     AsyncDevice(AsyncDevice<feature::InOut<Traits>, Flags...> &&rhs) noexcept
-        : _read_sem(std::move(rhs._read_sem)),
-          _write_sem(std::move(rhs._write_sem)),
-          _dev(std::move(rhs._dev)) {}
+        : _poller(rhs._poller), _block(std::move(rhs._block)), _zerocopy(rhs._zerocopy) {}
 
     AsyncDevice(AsyncDevice &&rhs) noexcept = default;
 
@@ -322,20 +417,60 @@ namespace impl_dev {
 
     ~AsyncDevice() noexcept {}
 
-    decltype(auto) raw() { return _dev.raw(); }
+    decltype(auto) raw() { return _block.raw(); }
+
+    sem_type &read_sem() { return _block.read_sem(); }
 
-    inner_type &inner() { return _dev; }
+    sem_type &write_sem() { return _block.write_sem(); }
 
-    sem_type &read_sem() { return *_read_sem; }
+    sync::Poller *poller() { return _poller; }
+    /**
+     * @brief send the data of at least the threshold by MSG_ZEROCOPY from now on
+     *
+     * @note the threshold is kept by the Out half of split, which sends by zero copy
+     * @param threshold the min size, 0 to copy all data again
+     * @return std::expected<void, std::errc> the error if the socket refuses SO_ZEROCOPY
+     */
+    std::expected<void, std::errc> set_zerocopy(std::size_t threshold) {
+      if (threshold != 0) {
+        if (auto res = enable_zerocopy(this->raw()); !res) {
+          return res;
+        }
+      }
+      this->_zerocopy = threshold;
+      return {};
+    }
+    /// @brief the min size sent by MSG_ZEROCOPY, 0 if disabled
+    std::size_t zerocopy() const noexcept { return this->_zerocopy; }
+
+    coro::Task<Result> read(std::span<std::byte> buf) { return this->read(buf, {}); }
+
+    coro::Task<Result> read(std::span<std::byte> buf, std::stop_token token) {
+      if (_poller != nullptr && _poller->engine() == sync::PollEngine::IO_URING) {
+        return uring_recv<coro::ExecutorBase>(*_poller, *this, buf, std::move(token));
+      }
+      return immediate_recv<coro::ExecutorBase>(*this, buf, std::move(token));
+    }
 
-    sem_type &write_sem() { return *_write_sem; }
+    coro::Task<Result> write(std::span<const std::byte> buf) { return this->write(buf, {}); }
 
-    coro::Task<Result> read(std::span<std::byte> buf) {
-      return immediate_recv<coro::ExecutorBase>(*this, buf);
+    coro::Task<Result> write(std::span<const std::byte> buf, std::stop_token token) {
+      if (_poller != nullptr && _poller->engine() == sync::PollEngine::IO_URING) {
+        return uring_send<coro::ExecutorBase>(*_poller, *this, buf, std::move(token));
+      }
+      return immediate_send<coro::ExecutorBase>(*this, buf, std::move(token));
     }
 
-    coro::Task<Result> write(std::span<const std::byte> buf) {
-      return immediate_send<coro::ExecutorBase>(*this, buf);
+    RecvAwaiter recv(std::span<std::byte> buf, std::stop_token token = {}) {
+      return RecvAwaiter{this->raw(), this->read_sem(), buf, std::move(token)};
+    }
+
+    SendAwaiter send(std::span<const std::byte> data, std::stop_token token = {}, int flags = 0) {
+      return SendAwaiter{this->raw(), this->write_sem(), data, std::move(token), flags};
+    }
+
+    WritevAwaiter write(std::span<const iovec> iov, std::stop_token token = {}) {
+      return WritevAwaiter{this->raw(), this->write_sem(), iov, std::move(token)};
     }
 
     AsyncDeviceCompose<device_traits_type, feature::Dyn, U> to_dyn() && noexcept {
@@ -350,23 +485,26 @@ namespace impl_dev {
     /**
      * @brief split the device into two devices
      *
+     * @note both halves refer to the same control block, the socket is closed with the last one.
+     * The zero copy threshold is kept by the Out half
      * @return std::tuple<AsyncDevice<feature::In<socket_traits_type>, T, U>,
      * AsyncDevice<feature::Out<socket_traits_type>, T, U>>
      */
     std::tuple<AsyncDevice<feature::In<socket_traits_type>, T, U>,
                AsyncDevice<feature::Out<socket_traits_type>, T, U>>
     split() && noexcept {
-      auto [r, w] = std::move(_dev).split();
       using In = AsyncDevice<feature::In<socket_traits_type>, T, U>;
       using Out = AsyncDevice<feature::Out<socket_traits_type>, T, U>;
-      auto _in = In{std::move(_read_sem), std::move(r)};
-      auto _out = Out{std::move(_write_sem), std::move(w)};
+      auto _in = In{_poller, _block};
+      auto _out = Out{_poller, std::move(_block)};
+      _out._zerocopy = _zerocopy;
       return {std::move(_in), std::move(_out)};
     }
 
   protected:
-    std::shared_ptr<sem_type> _read_sem, _write_sem;
-    DeviceCompose<device_traits_type> _dev;
+    sync::Poller *_poller;
+    block_type _block;
+    std::size_t _zerocopy;  ///< the min size sent by MSG_ZEROCOPY, 0 if disabled
   };
 
   static_assert(std::is_same_v<
@@ -399,5 +537,73 @@ using Device = impl_dev::DeviceCompose<Flags...>;
 template <class... Flags>
 using AsyncDevice = impl_dev::AsyncDeviceCompose<Flags...>;
 
+namespace impl_dev {
+  using clock_type = sync::TimerWheel::clock_type;
+  /**
+   * @brief report the cancellation by the deadline as std::errc::timed_out
+   *
+   */
+  inline Result on_deadline(Result &&res, const sync::Deadline &deadline) {
+    auto &[sz, err] = res;
+    if (err == std::errc::operation_canceled && deadline.expired()) {
+      err = std::errc::timed_out;
+    }
+    return std::move(res);
+  }
+}  // namespace impl_dev
+/**
+ * @brief read data from the device before the deadline
+ *
+ * @tparam Executor default is coro::ExecutorBase
+ * @param dev the device, must be bound to a poller
+ * @param buf the buffer
+ * @param deadline the deadline
+ * @param token the stop token of the caller
+ * @return coro::Task<ai::Result, Executor> std::errc::timed_out if the deadline passes first, with
+ * the size read so far
+ */
+template <class Executor = coro::ExecutorBase, class Dev>
+coro::Task<ai::Result, Executor> read_until(Dev &dev, std::span<std::byte> buf,
+                                            impl_dev::clock_type::time_point deadline,
+                                            std::stop_token token = {}) {
+  assert(dev.poller() != nullptr && "the device must be bound to a poller");
+  sync::Deadline timer{*dev.poller(), deadline, std::move(token)};
+  co_return impl_dev::on_deadline(co_await dev.read(buf, timer.token()), timer);
+}
+
+template <class Executor = coro::ExecutorBase, class Dev, class Rep, class Period>
+coro::Task<ai::Result, Executor> read_for(Dev &dev, std::span<std::byte> buf,
+                                          std::chrono::duration<Rep, Period> timeout,
+                                          std::stop_token token = {}) {
+  return read_until<Executor>(dev, buf, impl_dev::clock_type::now() + timeout, std::move(token));
+}
+/**
+ * @brief write all data to the device before the deadline
+ *
+ * @tparam Executor default is coro::ExecutorBase
+ * @param dev the device, must be bound to a poller
+ * @param data the data
+ * @param deadline the deadline
+ * @param token the stop token of the caller
+ * @return coro::Task<ai::Result, Executor> std::errc::timed_out if the deadline passes first, with
+ * the size written so far
+ */
+template <class Executor = coro::ExecutorBase, class Dev>
+coro::Task<ai::Result, Executor> write_until(Dev &dev, std::span<const std::byte> data,
+                                             impl_dev::clock_type::time_point deadline,
+                                             std::stop_token token = {}) {
+  assert(dev.poller() != nullptr && "the device must be bound to a poller");
+  sync::Deadline timer{*dev.poller(), deadline, std::move(token)};
+  co_return impl_dev::on_deadline(co_await dev.write(data, timer.token()), timer);
+}
+
+template <class Executor = coro::ExecutorBase, class Dev, class Rep, class Period>
+coro::Task<ai::Result, Executor> write_for(Dev &dev, std::span<const std::byte> data,
+                                           std::chrono::duration<Rep, Period> timeout,
+                                           std::stop_token token = {}) {
+  return write_until<Executor>(dev, data, impl_dev::clock_type::now() + timeout,
+                               std::move(token));
+}
+
 XSL_SYS_NET_NE
 #endif
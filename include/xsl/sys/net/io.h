@@ -2,23 +2,62 @@
 #ifndef XSL_SYS_NET_IO
 #  define XSL_SYS_NET_IO
 #  include "xsl/ai/dev.h"
+#  include "xsl/coro/semaphore.h"
 #  include "xsl/feature.h"
 #  include "xsl/sys/io/dev.h"
 #  include "xsl/sys/net/def.h"
 
 #  include <fcntl.h>
+#  include <linux/errqueue.h>
+#  include <netinet/in.h>
+#  include <netinet/tcp.h>
 #  include <sys/sendfile.h>
+#  include <sys/socket.h>
 #  include <sys/stat.h>
 #  include <sys/types.h>
+#  include <sys/uio.h>
 
+#  include <algorithm>
+#  include <climits>
+#  include <concepts>
+#  include <coroutine>
 #  include <cstddef>
+#  include <cstdint>
+#  include <cstring>
+#  include <expected>
 #  include <optional>
+#  include <span>
+#  include <stop_token>
 #  include <system_error>
 #  include <tuple>
 XSL_SYS_NET_NB
+namespace impl_io {
+  /**
+   * @brief the error of a wait resumed with false
+   *
+   * @param token the token of the operation
+   * @return std::errc operation_canceled if the stop is requested, otherwise the socket is closed
+   */
+  inline std::errc wake_error(const std::stop_token &token) noexcept {
+    return token.stop_requested() ? std::errc::operation_canceled : std::errc::not_connected;
+  }
+}  // namespace impl_io
+/**
+ * @brief receive the available data from the socket
+ *
+ * @tparam Executor default is coro::ExecutorBase
+ * @tparam S socket type
+ * @param skt socket
+ * @param buf the buffer
+ * @param token the stop token, the wait for data ends with std::errc::operation_canceled once the
+ * stop is requested
+ * @return coro::Task<ai::Result, Executor>
+ */
 template <class Executor = coro::ExecutorBase, AsyncSocketLike<feature::In> S>
-coro::Task<ai::Result, Executor> immediate_recv(S &skt, std::span<std::byte> buf) {
+coro::Task<ai::Result, Executor> immediate_recv(S &skt, std::span<std::byte> buf,
+                                                std::stop_token token = {}) {
   using Result = ai::Result;
+  coro::StopGuard guard{skt.sem(), token};
   ssize_t n;
   size_t offset = 0;
   while (true) {
@@ -31,8 +70,11 @@ coro::Task<ai::Result, Executor> immediate_recv(S &skt, std::span<std::byte> buf
           break;
         }
         LOG5("no data");
+        if (token.stop_requested()) {
+          co_return Result(offset, {std::errc::operation_canceled});
+        }
         if (!co_await skt.sem()) {
-          co_return Result(offset, {std::errc::not_connected});
+          co_return Result(offset, {impl_io::wake_error(token)});
         }
         continue;
       } else {
@@ -54,9 +96,22 @@ coro::Task<ai::Result, Executor> immediate_recv(S &skt, std::span<std::byte> buf
   co_return std::make_tuple(offset, std::nullopt);
 }
 
+/**
+ * @brief send all data to the socket
+ *
+ * @tparam Executor default is coro::ExecutorBase
+ * @tparam S socket type
+ * @param skt socket
+ * @param data the data
+ * @param token the stop token, the wait for the socket to be writable ends with
+ * std::errc::operation_canceled once the stop is requested
+ * @return coro::Task<ai::Result, Executor>
+ */
 template <class Executor = coro::ExecutorBase, AsyncSocketLike<feature::Out> S>
-coro::Task<ai::Result, Executor> immediate_send(S &skt, std::span<const std::byte> data) {
+coro::Task<ai::Result, Executor> immediate_send(S &skt, std::span<const std::byte> data,
+                                                std::stop_token token = {}) {
   using Result = ai::Result;
+  coro::StopGuard guard{skt.sem(), token};
   while (true) {
     ssize_t n = ::send(skt.raw(), data.data(), data.size(), 0);
     if (static_cast<size_t>(n) == data.size()) {
@@ -69,8 +124,11 @@ coro::Task<ai::Result, Executor> immediate_send(S &skt, std::span<const std::byt
     if (n == -1 && !(errno == EAGAIN || errno == EWOULDBLOCK)) {
       co_return Result{0, {std::errc(errno)}};
     }
+    if (token.stop_requested()) {
+      co_return Result{0, {std::errc::operation_canceled}};
+    }
     if (!co_await skt.sem()) {
-      co_return Result{0, {std::errc::not_connected}};
+      co_return Result{0, {impl_io::wake_error(token)}};
     }
   }
 }
@@ -89,12 +147,15 @@ struct SendfileHint {
  * @tparam S socket type
  * @param skt socket
  * @param hint sendfile hint
+ * @param token the stop token, the wait for the socket to be writable ends with
+ * std::errc::operation_canceled once the stop is requested
  * @return coro::Task<ai::Result, Executor>
  * @note The skt must keep alive until the task is finished, that is, the task and the socket must
  * have the same lifetime.
  */
 template <class Executor = coro::ExecutorBase, AsyncSocketLike<feature::Out> S>
-coro::Task<ai::Result, Executor> immediate_sendfile(S &skt, SendfileHint hint) {
+coro::Task<ai::Result, Executor> immediate_sendfile(S &skt, SendfileHint hint,
+                                                    std::stop_token token = {}) {
   using Result = ai::Result;
   int ffd = open(hint.path.c_str(), O_RDONLY);
   if (ffd == -1) {
@@ -102,6 +163,7 @@ coro::Task<ai::Result, Executor> immediate_sendfile(S &skt, SendfileHint hint) {
     co_return Result{0, {std::errc(errno)}};
   }
   sys::io::NativeDevice file{ffd};
+  coro::StopGuard guard{skt.sem(), token};
   off_t offset = hint.offset;
   while (true) {
     ssize_t n = ::sendfile(skt.raw(), file.raw(), &offset, hint.size);
@@ -118,11 +180,595 @@ coro::Task<ai::Result, Executor> immediate_sendfile(S &skt, SendfileHint hint) {
       // TODO: handle sendfile error
       co_return Result{static_cast<std::size_t>(offset), {std::errc(errno)}};
     }
-
+    if (token.stop_requested()) {
+      co_return Result{static_cast<std::size_t>(offset), {std::errc::operation_canceled}};
+    }
     if (!co_await skt.sem()) {
-      co_return Result{static_cast<std::size_t>(offset), {std::errc::not_connected}};
+      co_return Result{static_cast<std::size_t>(offset), {impl_io::wake_error(token)}};
     }
   }
 }
+/// @brief the size from which a send is worth pinning the pages by MSG_ZEROCOPY
+const std::size_t DEFAULT_ZEROCOPY_THRESHOLD = 64 * 1024;
+/**
+ * @brief allow the zero copy sends on the socket
+ *
+ * @param fd the socket
+ * @return std::expected<void, std::errc>
+ */
+inline std::expected<void, std::errc> enable_zerocopy(int fd) {
+  int opt = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &opt, sizeof(opt)) == -1) {
+    return std::unexpected{std::errc{errno}};
+  }
+  return {};
+}
+namespace impl_io {
+  /**
+   * @brief reap the completions of the zero copy sends from the error queue
+   *
+   * @param fd the socket
+   * @return std::expected<std::size_t, std::errc> the count of the sends completed
+   */
+  inline std::expected<std::size_t, std::errc> reap_zerocopy(int fd) {
+    std::size_t completed = 0;
+    while (true) {
+      alignas(cmsghdr) char control[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+      msghdr msg{};
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+      if (::recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          return completed;
+        }
+        return std::unexpected{std::errc(errno)};
+      }
+      for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+            && !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+          continue;
+        }
+        sock_extended_err err;
+        std::memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+        if (err.ee_errno != 0 || err.ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+          continue;
+        }
+        // the ids of the sends completed are the range [ee_info, ee_data]
+        completed += err.ee_data - err.ee_info + 1;
+      }
+    }
+  }
+}  // namespace impl_io
+/**
+ * @brief send all data to the socket by MSG_ZEROCOPY, the pages are sent without being copied
+ *
+ * @note the task completes once the kernel releases the pages, that is, the data is acknowledged
+ * by the peer, since the data must be kept unchanged until then. This holds on an error or a stop
+ * as well, the sends issued are waited for before the task completes, unless the socket is
+ * dropped by the poller. A send refused for the lack of the option memory waits for the pending
+ * completions, or copies if none is pending. The completions are woken by the error events of the
+ * socket
+ * @tparam Executor default is coro::ExecutorBase
+ * @tparam S socket type, enable_zerocopy must be called on it before
+ * @param skt socket
+ * @param data the data
+ * @param token the stop token, the sending ends with std::errc::operation_canceled once the stop
+ * is requested
+ * @return coro::Task<ai::Result, Executor> the size sent
+ */
+template <class Executor = coro::ExecutorBase, AsyncSocketLike<feature::Out> S>
+coro::Task<ai::Result, Executor> zerocopy_send(S &skt, std::span<const std::byte> data,
+                                               std::stop_token token = {}) {
+  using Result = ai::Result;
+  std::optional<coro::StopGuard> guard{std::in_place, skt.sem(), token};
+  std::size_t sent = 0, issued = 0, completed = 0;
+  std::optional<std::errc> err;
+  while (true) {
+    if (!err && sent < data.size()) {
+      int flags = MSG_NOSIGNAL | MSG_ZEROCOPY;
+      ssize_t n = ::send(skt.raw(), data.data() + sent, data.size() - sent, flags);
+      if (n == -1 && errno == ENOBUFS && issued == completed) {
+        n = ::send(skt.raw(), data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n >= 0) {
+          sent += n;
+          continue;
+        }
+      }
+      if (n >= 0) {
+        sent += n;
+        ++issued;
+        continue;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+        err = std::errc(errno);
+      }
+    }
+    auto reaped = impl_io::reap_zerocopy(skt.raw());
+    if (!reaped) {
+      // the error queue can not be read, so the pending completions are lost
+      co_return Result{sent, {reaped.error()}};
+    }
+    completed += *reaped;
+    if ((err || sent == data.size()) && completed >= issued) {
+      break;
+    }
+    if (!err && *reaped != 0 && sent < data.size()) {
+      // the option memory is freed, retry at once
+      continue;
+    }
+    if (!err && token.stop_requested()) {
+      err = std::errc::operation_canceled;
+    }
+    if (err && guard) {
+      // the pages of the sends issued are still in use, they are waited for without the stop
+      guard.reset();
+      continue;
+    }
+    if (!co_await skt.sem()) {
+      if (err || !token.stop_requested()) {
+        // dropped by the poller, no completion can be woken any more
+        co_return Result{sent, {err.value_or(impl_io::wake_error(token))}};
+      }
+      err = std::errc::operation_canceled;
+    }
+  }
+  LOG6("{} send {} bytes by {} zero copy sends", skt.raw(), sent, issued);
+  co_return Result{sent, err};
+}
+namespace impl_io {
+  /**
+   * @brief the base of the awaiters retrying a nonblocking syscall until it would not block
+   *
+   * @note the syscall is tried in await_ready, the awaiter only suspends on EAGAIN and waits for
+   * the readiness on the semaphore. The wake up retries the syscall on the waking thread and
+   * resumes the coroutine by its executor once the syscall is done, so an operation allocates
+   * nothing. The awaiter must not be copied once awaited
+   * @tparam Derived provides `bool attempt()`, true if done, and `void fail(std::errc)`
+   */
+  template <class Derived>
+  class ReadyAwaiter {
+  public:
+    using executor_type = void;
+
+    ReadyAwaiter(coro::CountingSemaphore<1> &sem, std::stop_token token)
+        : _sem(sem),
+          _token(std::move(token)),
+          _wait(sem.operator co_await()),
+          _guard(),
+          _handle(),
+          _resume(nullptr) {}
+    ReadyAwaiter(const ReadyAwaiter &rhs) : ReadyAwaiter(rhs._sem, rhs._token) {}
+
+    bool await_ready() {
+      if (this->_token.stop_requested()) {
+        this->derived().fail(std::errc::operation_canceled);
+        return true;
+      }
+      return this->derived().attempt();
+    }
+
+    template <class Promise>
+    bool await_suspend(std::coroutine_handle<Promise> handle) {
+      this->_handle = handle;
+      this->_resume = &resume<Promise>;
+      if (this->_token.stop_possible()) {
+        this->_guard.emplace(this->_sem, this->_token);
+      }
+      return !this->wait();
+    }
+
+  protected:
+    /// @brief release the stop callback, must be called by await_resume
+    void finish() noexcept { this->_guard.reset(); }
+
+  private:
+    using resume_type = void (*)(std::coroutine_handle<>);
+
+    coro::CountingSemaphore<1> &_sem;
+    std::stop_token _token;
+    coro::CountingSemaphore<1>::awaiter_type _wait;
+    std::optional<coro::StopGuard> _guard;
+    std::coroutine_handle<> _handle;
+    resume_type _resume;
+
+    template <class Promise>
+    static void resume(std::coroutine_handle<> handle) {
+      auto h = std::coroutine_handle<Promise>::from_address(handle.address());
+      h.promise().resume(h);
+    }
+
+    Derived &derived() noexcept { return static_cast<Derived &>(*this); }
+    /**
+     * @brief take the value of the semaphore and retry the syscall
+     *
+     * @return true if done
+     */
+    bool retry() {
+      if (!this->_wait.await_resume()) {
+        this->derived().fail(wake_error(this->_token));
+        return true;
+      }
+      return this->derived().attempt();
+    }
+    /**
+     * @brief wait for the readiness until the syscall is done
+     *
+     * @return true if done, false if waiting, then this must not be touched
+     */
+    bool wait() {
+      while (true) {
+        if (this->_token.stop_requested()) {
+          this->derived().fail(std::errc::operation_canceled);
+          return true;
+        }
+        if (this->_wait.wait(this, &ReadyAwaiter::on_ready)) {
+          return false;
+        }
+        if (this->retry()) {
+          return true;
+        }
+      }
+    }
+
+    static void on_ready(void *context) {
+      auto self = static_cast<ReadyAwaiter *>(context);
+      if (self->retry() || self->wait()) {
+        self->_resume(self->_handle);
+      }
+    }
+  };
+}  // namespace impl_io
+/**
+ * @brief the awaiter receiving the available data from the socket once
+ *
+ */
+class RecvAwaiter : public impl_io::ReadyAwaiter<RecvAwaiter> {
+public:
+  RecvAwaiter(int fd, coro::CountingSemaphore<1> &sem, std::span<std::byte> buf,
+              std::stop_token token)
+      : ReadyAwaiter(sem, std::move(token)), _fd(fd), _buf(buf), _result() {}
+  /**
+   * @brief the result of the receive
+   *
+   * @return ai::Result std::errc::no_message on eof
+   */
+  ai::Result await_resume() noexcept {
+    this->finish();
+    return this->_result;
+  }
+
+private:
+  friend class ReadyAwaiter;
+
+  int _fd;
+  std::span<std::byte> _buf;
+  ai::Result _result;
+
+  bool attempt() {
+    ssize_t n = ::recv(this->_fd, this->_buf.data(), this->_buf.size(), 0);
+    LOG6("{} recv {} bytes", this->_fd, n);
+    if (n > 0) {
+      this->_result = {static_cast<std::size_t>(n), std::nullopt};
+    } else if (n == 0) {
+      LOG5("recv eof");
+      this->_result = {0, {std::errc::no_message}};
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return false;
+    } else {
+      LOG2("Failed to recv data, err : {}", strerror(errno));
+      this->_result = {0, {std::errc(errno)}};
+    }
+    return true;
+  }
+
+  void fail(std::errc err) { this->_result = {0, {err}}; }
+};
+/**
+ * @brief the awaiter sending all data to the socket
+ *
+ */
+class SendAwaiter : public impl_io::ReadyAwaiter<SendAwaiter> {
+public:
+  /**
+   * @brief Construct a new Send Awaiter object
+   *
+   * @param fd the socket
+   * @param sem the semaphore released when the socket is writable
+   * @param data the data
+   * @param token the stop token
+   * @param flags the flags besides MSG_NOSIGNAL, such as MSG_MORE
+   */
+  SendAwaiter(int fd, coro::CountingSemaphore<1> &sem, std::span<const std::byte> data,
+              std::stop_token token, int flags = 0)
+      : ReadyAwaiter(sem, std::move(token)),
+        _fd(fd),
+        _flags(flags | MSG_NOSIGNAL),
+        _data(data),
+        _sent(0),
+        _err() {}
+  /**
+   * @brief the result of the send
+   *
+   * @return ai::Result the size sent, even if failed
+   */
+  ai::Result await_resume() noexcept {
+    this->finish();
+    return {this->_sent, this->_err};
+  }
+
+private:
+  friend class ReadyAwaiter;
+
+  int _fd;
+  int _flags;
+  std::span<const std::byte> _data;
+  std::size_t _sent;
+  std::optional<std::errc> _err;
+
+  bool attempt() {
+    while (!this->_data.empty()) {
+      ssize_t n = ::send(this->_fd, this->_data.data(), this->_data.size(), this->_flags);
+      if (n >= 0) {
+        this->_data = this->_data.subspan(n);
+        this->_sent += n;
+      } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return false;
+      } else {
+        this->_err = std::errc(errno);
+        return true;
+      }
+    }
+    return true;
+  }
+
+  void fail(std::errc err) { this->_err = err; }
+};
+/**
+ * @brief the awaiter sending all data of the buffers to the socket by gather writes
+ *
+ * @note the buffers are sent by sendmsg, at most IOV_MAX buffers per syscall. The rest of a buffer
+ * sent partially is sent by itself before the following buffers are gathered again
+ */
+class WritevAwaiter : public impl_io::ReadyAwaiter<WritevAwaiter> {
+public:
+  WritevAwaiter(int fd, coro::CountingSemaphore<1> &sem, std::span<const iovec> iov,
+                std::stop_token token)
+      : ReadyAwaiter(sem, std::move(token)), _fd(fd), _iov(iov), _offset(0), _sent(0), _err() {}
+  /**
+   * @brief the result of the gather write
+   *
+   * @return ai::Result the size sent, even if failed
+   */
+  ai::Result await_resume() noexcept {
+    this->finish();
+    return {this->_sent, this->_err};
+  }
+
+private:
+  friend class ReadyAwaiter;
+
+  int _fd;
+  std::span<const iovec> _iov;  ///< the buffers not sent completely
+  std::size_t _offset;          ///< the size sent of the first buffer
+  std::size_t _sent;
+  std::optional<std::errc> _err;
+
+  bool attempt() {
+    while (!this->_iov.empty()) {
+      ssize_t n;
+      if (this->_offset != 0) {
+        auto &head = this->_iov.front();
+        n = ::send(this->_fd, static_cast<const std::byte *>(head.iov_base) + this->_offset,
+                   head.iov_len - this->_offset, MSG_NOSIGNAL);
+      } else {
+        msghdr msg{};
+        msg.msg_iov = const_cast<iovec *>(this->_iov.data());
+        msg.msg_iovlen = std::min<std::size_t>(this->_iov.size(), IOV_MAX);
+        n = ::sendmsg(this->_fd, &msg, MSG_NOSIGNAL);
+      }
+      if (n >= 0) {
+        LOG6("{} send {} bytes", this->_fd, n);
+        this->_sent += n;
+        this->advance(n);
+      } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return false;
+      } else {
+        this->_err = std::errc(errno);
+        return true;
+      }
+    }
+    return true;
+  }
+
+  void advance(std::size_t n) {
+    n += this->_offset;
+    while (!this->_iov.empty() && n >= this->_iov.front().iov_len) {
+      n -= this->_iov.front().iov_len;
+      this->_iov = this->_iov.subspan(1);
+    }
+    this->_offset = n;
+  }
+
+  void fail(std::errc err) { this->_err = err; }
+};
+/**
+ * @brief the awaiter sending the file to the socket
+ *
+ */
+class SendfileAwaiter : public impl_io::ReadyAwaiter<SendfileAwaiter> {
+public:
+  SendfileAwaiter(int fd, coro::CountingSemaphore<1> &sem, SendfileHint hint,
+                  std::stop_token token)
+      : ReadyAwaiter(sem, std::move(token)),
+        _fd(fd),
+        _hint(std::move(hint)),
+        _file(),
+        _offset(static_cast<off_t>(this->_hint.offset)),
+        _err() {}
+  SendfileAwaiter(const SendfileAwaiter &rhs)
+      : ReadyAwaiter(rhs),
+        _fd(rhs._fd),
+        _hint(rhs._hint),
+        _file(),
+        _offset(rhs._offset),
+        _err(rhs._err) {}
+  /**
+   * @brief the result of the sendfile
+   *
+   * @return ai::Result the offset of the file reached
+   */
+  ai::Result await_resume() noexcept {
+    this->finish();
+    return {static_cast<std::size_t>(this->_offset), this->_err};
+  }
+
+private:
+  friend class ReadyAwaiter;
+
+  int _fd;
+  SendfileHint _hint;
+  std::optional<sys::io::NativeDevice> _file;  ///< opened by the first attempt
+  off_t _offset;
+  std::optional<std::errc> _err;
+
+  bool attempt() {
+    if (!this->_file) {
+      int ffd = open(this->_hint.path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (ffd == -1) {
+        LOG2("open file failed");
+        this->_err = std::errc(errno);
+        return true;
+      }
+      this->_file.emplace(ffd);
+    }
+    while (this->_hint.size > 0) {
+      ssize_t n = ::sendfile(this->_fd, this->_file->raw(), &this->_offset, this->_hint.size);
+      if (n > 0) {
+        this->_hint.size -= n;
+      } else if (n == 0) {
+        // the file is shorter than the hint
+        this->_err = std::errc::no_message;
+        return true;
+      } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return false;
+      } else {
+        this->_err = std::errc(errno);
+        return true;
+      }
+    }
+    LOG6("{} send file to offset {}", this->_fd, this->_offset);
+    return true;
+  }
+
+  void fail(std::errc err) { this->_err = err; }
+};
+/**
+ * @brief receive the available data from the socket without a coroutine frame
+ *
+ * @param skt socket
+ * @param buf the buffer
+ * @param token the stop token
+ * @return RecvAwaiter resumes with the result of a single receive
+ */
+template <AsyncSocketLike<feature::In> S>
+RecvAwaiter async_recv(S &skt, std::span<std::byte> buf, std::stop_token token = {}) {
+  return RecvAwaiter{skt.raw(), skt.sem(), buf, std::move(token)};
+}
+/**
+ * @brief send all data to the socket without a coroutine frame
+ *
+ * @param skt socket
+ * @param data the data, must be alive until the send is done
+ * @param token the stop token
+ * @return SendAwaiter
+ */
+template <AsyncSocketLike<feature::Out> S>
+SendAwaiter async_send(S &skt, std::span<const std::byte> data, std::stop_token token = {}) {
+  return SendAwaiter{skt.raw(), skt.sem(), data, std::move(token)};
+}
+/**
+ * @brief send all data of the buffers to the socket by gather writes without a coroutine frame
+ *
+ * @param skt socket
+ * @param iov the buffers, the array and the data must be alive until the send is done
+ * @param token the stop token
+ * @return WritevAwaiter
+ */
+template <AsyncSocketLike<feature::Out> S>
+WritevAwaiter async_writev(S &skt, std::span<const iovec> iov, std::stop_token token = {}) {
+  return WritevAwaiter{skt.raw(), skt.sem(), iov, std::move(token)};
+}
+
+template <AsyncSocketLike<feature::Out> S>
+SendfileAwaiter async_sendfile(S &skt, SendfileHint hint, std::stop_token token = {}) {
+  return SendfileAwaiter{skt.raw(), skt.sem(), std::move(hint), std::move(token)};
+}
+/// @brief how the data sent by separate syscalls, such as a header and a file, fills the segments
+enum class Coalesce : uint8_t {
+  NONE,  ///< send as is, the first part may go out in a segment of its own
+  MORE,  ///< send the first part with MSG_MORE, the following send pushes both
+  CORK,  ///< cork the socket across the sends, uncorking pushes the rest
+};
+namespace impl_io {
+  /// @brief set TCP_CORK, clearing it pushes the partial segments held back
+  inline void set_cork(int fd, int on) noexcept {
+    if (::setsockopt(fd, IPPROTO_TCP, TCP_CORK, &on, sizeof(on)) == -1) {
+      LOG5("{} set TCP_CORK to {} failed: {}", fd, on, strerror(errno));
+    }
+  }
+}  // namespace impl_io
+/**
+ * @brief cork the tcp socket while alive
+ *
+ * @note the partial segments are held back until uncorked, a socket not supporting TCP_CORK is
+ * left as is
+ */
+class TcpCork {
+public:
+  explicit TcpCork(int fd) noexcept : _fd(fd) { impl_io::set_cork(this->_fd, 1); }
+  TcpCork(const TcpCork &) = delete;
+  TcpCork &operator=(const TcpCork &) = delete;
+  ~TcpCork() noexcept { impl_io::set_cork(this->_fd, 0); }
+
+private:
+  int _fd;
+};
+/**
+ * @brief push the data held back by MSG_MORE once destroyed, unless released
+ *
+ * @note the data sent with MSG_MORE waits for a following send up to the cork timeout, so an exit
+ * without one must push it
+ */
+class TcpPush {
+public:
+  explicit TcpPush(int fd) noexcept : _fd(fd) {}
+  TcpPush(const TcpPush &) = delete;
+  TcpPush &operator=(const TcpPush &) = delete;
+  ~TcpPush() noexcept {
+    if (this->_fd != -1) {
+      impl_io::set_cork(this->_fd, 0);
+    }
+  }
+  /// @brief the held data is pushed by a following send, no push is needed
+  void release() noexcept { this->_fd = -1; }
+
+private:
+  int _fd;
+};
+/// @brief a device receiving by an awaiter, rather than a Task returned by a virtual read
+template <class Device>
+concept AsyncRecvDeviceLike = requires(Device &dev, std::span<std::byte> buf) {
+  { dev.recv(buf) } -> std::same_as<RecvAwaiter>;
+};
+/// @brief a device sending by an awaiter, rather than a Task returned by a virtual write
+template <class Device>
+concept AsyncSendDeviceLike = requires(Device &dev, std::span<const std::byte> data) {
+  { dev.send(data) } -> std::same_as<SendAwaiter>;
+};
+/// @brief a device sending several buffers by one gather write
+template <class Device>
+concept AsyncWritevDeviceLike = requires(Device &dev, std::span<const iovec> iov) {
+  { dev.write(iov) } -> std::same_as<WritevAwaiter>;
+};
 XSL_SYS_NET_NE
 #endif
@@ -1,21 +1,30 @@
 #pragma once
 #ifndef XSL_SYS_NET_TCP
 #  define XSL_SYS_NET_TCP
+#  include "xsl/coro/semaphore.h"
 #  include "xsl/coro/task.h"
+#  include "xsl/sync/deadline.h"
 #  include "xsl/sync/poller.h"
+#  include "xsl/sys/net/block.h"
 #  include "xsl/sys/net/def.h"
 #  include "xsl/sys/net/endpoint.h"
 #  include "xsl/sys/net/socket.h"
 #  include "xsl/sys/raw.h"
 
+#  include <linux/filter.h>
+
+#  include <chrono>
 #  include <expected>
 #  include <memory>
+#  include <span>
+#  include <stop_token>
+#  include <vector>
 XSL_SYS_NET_NB
 
 namespace impl_connect {
   template <class Traits, class Executor = coro::ExecutorBase>
-  coro::Task<std::expected<AsyncSocket<Traits>, std::errc>, Executor> connect(addrinfo *ai,
-                                                                              Poller &poller) {
+  coro::Task<std::expected<AsyncSocket<Traits>, std::errc>, Executor> connect(
+      addrinfo *ai, Poller &poller, std::stop_token token) {
     int tmp_fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
     if (tmp_fd == -1) [[unlikely]] {
       co_return std::unexpected{std::errc{errno}};
@@ -27,12 +36,26 @@ namespace impl_connect {
     }
     LOG5("Set non-blocking to fd: {}", tmp_fd);
     int ec = ::connect(tmp_fd, ai->ai_addr, ai->ai_addrlen);
-    auto write_sem = std::make_shared<coro::CountingSemaphore<1>>();
+    // the block owns the fd from now on, the fd is removed and closed with it on failure
+    auto created = BlockRef<typename Traits::poll_traits>::create(
+        tmp_fd, poller, sync::IOM_EVENTS::IN | sync::IOM_EVENTS::OUT | sync::IOM_EVENTS::ET);
+    if (!created) [[unlikely]] {
+      co_return std::unexpected{created.error()};
+    }
+    auto block = std::move(*created);
     if (ec != 0) {
       LOG3("Failed to connect to fd: {}", tmp_fd);
-      poller.add(tmp_fd, sync::IOM_EVENTS::OUT | sync::IOM_EVENTS::ET,
-                 sync::PollCallback<sync::PollTraits, sync::IOM_EVENTS::OUT>{write_sem});
-      co_await *write_sem;
+      bool ready = false;
+      {
+        coro::StopGuard guard{block.write_sem(), token};
+        if (!token.stop_requested()) {
+          ready = co_await block.write_sem();
+        }
+      }
+      if (!ready && token.stop_requested()) {
+        LOG3("Connecting of fd {} is cancelled", tmp_fd);
+        co_return std::unexpected{std::errc::operation_canceled};
+      }
       auto check = [](int fd) {
         int opt;
         socklen_t len = sizeof(opt);
@@ -48,45 +71,81 @@ namespace impl_connect {
       };
       int res = check(tmp_fd);
       if (res != 0) [[unlikely]] {
-        close(tmp_fd);
-        poller.remove(tmp_fd);
         co_return std::unexpected{std::errc{res}};
       }
     }
     LOG5("Connected to fd: {}", tmp_fd);
-    auto read_sem = std::make_shared<coro::CountingSemaphore<1>>();
-    poller.modify(tmp_fd, sync::IOM_EVENTS::IN | sync::IOM_EVENTS::OUT | sync::IOM_EVENTS::ET,
-                  sync::PollCallback<sync::PollTraits, sync::IOM_EVENTS::IN, sync::IOM_EVENTS::OUT>{
-                      read_sem, write_sem});
-    co_return AsyncSocket<Traits>{read_sem, write_sem, tmp_fd};
+    co_return AsyncSocket<Traits>{&poller, std::move(block)};
   }
 }  // namespace impl_connect
 
 template <class Traits>
 using ConnectResult = std::expected<AsyncSocket<Traits>, std::errc>;
 
+/**
+ * @brief connect to the endpoint
+ *
+ * @param ep the endpoint
+ * @param poller the poller to register the socket
+ * @param token the stop token, the connecting ends with std::errc::operation_canceled once the
+ * stop is requested
+ */
 template <class Executor = coro::ExecutorBase, class Traits>
-inline decltype(auto) connect(const Endpoint<Traits> &ep, Poller &poller) {
-  return impl_connect::connect<Traits, Executor>(ep.raw(), poller);
+inline decltype(auto) connect(const Endpoint<Traits> &ep, Poller &poller,
+                              std::stop_token token = {}) {
+  return impl_connect::connect<Traits, Executor>(ep.raw(), poller, std::move(token));
 }
 
 template <class Executor = coro::ExecutorBase, class Traits>
 coro::Task<ConnectResult<Traits>, Executor> connect(const EndpointSet<Traits> &eps,
-                                                    Poller &poller) {
+                                                    Poller &poller, std::stop_token token = {}) {
   for (auto &ep : eps) {
-    auto res = co_await impl_connect::connect<Traits, Executor>(ep.raw(), poller);
+    auto res = co_await impl_connect::connect<Traits, Executor>(ep.raw(), poller, token);
     if (res) {
       co_return std::move(*res);
     }
+    if (res.error() == std::errc::operation_canceled) {
+      co_return std::unexpected{res.error()};
+    }
   }
   co_return std::unexpected{std::errc{errno}};
 }
+/**
+ * @brief connect to the endpoints before the deadline
+ *
+ * @param eps the endpoint or the endpoints, tried in order
+ * @param poller the poller to register the socket and arm the deadline
+ * @param deadline the deadline, shared by all the endpoints
+ * @param token the stop token of the caller
+ * @return coro::Task<ConnectResult<Traits>, Executor> std::errc::timed_out if the deadline passes
+ * first
+ */
+template <class Executor = coro::ExecutorBase, template <class> class Eps, class Traits>
+coro::Task<ConnectResult<Traits>, Executor> connect_until(
+    const Eps<Traits> &eps, Poller &poller, sync::TimerWheel::clock_type::time_point deadline,
+    std::stop_token token = {}) {
+  sync::Deadline timer{poller, deadline, std::move(token)};
+  auto res = co_await connect<Executor>(eps, poller, timer.token());
+  if (!res && res.error() == std::errc::operation_canceled && timer.expired()) {
+    co_return std::unexpected{std::errc::timed_out};
+  }
+  co_return res;
+}
+
+template <class Executor = coro::ExecutorBase, template <class> class Eps, class Traits,
+          class Rep, class Period>
+decltype(auto) connect_for(const Eps<Traits> &eps, Poller &poller,
+                           std::chrono::duration<Rep, Period> timeout,
+                           std::stop_token token = {}) {
+  return connect_until<Executor>(eps, poller, sync::TimerWheel::clock_type::now() + timeout,
+                                 std::move(token));
+}
 
 template <class Traits>
 using BindResult = std::expected<Socket<Traits>, std::errc>;
 
 namespace impl_bind {
-  static inline std::expected<int, std::errc> bind(addrinfo *ai) {
+  static inline std::expected<int, std::errc> bind(addrinfo *ai, bool reuse_port) {
     int tmp_fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
     if (tmp_fd == -1) [[unlikely]] {
       return std::unexpected{std::errc{errno}};
@@ -103,6 +162,11 @@ namespace impl_bind {
       return std::unexpected{std::errc{errno}};
     }
     LOG5("Set reuse addr to fd: {}", tmp_fd);
+    if (reuse_port && setsockopt(tmp_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)))
+        [[unlikely]] {
+      close(tmp_fd);
+      return std::unexpected{std::errc{errno}};
+    }
     if (bind(tmp_fd, ai->ai_addr, ai->ai_addrlen) == -1) [[unlikely]] {
       close(tmp_fd);
       return std::unexpected{std::errc{errno}};
@@ -111,14 +175,24 @@ namespace impl_bind {
   }
 }  // namespace impl_bind
 
+/**
+ * @brief bind a socket to the endpoint
+ *
+ * @param ep the endpoint
+ * @param reuse_port set SO_REUSEPORT, so that every listener of a sharded server gets its own
+ * accept queue
+ * @return BindResult<Traits>
+ */
 template <class Traits>
-BindResult<Traits> bind(const Endpoint<Traits> &ep) {
-  return impl_bind::bind(ep.raw()).transform([](int fd) { return Socket<Traits>(fd); });
+BindResult<Traits> bind(const Endpoint<Traits> &ep, bool reuse_port = false) {
+  return impl_bind::bind(ep.raw(), reuse_port).transform([](int fd) {
+    return Socket<Traits>(fd);
+  });
 }
 template <class Traits>
-BindResult<Traits> bind(const EndpointSet<Traits> &eps) {
+BindResult<Traits> bind(const EndpointSet<Traits> &eps, bool reuse_port = false) {
   for (auto &ep : eps) {
-    auto bind_res = impl_bind::bind(ep.raw());
+    auto bind_res = impl_bind::bind(ep.raw(), reuse_port);
     if (bind_res) {
       return Socket<Traits>{*bind_res};
     }
@@ -134,5 +208,54 @@ std::expected<void, std::errc> listen(S &skt, int max_connections = 10) {
   return {};
 }
 
+/**
+ * @brief steer the connections of a SO_REUSEPORT group to the socket serving the receiving cpu
+ *
+ * @note the sockets of the group are indexed in the order they start listening, the connections
+ * received by other cpus are spread by cpu modulo the group size
+ * @param skt any socket of the group
+ * @param cpus the cpu served by every socket of the group, -1 if the socket is not bound to a cpu
+ * @return std::expected<void, std::errc>
+ */
+template <SocketLike S>
+std::expected<void, std::errc> attach_reuseport_cbpf(S &skt, std::span<const int> cpus) {
+  // one load, two instructions for every cpu and two for the fallback
+  if (cpus.empty() || cpus.size() > (BPF_MAXINSNS - 3) / 2) {
+    return std::unexpected{std::errc::invalid_argument};
+  }
+  std::vector<sock_filter> code;
+  code.reserve(cpus.size() * 2 + 3);
+  code.push_back(
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)));
+  for (std::size_t i = 0; i < cpus.size(); ++i) {
+    if (cpus[i] < 0) {
+      continue;
+    }
+    code.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(cpus[i]), 0, 1));
+    code.push_back(BPF_STMT(BPF_RET | BPF_K, static_cast<uint32_t>(i)));
+  }
+  code.push_back(BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, static_cast<uint32_t>(cpus.size())));
+  code.push_back(BPF_STMT(BPF_RET | BPF_A, 0));
+  sock_fprog prog{static_cast<unsigned short>(code.size()), code.data()};
+  if (setsockopt(skt.raw(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) == -1) {
+    return std::unexpected{std::errc{errno}};
+  }
+  return {};
+}
+/**
+ * @brief prefer this socket of a SO_REUSEPORT group for the connections received by the cpu
+ *
+ * @param skt the socket
+ * @param cpu the cpu
+ * @return std::expected<void, std::errc>
+ */
+template <SocketLike S>
+std::expected<void, std::errc> set_incoming_cpu(S &skt, int cpu) {
+  if (setsockopt(skt.raw(), SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) == -1) {
+    return std::unexpected{std::errc{errno}};
+  }
+  return {};
+}
+
 XSL_SYS_NET_NE
 #endif
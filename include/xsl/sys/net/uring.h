@@ -0,0 +1,688 @@
+/**
+@file uring.h
+@brief completion based socket operations on the io_uring engine of sync::Poller
+
+ */
+#pragma once
+#ifndef XSL_SYS_NET_URING
+#  define XSL_SYS_NET_URING
+#  include "xsl/ai/dev.h"
+#  include "xsl/coro/task.h"
+#  include "xsl/feature.h"
+#  include "xsl/logctl.h"
+#  include "xsl/sync/poller.h"
+#  include "xsl/sync/uring.h"
+#  include "xsl/sys/io/dev.h"
+#  include "xsl/sys/net/def.h"
+#  include "xsl/sys/net/io.h"
+
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+
+#  include <algorithm>
+#  include <atomic>
+#  include <coroutine>
+#  include <cstddef>
+#  include <cstdint>
+#  include <cstring>
+#  include <deque>
+#  include <functional>
+#  include <memory>
+#  include <mutex>
+#  include <optional>
+#  include <span>
+#  include <stop_token>
+#  include <system_error>
+#  include <utility>
+XSL_SYS_NET_NB
+namespace impl_uring {
+  /// @brief the max size of a single splice, also the default capacity of a pipe
+  const std::size_t MAX_SPLICE_SIZE = 64 * 1024;
+
+  using resume_type = void (*)(std::coroutine_handle<>);
+
+  template <class Promise>
+  void resume(std::coroutine_handle<> handle) {
+    auto h = std::coroutine_handle<Promise>::from_address(handle.address());
+    h.promise().resume(h);
+  }
+  /**
+   * @brief the awaiter of a single operation
+   *
+   * @note once the stop is requested, the operation is cancelled and completes with -ECANCELED. A
+   * stop racing with the submission is recorded, and its cancel is queued after the operation
+   * @tparam Prep the function to prepare the sqe
+   */
+  template <class Prep>
+  class OpAwaiter : public sync::Completion {
+    /// @brief the operation is being submitted
+    static constexpr uint8_t SUBMITTING = 0;
+    /// @brief the stop is requested before the operation is queued
+    static constexpr uint8_t STOPPED = 1;
+    /// @brief the operation is queued, the stop cancels it by itself
+    static constexpr uint8_t SUBMITTED = 2;
+
+    class Cancel {
+    public:
+      Cancel(OpAwaiter &op) : _op(op) {}
+
+      void operator()() {
+        auto stage = SUBMITTING;
+        // the submission queues the cancel if it has not queued the operation yet
+        if (!this->_op._stage.compare_exchange_strong(stage, STOPPED, std::memory_order_acq_rel)) {
+          this->_op._poller.cancel(&this->_op);
+        }
+      }
+
+    private:
+      OpAwaiter &_op;
+    };
+
+  public:
+    using executor_type = void;
+
+    OpAwaiter(sync::Poller &poller, Prep &&prep, std::stop_token token)
+        : sync::Completion(&OpAwaiter::on_complete),
+          _poller(poller),
+          _prep(std::move(prep)),
+          _token(std::move(token)),
+          _callback(),
+          _stage(SUBMITTING),
+          _handle(),
+          _resume(nullptr),
+          _res(0) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    template <class Promise>
+    bool await_suspend(std::coroutine_handle<Promise> handle) {
+      this->_handle = handle;
+      this->_resume = &resume<Promise>;
+      if (this->_token.stop_requested()) {
+        this->_res = -ECANCELED;
+        return false;
+      }
+      // registered before the submission, this must not be touched after it
+      if (this->_token.stop_possible()) {
+        this->_callback.emplace(this->_token, Cancel{*this});
+        if (this->_token.stop_requested()) {
+          this->_callback.reset();
+          this->_res = -ECANCELED;
+          return false;
+        }
+      }
+      // called with the submission queue locked, the operation is not seen by the kernel yet
+      auto stopped = [this] {
+        return this->_stage.exchange(SUBMITTED, std::memory_order_acq_rel) == STOPPED;
+      };
+      if (!this->_poller.submit(this, this->_prep, stopped)) {
+        this->_callback.reset();
+        this->_res = -ECANCELED;
+        return false;
+      }
+      return true;
+    }
+    /**
+     * @brief the result of the operation
+     *
+     * @return int the cqe res, -errno on failure
+     */
+    int await_resume() noexcept {
+      // waits for the callback if it is cancelling on another thread
+      this->_callback.reset();
+      return this->_res;
+    }
+
+  private:
+    sync::Poller &_poller;
+    Prep _prep;
+    std::stop_token _token;
+    std::optional<std::stop_callback<Cancel>> _callback;
+    std::atomic_uint8_t _stage;
+    std::coroutine_handle<> _handle;
+    resume_type _resume;
+    int _res;
+
+    static void on_complete(sync::Completion *self, int res, uint32_t) {
+      auto op = static_cast<OpAwaiter *>(self);
+      op->_res = res;
+      op->_resume(op->_handle);
+    }
+  };
+
+  template <class Prep>
+  OpAwaiter<Prep> submit(sync::Poller &poller, Prep &&prep, std::stop_token token = {}) {
+    return OpAwaiter<Prep>(poller, std::forward<Prep>(prep), std::move(token));
+  }
+
+  struct Cqe {
+    int res;
+    uint32_t flags;
+  };
+  /**
+   * @brief the shared state of a multishot operation
+   *
+   * @note the state keeps itself alive while the operation is armed, only one consumer is allowed
+   */
+  class Multishot : public sync::Completion, public std::enable_shared_from_this<Multishot> {
+  public:
+    using prep_type = std::function<void(io_uring_sqe *)>;
+    using discard_type = std::function<void(const Cqe &)>;
+
+    class Awaiter {
+    public:
+      using executor_type = void;
+
+      Awaiter(Multishot &state) : _state(state) {}
+
+      bool await_ready() {
+        std::lock_guard guard(this->_state._mtx);
+        if (!this->_state._cqes.empty() || this->_state._stopped || this->_state._interrupted) {
+          return true;
+        }
+        if (!this->_state._armed) {
+          this->_state.arm();
+        }
+        return !this->_state._armed;
+      }
+
+      template <class Promise>
+      bool await_suspend(std::coroutine_handle<Promise> handle) {
+        std::lock_guard guard(this->_state._mtx);
+        if (!this->_state._cqes.empty() || !this->_state._armed || this->_state._interrupted) {
+          return false;
+        }
+        this->_state._handle = handle;
+        this->_state._resume = &resume<Promise>;
+        return true;
+      }
+      /**
+       * @brief the next cqe of the operation
+       *
+       * @return std::optional<Cqe> nullopt if the operation is stopped or the consumer is
+       * interrupted
+       */
+      std::optional<Cqe> await_resume() {
+        std::lock_guard guard(this->_state._mtx);
+        this->_state._interrupted = false;
+        if (this->_state._cqes.empty()) {
+          return std::nullopt;
+        }
+        auto cqe = this->_state._cqes.front();
+        this->_state._cqes.pop_front();
+        return cqe;
+      }
+
+    private:
+      Multishot &_state;
+    };
+
+    Multishot(sync::Poller &poller, prep_type &&prep, discard_type &&discard)
+        : sync::Completion(&Multishot::on_complete),
+          _poller(poller),
+          _prep(std::move(prep)),
+          _discard(std::move(discard)),
+          _mtx(),
+          _cqes(),
+          _handle(),
+          _resume(nullptr),
+          _armed(false),
+          _stopped(false),
+          _interrupted(false),
+          _self() {}
+
+    ~Multishot() {
+      for (auto &cqe : this->_cqes) {
+        this->_discard(cqe);
+      }
+    }
+
+    Awaiter next() { return Awaiter(*this); }
+    /**
+     * @brief resume the pending or the next consumer with nullopt, the operation keeps running
+     *
+     */
+    void interrupt() {
+      std::unique_lock guard(this->_mtx);
+      this->_interrupted = true;
+      if (this->_handle) {
+        auto handle = std::exchange(this->_handle, {});
+        auto resume = this->_resume;
+        guard.unlock();
+        resume(handle);
+      }
+    }
+    /**
+     * @brief drop the interruption not consumed by a consumer
+     *
+     */
+    void clear_interrupt() {
+      std::lock_guard guard(this->_mtx);
+      this->_interrupted = false;
+    }
+    /**
+     * @brief stop the operation, the pending consumer gets nullopt
+     *
+     */
+    void stop() {
+      std::lock_guard guard(this->_mtx);
+      this->_stopped = true;
+      if (this->_armed) {
+        this->_poller.cancel(this);
+      }
+    }
+
+  private:
+    sync::Poller &_poller;
+    prep_type _prep;
+    discard_type _discard;
+    std::mutex _mtx;
+    std::deque<Cqe> _cqes;
+    std::coroutine_handle<> _handle;
+    resume_type _resume;
+    bool _armed;
+    bool _stopped;
+    bool _interrupted;  ///< the consumer is interrupted by its stop token
+    std::shared_ptr<Multishot> _self;  ///< keep alive until the kernel drops the operation
+
+    /// @brief must be called with the lock held
+    void arm() {
+      this->_self = this->shared_from_this();
+      this->_armed = true;
+      if (!this->_poller.submit(this, this->_prep)) {
+        LOG3("Failed to arm multishot operation");
+        this->_armed = false;
+        this->_self.reset();
+        this->_cqes.push_back({-ECANCELED, 0});
+      }
+    }
+
+    static void on_complete(sync::Completion *self, int res, uint32_t flags) {
+      auto state = static_cast<Multishot *>(self);
+      std::shared_ptr<Multishot> hold;
+      std::unique_lock guard(state->_mtx);
+      if ((flags & IORING_CQE_F_MORE) == 0) {
+        state->_armed = false;
+        hold = std::move(state->_self);
+      }
+      if (!state->_stopped) {
+        state->_cqes.push_back({res, flags});
+      } else if (res >= 0) {
+        state->_discard({res, flags});
+      }
+      if (state->_handle && (!state->_cqes.empty() || !state->_armed)) {
+        auto handle = std::exchange(state->_handle, {});
+        auto resume = state->_resume;
+        guard.unlock();
+        resume(handle);
+      }
+    }
+  };
+  /**
+   * @brief interrupt the consumer of the multishot operation once the stop is requested, while the
+   * guard is alive
+   *
+   */
+  class Interrupt {
+    class Callback {
+    public:
+      Callback(Multishot &state) : _state(state) {}
+
+      void operator()() { this->_state.interrupt(); }
+
+    private:
+      Multishot &_state;
+    };
+
+  public:
+    Interrupt(Multishot &state, const std::stop_token &token) : _state(state), _callback() {
+      if (token.stop_possible()) {
+        this->_callback.emplace(token, Callback{state});
+      }
+    }
+    Interrupt(const Interrupt &) = delete;
+    Interrupt &operator=(const Interrupt &) = delete;
+    ~Interrupt() {
+      if (this->_callback) {
+        this->_callback.reset();
+        this->_state.clear_interrupt();
+      }
+    }
+
+  private:
+    Multishot &_state;
+    std::optional<std::stop_callback<Callback>> _callback;
+  };
+}  // namespace impl_uring
+
+/**
+ * @brief receive data from the socket by io_uring
+ *
+ * @tparam Executor default is coro::ExecutorBase
+ * @tparam S socket type
+ * @param poller the poller with the io_uring engine
+ * @param skt the socket
+ * @param buf the buffer
+ * @param token the stop token, the operation is cancelled once the stop is requested
+ * @return coro::Task<ai::Result, Executor>
+ */
+template <class Executor = coro::ExecutorBase, AsyncSocketLike<feature::In> S>
+coro::Task<ai::Result, Executor> uring_recv(sync::Poller &poller, S &skt, std::span<std::byte> buf,
+                                            std::stop_token token = {}) {
+  using Result = ai::Result;
+  int fd = skt.raw();
+  int n = co_await impl_uring::submit(
+      poller,
+      [fd, buf](io_uring_sqe *sqe) { sync::prep_recv(sqe, fd, buf.data(), buf.size(), 0); },
+      token);
+  LOG6("{} recv {} bytes", fd, n);
+  if (n > 0) {
+    co_return Result{static_cast<std::size_t>(n), std::nullopt};
+  } else if (n == 0) {
+    LOG5("recv eof");
+    co_return Result{0, {std::errc::no_message}};
+  } else if (n == -ECANCELED) {
+    co_return Result{0, {impl_io::wake_error(token)}};
+  }
+  LOG2("Failed to recv data, err : {}", strerror(-n));
+  co_return Result{0, {std::errc(-n)}};
+}
+/**
+ * @brief send all data to the socket by io_uring
+ *
+ * @tparam Executor default is coro::ExecutorBase
+ * @tparam S socket type
+ * @param poller the poller with the io_uring engine
+ * @param skt the socket
+ * @param data the data
+ * @param token the stop token, the operation is cancelled once the stop is requested
+ * @return coro::Task<ai::Result, Executor>
+ */
+template <class Executor = coro::ExecutorBase, AsyncSocketLike<feature::Out> S>
+coro::Task<ai::Result, Executor> uring_send(sync::Poller &poller, S &skt,
+                                            std::span<const std::byte> data,
+                                            std::stop_token token = {}) {
+  using Result = ai::Result;
+  int fd = skt.raw();
+  std::size_t total = data.size();
+  while (!data.empty()) {
+    int n = co_await impl_uring::submit(
+        poller,
+        [fd, data](io_uring_sqe *sqe) {
+          sync::prep_send(sqe, fd, data.data(), data.size(), MSG_NOSIGNAL);
+        },
+        token);
+    if (n < 0) {
+      co_return Result{total - data.size(),
+                       {n == -ECANCELED ? impl_io::wake_error(token) : std::errc(-n)}};
+    }
+    data = data.subspan(n);
+  }
+  co_return Result{total, std::nullopt};
+}
+/**
+ * @brief send file to socket by io_uring, the file is spliced to the socket through a pipe
+ *
+ * @tparam Executor default is coro::ExecutorBase
+ * @tparam S socket type
+ * @param poller the poller with the io_uring engine
+ * @param skt the socket
+ * @param hint sendfile hint
+ * @param token the stop token, the pending splice is cancelled once the stop is requested
+ * @return coro::Task<ai::Result, Executor>
+ * @note The skt must keep alive until the task is finished
+ */
+template <class Executor = coro::ExecutorBase, AsyncSocketLike<feature::Out> S>
+coro::Task<ai::Result, Executor> uring_sendfile(sync::Poller &poller, S &skt, SendfileHint hint,
+                                                std::stop_token token = {}) {
+  using Result = ai::Result;
+  int ffd = open(hint.path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (ffd == -1) {
+    LOG2("open file failed");
+    co_return Result{0, {std::errc(errno)}};
+  }
+  sys::io::NativeDevice file{ffd};
+  int pipefd[2];
+  if (pipe2(pipefd, O_CLOEXEC) == -1) {
+    co_return Result{0, {std::errc(errno)}};
+  }
+  sys::io::NativeDevice pipe_r{pipefd[0]}, pipe_w{pipefd[1]};
+  // a cancel by the shutdown of the poller is not a stop
+  auto error = [&token](int res, std::errc eof) {
+    return res == 0 ? eof : res == -ECANCELED ? impl_io::wake_error(token) : std::errc(-res);
+  };
+  int fd = skt.raw();
+  auto offset = static_cast<int64_t>(hint.offset);
+  std::size_t sent = 0;
+  while (sent < hint.size) {
+    std::size_t chunk = std::min(hint.size - sent, impl_uring::MAX_SPLICE_SIZE);
+    int n = co_await impl_uring::submit(
+        poller,
+        [&](io_uring_sqe *sqe) {
+          sync::prep_splice(sqe, file.raw(), offset, pipe_w.raw(), -1, chunk, 0);
+        },
+        token);
+    if (n <= 0) {
+      co_return Result{sent, {error(n, std::errc::no_message)}};
+    }
+    offset += n;
+    while (n > 0) {
+      // the last chunk is not held back by the cork of SPLICE_F_MORE
+      unsigned flags = sent + n < hint.size ? SPLICE_F_MORE : 0;
+      int m = co_await impl_uring::submit(
+          poller,
+          [&](io_uring_sqe *sqe) {
+            sync::prep_splice(sqe, pipe_r.raw(), -1, fd, -1, static_cast<std::size_t>(n), flags);
+          },
+          token);
+      if (m == -EAGAIN) {
+        // the splice is not retried by io_uring on a nonblocking socket, so it waits for the room
+        int polled = co_await impl_uring::submit(
+            poller, [&](io_uring_sqe *sqe) { sync::prep_poll_add(sqe, fd, POLLOUT, false); },
+            token);
+        if (polled < 0) {
+          co_return Result{sent, {error(polled, std::errc::broken_pipe)}};
+        }
+        continue;
+      }
+      if (m <= 0) {
+        co_return Result{sent, {error(m, std::errc::broken_pipe)}};
+      }
+      n -= m;
+      sent += m;
+    }
+  }
+  LOG6("{} send {} bytes file", fd, sent);
+  co_return Result{sent, std::nullopt};
+}
+/**
+ * @brief accept a connection by io_uring
+ *
+ * @tparam Executor default is coro::ExecutorBase
+ * @tparam S socket type
+ * @param poller the poller with the io_uring engine
+ * @param skt the listening socket
+ * @param addr the address of the peer, can be nullptr
+ * @param token the stop token, the operation is cancelled once the stop is requested
+ * @return coro::Task<std::expected<int, std::errc>, Executor> the accepted fd
+ */
+template <class Executor = coro::ExecutorBase, SocketLike S, class Addr>
+coro::Task<std::expected<int, std::errc>, Executor> uring_accept(sync::Poller &poller, S &skt,
+                                                                 Addr *addr,
+                                                                 std::stop_token token = {}) {
+  int fd = skt.raw();
+  auto [sockaddr, addrlen] = addr == nullptr ? Addr::null() : addr->raw();
+  int res = co_await impl_uring::submit(
+      poller,
+      [&](io_uring_sqe *sqe) {
+        sync::prep_accept(sqe, fd, sockaddr, addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC, false);
+      },
+      token);
+  if (res < 0) {
+    co_return std::unexpected{res == -ECANCELED ? std::errc::operation_canceled
+                                                : std::errc(-res)};
+  }
+  LOG5("accept socket {}", res);
+  co_return res;
+}
+
+/**
+ * @brief accept connections by a multishot accept
+ *
+ * @note only one consumer is allowed at the same time
+ */
+class MultishotAccept {
+public:
+  MultishotAccept(sync::Poller &poller, int fd)
+      : _state(std::make_shared<impl_uring::Multishot>(
+            poller,
+            [fd](io_uring_sqe *sqe) {
+              sync::prep_accept(sqe, fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC, true);
+            },
+            [](const impl_uring::Cqe &cqe) { close(cqe.res); })) {}
+  MultishotAccept(MultishotAccept &&) = default;
+  MultishotAccept &operator=(MultishotAccept &&) = default;
+  ~MultishotAccept() {
+    if (this->_state) {
+      this->_state->stop();
+    }
+  }
+  /**
+   * @brief accept a connection
+   *
+   * @tparam Executor default is coro::ExecutorBase
+   * @param token the stop token, the wait ends with std::errc::operation_canceled once the stop is
+   * requested, the multishot accept keeps running
+   * @return coro::Task<std::expected<int, std::errc>, Executor> the accepted fd
+   */
+  template <class Executor = coro::ExecutorBase>
+  coro::Task<std::expected<int, std::errc>, Executor> accept(std::stop_token token = {}) {
+    if (token.stop_requested()) {
+      co_return std::unexpected{std::errc::operation_canceled};
+    }
+    impl_uring::Interrupt guard{*this->_state, token};
+    auto cqe = co_await this->_state->next();
+    if (!cqe || cqe->res == -ECANCELED) {
+      co_return std::unexpected{std::errc::operation_canceled};
+    }
+    if (cqe->res < 0) {
+      co_return std::unexpected{std::errc(-cqe->res)};
+    }
+    LOG5("accept socket {}", cqe->res);
+    co_return cqe->res;
+  }
+
+private:
+  std::shared_ptr<impl_uring::Multishot> _state;
+};
+
+/**
+ * @brief receive data by a multishot receive with provided buffers
+ *
+ * @note only one consumer is allowed at the same time, the buffer ring is shared with the
+ * multishot receive, which may complete after this object is destroyed
+ */
+class MultishotRecv {
+public:
+  MultishotRecv(sync::Poller &poller, std::shared_ptr<sync::BufferRing> ring, int fd)
+      : _ring(ring),
+        _state(std::make_shared<impl_uring::Multishot>(
+            poller,
+            [fd, bgid = ring->group()](io_uring_sqe *sqe) {
+              sync::prep_recv_multishot(sqe, fd, bgid, 0);
+            },
+            [ring](const impl_uring::Cqe &cqe) {
+              if ((cqe.flags & IORING_CQE_F_BUFFER) != 0) {
+                ring->recycle(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+              }
+            })),
+        _pending(std::nullopt),
+        _offset(0) {}
+  MultishotRecv(MultishotRecv &&) = default;
+  MultishotRecv &operator=(MultishotRecv &&) = default;
+  ~MultishotRecv() {
+    if (!this->_state) {
+      return;
+    }
+    if (this->_pending) {
+      this->_ring->recycle(this->bid(*this->_pending));
+    }
+    this->_state->stop();
+  }
+  /**
+   * @brief receive data into the buffer, the rest of a provided buffer is kept for the next read
+   *
+   * @tparam Executor default is coro::ExecutorBase
+   * @param buf the buffer
+   * @param token the stop token, the wait ends with std::errc::operation_canceled once the stop is
+   * requested, the multishot receive keeps running
+   * @return coro::Task<ai::Result, Executor>
+   */
+  template <class Executor = coro::ExecutorBase>
+  coro::Task<ai::Result, Executor> read(std::span<std::byte> buf, std::stop_token token = {}) {
+    using Result = ai::Result;
+    if (!this->_pending) {
+      if (token.stop_requested()) {
+        co_return Result{0, {std::errc::operation_canceled}};
+      }
+      impl_uring::Interrupt guard{*this->_state, token};
+      auto cqe = co_await this->_state->next();
+      if (!cqe || cqe->res == -ECANCELED) {
+        co_return Result{0, {impl_io::wake_error(token)}};
+      }
+      if (cqe->res == 0) {
+        co_return Result{0, {std::errc::no_message}};
+      }
+      if (cqe->res < 0) {
+        co_return Result{0, {std::errc(-cqe->res)}};
+      }
+      this->_pending = *cqe;
+      this->_offset = 0;
+    }
+    auto len = static_cast<std::size_t>(this->_pending->res);
+    auto data = this->_ring->buffer(this->bid(*this->_pending), len).subspan(this->_offset);
+    auto n = std::min(data.size(), buf.size());
+    std::memcpy(buf.data(), data.data(), n);
+    this->_offset += n;
+    if (this->_offset == len) {
+      this->_ring->recycle(this->bid(*this->_pending));
+      this->_pending.reset();
+    }
+    co_return Result{n, std::nullopt};
+  }
+
+private:
+  std::shared_ptr<sync::BufferRing> _ring;
+  std::shared_ptr<impl_uring::Multishot> _state;
+  std::optional<impl_uring::Cqe> _pending;
+  std::size_t _offset;
+
+  static uint16_t bid(const impl_uring::Cqe &cqe) {
+    return static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+  }
+};
+
+/**
+ * @brief send file to socket, by io_uring if the socket is bound to a io_uring poller
+ *
+ * @tparam Executor default is coro::ExecutorBase
+ * @tparam S socket type
+ * @param skt socket
+ * @param hint sendfile hint
+ * @param token the stop token
+ * @return coro::Task<ai::Result, Executor>
+ */
+template <class Executor = coro::ExecutorBase, AsyncSocketLike<feature::Out> S>
+coro::Task<ai::Result, Executor> sendfile(S &skt, SendfileHint hint, std::stop_token token = {}) {
+  if constexpr (requires { skt.poller(); }) {
+    if (auto poller = skt.poller();
+        poller != nullptr && poller->engine() == sync::PollEngine::IO_URING) {
+      return uring_sendfile<Executor>(*poller, skt, std::move(hint), std::move(token));
+    }
+  }
+  return immediate_sendfile<Executor>(skt, std::move(hint), std::move(token));
+}
+XSL_SYS_NET_NE
+#endif
@@ -1,6 +1,7 @@
 #pragma once
 #ifndef XSL_SYS_PIPE
 #  define XSL_SYS_PIPE
+#  include "xsl/ai/dev.h"
 #  include "xsl/coro.h"
 #  include "xsl/feature.h"
 #  include "xsl/sys/def.h"
@@ -8,58 +9,211 @@
 
 #  include <fcntl.h>
 
+#  include <algorithm>
+#  include <concepts>
+#  include <cstddef>
+#  include <expected>
+#  include <mutex>
+#  include <optional>
+#  include <stop_token>
+#  include <system_error>
 #  include <utility>
+#  include <vector>
 XSL_SYS_NB
 
-const size_t MAX_SINGLE_FWD_SIZE = 4096;
+/// @brief the capacity requested for the pipes of a pool, F_SETPIPE_SZ rounds it up to pages
+const std::size_t DEFAULT_PIPE_SIZE = 256 * 1024;
+/// @brief the first chunk spliced into a pipe, it grows up to the capacity of the pipe
+const std::size_t MIN_SPLICE_CHUNK = 16 * 1024;
+
 std::pair<sys::io::Device<feature::In<std::byte>>, sys::io::Device<feature::Out<std::byte>>> pipe();
 std::pair<sys::io::AsyncDevice<feature::In<std::byte>>,
           sys::io::AsyncDevice<feature::Out<std::byte>>>
 async_pipe(std::shared_ptr<sync::Poller>& poller);
+/**
+ * @brief a nonblocking pipe used as the kernel buffer of a relay
+ *
+ */
+class Pipe {
+public:
+  Pipe(int read_fd, int write_fd, std::size_t capacity) noexcept
+      : _read(read_fd), _write(write_fd), _capacity(capacity) {}
+  Pipe(Pipe&&) noexcept = default;
+  Pipe& operator=(Pipe&&) noexcept = default;
+  ~Pipe() = default;
+
+  int read_end() const noexcept { return this->_read.raw(); }
+
+  int write_end() const noexcept { return this->_write.raw(); }
+
+  std::size_t capacity() const noexcept { return this->_capacity; }
+
+private:
+  io::NativeDevice _read;
+  io::NativeDevice _write;
+  std::size_t _capacity;
+};
+/**
+ * @brief a pool of pipes of the same capacity, so a relay does not create its pipe
+ *
+ * @note only empty pipes are put back, a pipe with data left is closed
+ */
+class PipePool {
+public:
+  /**
+   * @brief Construct a new Pipe Pool object
+   *
+   * @param capacity the capacity requested by F_SETPIPE_SZ, the default one is kept if refused
+   * @param max_idle the max count of the idle pipes kept
+   */
+  PipePool(std::size_t capacity = DEFAULT_PIPE_SIZE, std::size_t max_idle = 64);
+  PipePool(PipePool&&) = delete;
+  PipePool& operator=(PipePool&&) = delete;
+  ~PipePool();
+  /**
+   * @brief take an idle pipe, or create one
+   *
+   * @return std::expected<Pipe, std::errc>
+   */
+  std::expected<Pipe, std::errc> acquire();
+  /**
+   * @brief put the pipe back
+   *
+   * @param pipe the pipe
+   * @param empty whether the pipe is drained, otherwise it is closed
+   */
+  void release(Pipe&& pipe, bool empty);
+  /**
+   * @brief the pool of the calling thread, that is, of the reactor running on it
+   *
+   */
+  static PipePool& local();
 
-template <class Executor = coro::ExecutorBase>
-coro::Task<std::optional<std::errc>, Executor> splice_single(
-    io::AsyncDevice<feature::In<std::byte>> from, io::AsyncDevice<feature::Out<std::byte>> to) {
+private:
+  std::size_t _capacity;
+  std::size_t _max_idle;
+  std::mutex _mutex;  ///< a relay may be resumed on another thread
+  std::vector<Pipe> _idle;
+};
+/// @brief a nonblocking fd with a semaphore released once it is ready
+template <class D>
+concept ReadyDeviceLike = requires(D& dev) {
+  { dev.raw() } -> std::convertible_to<int>;
+  { dev.sem() } -> std::convertible_to<coro::CountingSemaphore<1>&>;
+};
+
+namespace impl_pipe {
+  inline std::errc wake_error(const std::stop_token& token) noexcept {
+    return token.stop_requested() ? std::errc::operation_canceled : std::errc::not_connected;
+  }
+}  // namespace impl_pipe
+/**
+ * @brief relay the data from one fd to another through a pooled pipe, until eof or an error
+ *
+ * @note the data never reaches the user space. The pipe is filled until the source would block
+ * or the pipe is full, then drained to the destination, so the source is not read again before
+ * the destination takes the data. A chunk filled completely doubles the next one, up to the
+ * capacity of the pipe, a chunk filled less than a quarter halves it
+ * @tparam Executor default is coro::ExecutorBase
+ * @tparam From the source, such as the read half of a socket
+ * @tparam To the destination, such as the write half of a socket
+ * @param from the source
+ * @param to the destination
+ * @param pool the pool of pipes
+ * @param token the stop token, the waits end with std::errc::operation_canceled once the stop is
+ * requested
+ * @return coro::Task<ai::Result, Executor> the size relayed, no error on eof
+ */
+template <class Executor = coro::ExecutorBase, ReadyDeviceLike From, ReadyDeviceLike To>
+coro::Task<ai::Result, Executor> relay(From& from, To& to, PipePool& pool,
+                                       std::stop_token token = {}) {
+  using Result = ai::Result;
+  auto pipe = pool.acquire();
+  if (!pipe) {
+    co_return Result{0, {pipe.error()}};
+  }
+  coro::StopGuard read_guard{from.sem(), token}, write_guard{to.sem(), token};
+  std::size_t total = 0, pending = 0, chunk = std::min(MIN_SPLICE_CHUNK, pipe->capacity());
+  std::optional<std::errc> err;
+  bool eof = false;
   while (true) {
-    ssize_t n = ::splice(from.raw(), nullptr, to.raw(), nullptr, MAX_SINGLE_FWD_SIZE,
-                         SPLICE_F_MOVE | SPLICE_F_MORE | SPLICE_F_NONBLOCK);
-    LOG5("recv n: {}", n);
-    if (n == 0) {
-      co_return std::nullopt;
-    } else if (n == -1) {
-      if (errno == EAGAIN) {
-        LOG5("no data");
-        if (!co_await from.sem()) {
-          LOG5("from {} is invalid", from.raw());
-          co_return std::nullopt;
+    bool full = false, drained = false;
+    std::optional<std::errc> read_err;
+    while (!eof && !read_err) {
+      if (pending == pipe->capacity()) {
+        full = true;
+        break;
+      }
+      auto want = std::min(chunk, pipe->capacity() - pending);
+      ssize_t n = ::splice(from.raw(), nullptr, pipe->write_end(), nullptr, want,
+                           SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      if (n > 0) {
+        pending += n;
+        if (static_cast<std::size_t>(n) == want) {
+          chunk = std::min(chunk * 2, pipe->capacity());
+        } else if (static_cast<std::size_t>(n) < want / 4) {
+          chunk = std::max(chunk / 2, std::min(MIN_SPLICE_CHUNK, pipe->capacity()));
+        }
+      } else if (n == 0) {
+        eof = true;
+      } else if (errno == EAGAIN) {
+        drained = true;
+        break;
+      } else {
+        read_err = std::errc(errno);
+      }
+    }
+    // the data taken before a failed read is still passed on
+    while (pending > 0 && !err) {
+      // more data follows at once only if the pipe was filled up
+      ssize_t n = ::splice(pipe->read_end(), nullptr, to.raw(), nullptr, pending,
+                           SPLICE_F_MOVE | SPLICE_F_NONBLOCK | (full ? SPLICE_F_MORE : 0));
+      if (n > 0) {
+        pending -= n;
+        total += n;
+      } else if (n == -1 && errno == EAGAIN) {
+        if (token.stop_requested()) {
+          err = std::errc::operation_canceled;
+        } else if (!co_await to.sem()) {
+          err = impl_pipe::wake_error(token);
         }
       } else {
-        LOG2("Failed to recv data, err : {}", strerror(errno));
-        co_return std::errc(errno);
+        err = n == 0 ? std::errc::broken_pipe : std::errc(errno);
+      }
+    }
+    if (!err) {
+      err = read_err;
+    }
+    if (err || eof) {
+      break;
+    }
+    if (drained) {
+      if (token.stop_requested()) {
+        err = std::errc::operation_canceled;
+        break;
+      }
+      if (!co_await from.sem()) {
+        err = impl_pipe::wake_error(token);
+        break;
       }
     }
-    LOG5("fwd: recv {} bytes", n);
   }
-  co_return std::nullopt;
-}
-
-template <class Executor = coro::ExecutorBase>
-coro::Lazy<void, Executor> splice(io::AsyncDevice<feature::In<std::byte>> from,
-                                  io::AsyncDevice<feature::Out<std::byte>> to,
-                                  io::AsyncDevice<feature::In<std::byte>> pipe_in,
-                                  io::AsyncDevice<feature::Out<std::byte>> pipe_out) {
-  splice_single<Executor>(std::move(from), std::move(pipe_out))
-      .detach(co_await coro::GetExecutor<Executor>());
-  splice_single<Executor>(std::move(pipe_in), std::move(to))
-      .detach(co_await coro::GetExecutor<Executor>());
-  co_return;
+  LOG6("relay {} bytes from {} to {}", total, from.raw(), to.raw());
+  pool.release(std::move(*pipe), pending == 0);
+  co_return Result{total, err};
 }
-template <class Executor = coro::ExecutorBase>
-coro::Lazy<void, Executor> splice(io::AsyncDevice<feature::In<std::byte>> from,
-                                  io::AsyncDevice<feature::Out<std::byte>> to,
-                                  std::shared_ptr<sync::Poller>& poller) {
-  auto [pipe_in, pipe_out] = async_pipe(poller);
-  return splice<Executor>(std::move(from), std::move(to), std::move(pipe_in), std::move(pipe_out));
+/**
+ * @brief relay the data from one fd to another through a pipe of the pool of this thread
+ *
+ * @tparam Executor default is coro::ExecutorBase
+ * @param from the source
+ * @param to the destination
+ * @param token the stop token
+ * @return coro::Task<ai::Result, Executor> the size relayed, no error on eof
+ */
+template <class Executor = coro::ExecutorBase, ReadyDeviceLike From, ReadyDeviceLike To>
+coro::Task<ai::Result, Executor> relay(From& from, To& to, std::stop_token token = {}) {
+  return relay<Executor>(from, to, PipePool::local(), std::move(token));
 }
 XSL_SYS_NE
 #endif
@@ -0,0 +1,218 @@
+#include "xsl/coro/def.h"
+#include "xsl/coro/pool.h"
+#include "xsl/logctl.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+XSL_CORO_NB
+namespace impl_pool {
+  /// @brief the number of rounds an idle worker looks for work before parking
+  const std::size_t SPIN_ROUNDS = 64;
+  /// @brief the interval of ticks to check the shared queue first, so it is not starved
+  const uint32_t INJECTED_INTERVAL = 61;
+  /// @brief the max number of jobs taken from the lifo slot in a row, so the deque is not starved
+  const uint32_t LIFO_STREAK = 3;
+
+  struct CurrentWorker {
+    const WorkStealingExecutor *pool = nullptr;
+    std::size_t idx = 0;
+  };
+  /// @brief the worker running on the current thread
+  static thread_local CurrentWorker current_worker;
+
+  static uint32_t xorshift(uint32_t &seed) noexcept {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+  }
+}  // namespace impl_pool
+
+WorkStealingExecutor::WorkStealingExecutor(std::size_t threads)
+    : _workers(),
+      _mtx(),
+      _injected(),
+      _injected_size(0),
+      _searching(0),
+      _sleepers(0),
+      _epoch(0),
+      _stopped(false) {
+  if (threads == 0) {
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  this->_workers.reserve(threads);
+  for (std::size_t i = 0; i < threads; ++i) {
+    auto &worker = this->_workers.emplace_back(std::make_unique<Worker>());
+    worker->seed = static_cast<uint32_t>(i * 2654435761u + 1);
+  }
+  // every worker may steal from the others once it starts, so they are started after all created
+  for (std::size_t i = 0; i < threads; ++i) {
+    this->_workers[i]->thread = std::thread([this, i] { this->run(i); });
+  }
+  LOG4("WorkStealingExecutor start with {} workers", threads);
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+  this->_stopped.store(true, std::memory_order_seq_cst);
+  this->_epoch.fetch_add(1, std::memory_order_seq_cst);
+  this->_epoch.notify_all();
+  for (auto &worker : this->_workers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+  // the jobs scheduled while the workers are exiting, no worker is running now
+  while (this->has_work()) {
+    for (std::size_t i = 0; i < this->_workers.size(); ++i) {
+      while (auto job = this->find(i)) {
+        (*job)();
+        delete job;
+      }
+    }
+  }
+  LOG4("WorkStealingExecutor stopped");
+}
+
+void WorkStealingExecutor::schedule(move_only_function<void()> &&func) {
+  auto job = new job_type{std::move(func)};
+  if (impl_pool::current_worker.pool == this) {
+    auto &worker = *this->_workers[impl_pool::current_worker.idx];
+    auto old = worker.lifo.exchange(job, std::memory_order_acq_rel);
+    if (old == nullptr) {
+      return;
+    }
+    worker.deque.push(old);
+  } else {
+    std::lock_guard guard(this->_mtx);
+    this->_injected.push_back(job);
+    this->_injected_size.fetch_add(1, std::memory_order_release);
+  }
+  this->notify();
+}
+
+void WorkStealingExecutor::run(std::size_t idx) {
+  impl_pool::current_worker = {this, idx};
+  while (true) {
+    if (auto job = this->find(idx)) {
+      (*job)();
+      delete job;
+      continue;
+    }
+    this->_searching.fetch_add(1, std::memory_order_seq_cst);
+    job_type *job = nullptr;
+    for (std::size_t i = 0; i < impl_pool::SPIN_ROUNDS && job == nullptr; ++i) {
+      job = this->steal(idx);
+      if (job == nullptr) {
+        std::this_thread::yield();
+      }
+    }
+    if (job != nullptr) {
+      // the last searching worker found work, there may be more, let another one search
+      if (this->_searching.fetch_sub(1, std::memory_order_seq_cst) == 1) {
+        this->notify();
+      }
+      (*job)();
+      delete job;
+      continue;
+    }
+    this->_searching.fetch_sub(1, std::memory_order_seq_cst);
+    if (this->_stopped.load(std::memory_order_acquire) && !this->has_work()) {
+      break;
+    }
+    this->park();
+  }
+  impl_pool::current_worker = {};
+}
+
+WorkStealingExecutor::job_type *WorkStealingExecutor::find(std::size_t idx) {
+  auto &worker = *this->_workers[idx];
+  if (++worker.tick % impl_pool::INJECTED_INTERVAL == 0) {
+    if (auto job = this->pop_injected()) {
+      return job;
+    }
+  }
+  if (worker.lifo_streak < impl_pool::LIFO_STREAK) {
+    if (auto job = worker.lifo.exchange(nullptr, std::memory_order_acq_rel)) {
+      ++worker.lifo_streak;
+      return job;
+    }
+  }
+  worker.lifo_streak = 0;
+  if (auto job = worker.deque.pop()) {
+    return job;
+  }
+  if (auto job = worker.lifo.exchange(nullptr, std::memory_order_acq_rel)) {
+    return job;
+  }
+  return this->pop_injected();
+}
+
+WorkStealingExecutor::job_type *WorkStealingExecutor::steal(std::size_t idx) {
+  if (auto job = this->pop_injected()) {
+    return job;
+  }
+  auto n = this->_workers.size();
+  auto start = impl_pool::xorshift(this->_workers[idx]->seed) % n;
+  for (std::size_t i = 0; i < n; ++i) {
+    auto victim_idx = (start + i) % n;
+    if (victim_idx == idx) {
+      continue;
+    }
+    auto &victim = *this->_workers[victim_idx];
+    if (auto job = victim.deque.steal()) {
+      return job;
+    }
+    // the victim may be blocked in a long job, do not leave its lifo slot behind
+    if (auto job = victim.lifo.exchange(nullptr, std::memory_order_acq_rel)) {
+      return job;
+    }
+  }
+  return nullptr;
+}
+
+WorkStealingExecutor::job_type *WorkStealingExecutor::pop_injected() {
+  if (this->_injected_size.load(std::memory_order_acquire) == 0) {
+    return nullptr;
+  }
+  std::lock_guard guard(this->_mtx);
+  if (this->_injected.empty()) {
+    return nullptr;
+  }
+  auto job = this->_injected.front();
+  this->_injected.pop_front();
+  this->_injected_size.fetch_sub(1, std::memory_order_relaxed);
+  return job;
+}
+
+bool WorkStealingExecutor::has_work() const {
+  if (this->_injected_size.load(std::memory_order_acquire) != 0) {
+    return true;
+  }
+  return std::ranges::any_of(this->_workers, [](const auto &worker) {
+    return !worker->deque.empty() || worker->lifo.load(std::memory_order_acquire) != nullptr;
+  });
+}
+
+void WorkStealingExecutor::park() {
+  this->_sleepers.fetch_add(1, std::memory_order_seq_cst);
+  // pairs with the fence in notify, either the new work is seen here or the sleeper is seen there
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  auto epoch = this->_epoch.load(std::memory_order_seq_cst);
+  if (!this->has_work() && !this->_stopped.load(std::memory_order_seq_cst)) {
+    this->_epoch.wait(epoch, std::memory_order_seq_cst);
+  }
+  this->_sleepers.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void WorkStealingExecutor::notify() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  // a searching worker will find the work, and wakes up another one if it is the last
+  if (this->_searching.load(std::memory_order_seq_cst) != 0
+      || this->_sleepers.load(std::memory_order_seq_cst) == 0) {
+    return;
+  }
+  this->_epoch.fetch_add(1, std::memory_order_seq_cst);
+  this->_epoch.notify_one();
+}
+XSL_CORO_NE
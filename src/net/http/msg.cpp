@@ -2,7 +2,13 @@
 #include "xsl/net/http/proto.h"
 #  include "xsl/net/http/def.h"
 
+#include <array>
+#include <charconv>
+#include <cstdint>
 #include <expected>
+#include <limits>
+#include <string>
+#include <string_view>
 
 XSL_HTTP_NB
 
@@ -13,7 +19,7 @@ RequestView::~RequestView() {}
 
 void RequestView::clear() {
   method = std::string_view{};
-  query.clear();
+  query = QueryView();
   version = std::string_view{};
   headers.clear();
 }
@@ -29,7 +35,8 @@ ResponsePart::ResponsePart(Version version, Status status_code,
     : status_code(status_code),
       status_message(std::move(status_message)),
       version(version),
-      headers() {}
+      headers(),
+      content_length() {}
 ResponsePart::ResponsePart(Version version, Status status_code)
     : ResponsePart(version, status_code, to_reason_phrase(status_code)) {}
 ResponsePart::ResponsePart(Version version, uint16_t status_code)
@@ -40,27 +47,46 @@ ResponsePart::ResponsePart(uint16_t status_code)
     : ResponsePart(Version::HTTP_1_1, status_code) {}
 
 ResponsePart::~ResponsePart() {}
-std::string ResponsePart::to_string() {
-  std::string res;
-  res.reserve(1024);
-  res += http::to_string_view(version);
-  res += " ";
-  res += http::to_string_view(status_code);
-  res += " ";
-  res += status_message;
-  res += "\r\n";
-  for (const auto& [key, value] : headers) {
-    res += key;
-    res += ": ";
-    res += value;
-    res += "\r\n";
+void ResponsePart::serialize(std::string& out) const {
+  // the Server field is the same for every response
+  static const std::string SERVER_FIELD = std::string("Server: ").append(SERVER_VERSION) + "\r\n";
+  if (auto line = to_status_line(this->version, this->status_code);
+      !line.empty() && this->status_message == to_reason_phrase(this->status_code)) {
+    out += line;
+  } else {
+    out += http::to_string_view(this->version);
+    out += ' ';
+    out += http::to_string_view(this->status_code);
+    out += ' ';
+    out += this->status_message;
+    out += "\r\n";
   }
-  if (!headers.contains("Server")) {
-    res += "Server: ";
-    res += SERVER_VERSION;
-    res += "\r\n";
+  this->headers.for_each([&out](std::string_view key, const std::string& value) {
+    out += key;
+    out += ": ";
+    out += value;
+    out += "\r\n";
+  });
+  // no content is sent with 1xx, 204 and 304, so neither is its length, see RFC 9110 8.6
+  auto code = static_cast<uint16_t>(this->status_code);
+  if (this->content_length && code >= 200 && code != 204 && code != 304
+      && !this->headers.contains(HeaderName::CONTENT_LENGTH)) {
+    std::array<char, std::numeric_limits<std::size_t>::digits10 + 1> digits;
+    auto [end, ec] = std::to_chars(digits.data(), digits.data() + digits.size(),
+                                   *this->content_length);
+    out += "Content-Length: ";
+    out.append(digits.data(), end);
+    out += "\r\n";
   }
-  res += "\r\n";
+  if (!this->headers.contains(HeaderName::SERVER)) {
+    out += SERVER_FIELD;
+  }
+  out += "\r\n";
+}
+
+std::string ResponsePart::to_string() {
+  std::string res;
+  this->serialize(res);
   return res;
 }
 XSL_HTTP_NE
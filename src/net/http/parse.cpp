@@ -1,116 +1,162 @@
 #include "xsl/net/http/parse.h"
-#include "xsl/regex.h"
+#include "xsl/net/http/scan.h"
 
-#include <regex>
+#include <algorithm>
+#include <string_view>
 #include <system_error>
+#include <utility>
 
 XSL_HTTP_NB
-ParseUnit::ParseUnit() : view() {}
+namespace impl_parse {
+  /// @brief HTTP-version = "HTTP/" DIGIT "." DIGIT
+  static bool is_http_version(std::string_view version) {
+    auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+    return version.size() == 8 && version.starts_with("HTTP/") && is_digit(version[5])
+           && version[6] == '.' && is_digit(version[7]);
+  }
+  /// @brief the length of the scheme at the beginning, scheme = ALPHA *( ALPHA / DIGIT / "+" /
+  /// "-" / "." ), 0 if none
+  static std::size_t scan_scheme(std::string_view target) {
+    auto is_alpha = [](char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); };
+    if (target.empty() || !is_alpha(target.front())) {
+      return 0;
+    }
+    std::size_t i = 1;
+    while (i < target.size()
+           && (is_alpha(target[i]) || (target[i] >= '0' && target[i] <= '9') || target[i] == '+'
+               || target[i] == '-' || target[i] == '.')) {
+      ++i;
+    }
+    return i;
+  }
+  /// @brief trim the optional whitespace, that is, SP and HTAB
+  static std::string_view trim_ows(std::string_view value) {
+    auto first = value.find_first_not_of(" \t");
+    if (first == std::string_view::npos) {
+      return {};
+    }
+    return value.substr(first, value.find_last_not_of(" \t") - first + 1);
+  }
+}  // namespace impl_parse
+
+ParseUnit::ParseUnit() : view(), _scanned(0) {}
 
 ParseResult ParseUnit::parse(const char* data, size_t len) {
-  std::expected<RequestView, std::errc> res = std::unexpected{std::errc()};
-  std::string_view view(data, len);
-  size_t pos = 0, parse_end = 0;
-  while (pos < len) {
-    size_t end = view.find("\r\n", pos);
-    if (end == std::string_view::npos) {
-      res = std::unexpected{std::errc::resource_unavailable_try_again};
-      break;
-    } else if (end == pos) {
-      parse_end = 2;
-      res = std::move(this->view);
+  std::size_t pos = 0;
+  // the bytes checked by the last call hold no line end, the scan goes on from there
+  std::size_t scan = std::min(std::exchange(this->_scanned, 0), len);
+  while (true) {
+    std::size_t end = scan + scan_ctl(data + scan, len - scan);
+    if (end == len || (data[end] == '\r' && end + 1 == len)) {
+      this->_scanned = end - pos;
+      return {pos, std::unexpected{std::errc::resource_unavailable_try_again}};
+    }
+    if (data[end] != '\r' || data[end + 1] != '\n') {
       this->view = RequestView();
-      break;
+      return {pos, std::unexpected{std::errc::illegal_byte_sequence}};
     }
-    if (this->view.version.empty() || this->view.method.empty()
-        || (this->view.path.empty() && this->view.authority.empty())) {
-      auto line = view.substr(pos, end - pos);
-      size_t _1sp = line.find(' ');
-      if (_1sp == std::string_view::npos) {
-        res = std::unexpected{std::errc::illegal_byte_sequence};
-        break;
+    std::string_view line(data + pos, end - pos);
+    std::size_t next = end + 2;
+    if (line.empty()) {
+      if (this->view.method.empty()) {
+        // the empty lines before the request line are ignored, see RFC 9112 2.2
+        pos = scan = next;
+        continue;
       }
-      this->view.method = line.substr(0, _1sp);
-      size_t _2sp = line.find(' ', _1sp + 1);
-      if (_2sp == std::string_view::npos) {
-        res = std::unexpected{std::errc::illegal_byte_sequence};
-        break;
-      }
-      this->parse_request_target(line.substr(_1sp + 1, _2sp - _1sp - 1));
-      auto tmp_version = line.substr(_2sp + 1);
-      if (std::regex_match(tmp_version.begin(), tmp_version.end(), regex::http_version_re)) {
-        this->view.version = tmp_version;
-      } else {
-        res = std::unexpected{std::errc::illegal_byte_sequence};
-        break;
-      }
-      pos = end + 2;
-    } else {
-      size_t colon = view.find(':', pos);
-      if (colon == std::string_view::npos) {
-        res = std::unexpected{std::errc::illegal_byte_sequence};
-        break;
-      }
-      auto key = view.substr(pos, colon - pos);
-      size_t vstart = view.find_first_not_of(' ', colon + 1);
-      size_t vend = view.find("\r\n", vstart);
-      if (vend == std::string_view::npos) {
-        res = std::unexpected{std::errc::illegal_byte_sequence};
-        break;
-      }
-      auto value = view.substr(vstart, vend - vstart);
-      this->view.headers[key] = value;
-      pos = vend + 2;
+      return {next, std::exchange(this->view, RequestView())};
+    }
+    bool ok = this->view.method.empty() ? this->parse_request_line(line)
+                                        : this->parse_field_line(line);
+    if (!ok) {
+      this->view = RequestView();
+      return {pos, std::unexpected{std::errc::illegal_byte_sequence}};
     }
+    pos = scan = next;
   }
-  return {pos + parse_end, std::move(res)};
 }
 
 ParseResult ParseUnit::parse(std::string_view data) {
   return this->parse(data.data(), data.length());
 }
 
-void ParseUnit::clear() { this->view.clear(); }
+void ParseUnit::clear() {
+  this->view.clear();
+  this->_scanned = 0;
+}
+
+bool ParseUnit::parse_request_line(std::string_view line) {
+  std::size_t method_end = scan_token(line.data(), line.size());
+  if (method_end == 0 || method_end == line.size() || line[method_end] != ' ') {
+    return false;
+  }
+  auto rest = line.substr(method_end + 1);
+  std::size_t target_end = rest.find(' ');
+  if (target_end == 0 || target_end == std::string_view::npos) {
+    return false;
+  }
+  auto version = rest.substr(target_end + 1);
+  if (!impl_parse::is_http_version(version)) {
+    return false;
+  }
+  if (!this->parse_request_target(rest.substr(0, target_end))) {
+    return false;
+  }
+  this->view.method = line.substr(0, method_end);
+  this->view.version = version;
+  return true;
+}
 
-void ParseUnit::parse_request_target(std::string_view target) {
-  static const std::regex REQUEST_TARGET_REGEX(std::format(
-      R"({}|{}|([^/?#]*)|{})", regex::origin_form, regex::absolute_form, regex::asterisk_form));
-  static const std::regex QUERY_REGEX(R"(([^&=]+)=([^&=]+))");
-  std::cmatch match;
-  if (std::regex_match(target.begin(), target.end(), match, REQUEST_TARGET_REGEX)) {
-    this->view.query.clear();
-    if (match[1].matched) {
-      this->view.scheme = "";
-      this->view.authority = "";
-      this->view.path = std::string_view(match[1].first, match[1].length());
-      std::cregex_iterator query_start(match[2].first, match[2].second, QUERY_REGEX);
-      std::cregex_iterator query_end;
-      while (query_start != query_end) {
-        this->view.query[std::string_view((*query_start)[1].first, (*query_start)[1].length())]
-            = std::string_view((*query_start)[2].first, (*query_start)[2].length());
-        ++query_start;
-      }
-    } else if (match[3].matched) {
-      this->view.scheme = std::string_view(match[3].first, match[3].length());
-      this->view.authority = std::string_view(match[4].first, match[4].length());
-      this->view.path = std::string_view(match[5].first, match[5].length());
-      std::cregex_iterator query_start(match[6].first, match[6].second, QUERY_REGEX);
-      std::cregex_iterator query_end;
-      while (query_start != query_end) {
-        this->view.query[std::string_view((*query_start)[1].first, (*query_start)[1].length())]
-            = std::string_view((*query_start)[2].first, (*query_start)[2].length());
-        ++query_start;
-      }
-    } else if (match[7].matched) {
+bool ParseUnit::parse_field_line(std::string_view line) {
+  std::size_t name_end = scan_token(line.data(), line.size());
+  // a line folded by the obsolete rule begins with whitespace, it is rejected, see RFC 9112 5.2
+  if (name_end == 0 || name_end == line.size() || line[name_end] != ':') {
+    return false;
+  }
+  this->view.headers.set(line.substr(0, name_end), impl_parse::trim_ows(line.substr(name_end + 1)));
+  return true;
+}
+
+bool ParseUnit::parse_request_target(std::string_view target) {
+  if (target == "*") {
+    this->view.scheme = "";
+    this->view.authority = "";
+    this->view.path = "*";
+    this->view.query = QueryView();
+    return true;
+  }
+  // a fragment is not sent in a request target, see RFC 9112 3.2
+  if (target.find('#') != std::string_view::npos) {
+    return false;
+  }
+  std::string_view scheme, authority;
+  if (target.front() != '/') {
+    std::size_t scheme_end = impl_parse::scan_scheme(target);
+    if (scheme_end != 0 && target.substr(scheme_end).starts_with("://")) {
+      // absolute-form = scheme "://" authority path-abempty [ "?" query ]
+      scheme = target.substr(0, scheme_end);
+      target.remove_prefix(scheme_end + 3);
+      std::size_t authority_end = std::min(target.find_first_of("/?"), target.size());
+      authority = target.substr(0, authority_end);
+      target.remove_prefix(authority_end);
+    } else if (target.find_first_of("/?") == std::string_view::npos) {
+      // authority-form = host ":" port, for CONNECT
       this->view.scheme = "";
-      this->view.authority = std::string_view(match[7].first, match[7].length());
+      this->view.authority = target;
       this->view.path = "";
-    } else if (match[8].matched) {
-      this->view.scheme = "";
-      this->view.authority = "";
-      this->view.path = "*";
+      this->view.query = QueryView();
+      return true;
+    } else {
+      return false;
     }
   }
+  // origin-form = absolute-path [ "?" query ], or the rest of absolute-form
+  std::size_t question = target.find('?');
+  this->view.scheme = scheme;
+  this->view.authority = authority;
+  this->view.path = target.substr(0, question);
+  this->view.query = question == std::string_view::npos ? QueryView()
+                                                        : QueryView(target.substr(question + 1));
+  return true;
 }
 
 XSL_HTTP_NE
@@ -1,7 +1,11 @@
 #include "xsl/net/http/def.h"
 #include "xsl/net/http/proto.h"
+#include "xsl/net/http/scan.h"
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string>
 XSL_HTTP_NB
 
 std::string_view to_string_view(const Version& version) {
@@ -19,105 +23,55 @@ std::string_view to_string_view(const Charset& charset) {
   return CHARSET_STRINGS[static_cast<uint8_t>(charset)];
 }
 
-static uint16_t to_index(Status status) {
-  switch (status) {
-    case Status::CONTINUE:
-      return 0;
-    case Status::SWITCHING_PROTOCOLS:
-      return 1;
-    case Status::OK:
-      return 2;
-    case Status::CREATED:
-      return 3;
-    case Status::ACCEPTED:
-      return 4;
-    case Status::NON_AUTHORITATIVE_INFORMATION:
-      return 5;
-    case Status::NO_CONTENT:
-      return 6;
-    case Status::RESET_CONTENT:
-      return 7;
-    case Status::PARTIAL_CONTENT:
-      return 8;
-    case Status::MULTIPLE_CHOICES:
-      return 9;
-    case Status::MOVED_PERMANENTLY:
-      return 10;
-    case Status::FOUND:
-      return 11;
-    case Status::SEE_OTHER:
-      return 12;
-    case Status::NOT_MODIFIED:
-      return 13;
-    case Status::USE_PROXY:
-      return 14;
-    case Status::TEMPORARY_REDIRECT:
-      return 15;
-    case Status::PERMANENT_REDIRECT:
-      return 16;
-    case Status::BAD_REQUEST:
-      return 17;
-    case Status::UNAUTHORIZED:
-      return 18;
-    case Status::PAYMENT_REQUIRED:
-      return 19;
-    case Status::FORBIDDEN:
-      return 20;
-    case Status::NOT_FOUND:
-      return 21;
-    case Status::METHOD_NOT_ALLOWED:
-      return 22;
-    case Status::NOT_ACCEPTABLE:
-      return 23;
-    case Status::PROXY_AUTHENTICATION_REQUIRED:
-      return 24;
-    case Status::REQUEST_TIMEOUT:
-      return 25;
-    case Status::CONFLICT:
-      return 26;
-    case Status::GONE:
-      return 27;
-    case Status::LENGTH_REQUIRED:
-      return 28;
-    case Status::PRECONDITION_FAILED:
-      return 29;
-    case Status::PAYLOAD_TOO_LARGE:
-      return 30;
-    case Status::URI_TOO_LONG:
-      return 31;
-    case Status::UNSUPPORTED_MEDIA_TYPE:
-      return 32;
-    case Status::RANGE_NOT_SATISFIABLE:
-      return 33;
-    case Status::EXPECTATION_FAILED:
-      return 34;
-    case Status::MISDIRECTED_REQUEST:
-      return 35;
-    case Status::UNPROCESSABLE_CONTENT:
-      return 36;
-    case Status::UPGRADE_REQUIRED:
-      return 37;
-    case Status::INTERNAL_SERVER_ERROR:
-      return 38;
-    case Status::NOT_IMPLEMENTED:
-      return 39;
-    case Status::BAD_GATEWAY:
-      return 40;
-    case Status::SERVICE_UNAVAILABLE:
-      return 41;
-    case Status::GATEWAY_TIMEOUT:
-      return 42;
-    case Status::HTTP_VERSION_NOT_SUPPORTED:
-      return 43;
-    default:
-      return 44;
+std::string_view to_string_view(const HeaderName& name) {
+  if (name == HeaderName::EXT) return "Unknown";
+  return HTTP_HEADER_NAME_STRINGS[static_cast<uint8_t>(name)];
+}
+
+/// @brief the index of each status code in the tables, the unknown codes index the last entry
+static constexpr auto STATUS_INDEX = [] {
+  std::array<uint8_t, 600> index{};
+  index.fill(HTTP_STATUS_COUNT - 1);
+  for (uint8_t i = 0; i < HTTP_STATUS_COUNT - 1; ++i) {
+    auto code = HTTP_STATUS_STRINGS[i];
+    index[(code[0] - '0') * 100 + (code[1] - '0') * 10 + (code[2] - '0')] = i;
   }
+  return index;
+}();
+
+static uint16_t to_index(Status status) {
+  auto code = static_cast<uint16_t>(status);
+  return code < STATUS_INDEX.size() ? STATUS_INDEX[code] : HTTP_STATUS_COUNT - 1;
 }
+/// @brief the status lines of HTTP/1.0 and HTTP/1.1 with the default reason phrases
+static const auto STATUS_LINES = [] {
+  std::array<std::array<std::string, HTTP_STATUS_COUNT - 1>, 2> lines;
+  for (std::size_t v = 0; v < lines.size(); ++v) {
+    auto version = HTTP_VERSION_STRINGS[static_cast<uint8_t>(Version::HTTP_1_0) + v];
+    for (std::size_t i = 0; i < lines[v].size(); ++i) {
+      auto& line = lines[v][i];
+      line.reserve(version.size() + HTTP_STATUS_STRINGS[i].size() + HTTP_REASON_PHRASES[i].size()
+                   + 4);
+      line.append(version).append(" ").append(HTTP_STATUS_STRINGS[i]).append(" ");
+      line.append(HTTP_REASON_PHRASES[i]).append("\r\n");
+    }
+  }
+  return lines;
+}();
 
 std::string_view to_string_view(Status status) { return HTTP_STATUS_STRINGS[to_index(status)]; }
 
 std::string_view to_reason_phrase(Status status) { return HTTP_REASON_PHRASES[to_index(status)]; }
 
+std::string_view to_status_line(Version version, Status status) {
+  auto index = to_index(status);
+  if ((version != Version::HTTP_1_0 && version != Version::HTTP_1_1)
+      || index == HTTP_STATUS_COUNT - 1) {
+    return {};
+  }
+  return STATUS_LINES[version == Version::HTTP_1_1][index];
+}
+
 XSL_HTTP_NE
 
 #include "xsl/def.h"
@@ -135,6 +89,15 @@ _net::http::Method from_string_view<_net::http::Method>(std::string_view method)
   if (iter == _net::http::HTTP_METHOD_STRINGS.end()) return _net::http::Method::UNKNOWN;
   return static_cast<_net::http::Method>(iter - _net::http::HTTP_METHOD_STRINGS.begin());
 }
+template <>
+_net::http::HeaderName from_string_view<_net::http::HeaderName>(std::string_view name) {
+  // the length rules out most of the names before they are compared
+  auto iter = std::ranges::find_if(_net::http::HTTP_HEADER_NAME_STRINGS, [name](auto known) {
+    return known.size() == name.size() && _net::http::iequal(known, name);
+  });
+  if (iter == _net::http::HTTP_HEADER_NAME_STRINGS.end()) return _net::http::HeaderName::EXT;
+  return static_cast<_net::http::HeaderName>(iter - _net::http::HTTP_HEADER_NAME_STRINGS.begin());
+}
 
 
 XSL_HTTP_NE
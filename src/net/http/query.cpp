@@ -0,0 +1,97 @@
+#include "xsl/net/http/query.h"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+XSL_HTTP_NB
+namespace impl_query {
+  static int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+      return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+      return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+      return c - 'A' + 10;
+    }
+    return -1;
+  }
+  /// @brief decode the octet at the position, return it with the length it takes
+  static std::pair<char, std::size_t> decode_at(std::string_view data, std::size_t pos,
+                                                bool plus_as_space) {
+    char c = data[pos];
+    if (c == '+' && plus_as_space) {
+      return {' ', 1};
+    }
+    if (c == '%' && pos + 2 < data.size()) {
+      int high = hex_value(data[pos + 1]), low = hex_value(data[pos + 2]);
+      if (high >= 0 && low >= 0) {
+        return {static_cast<char>(high << 4 | low), 3};
+      }
+    }
+    return {c, 1};
+  }
+  /// @brief compare the encoded data with the decoded one, without decoding it into a buffer
+  static bool decoded_equal(std::string_view encoded, std::string_view decoded) {
+    std::size_t i = 0, j = 0;
+    while (i < encoded.size()) {
+      if (j == decoded.size()) {
+        return false;
+      }
+      auto [c, len] = decode_at(encoded, i, true);
+      if (c != decoded[j]) {
+        return false;
+      }
+      i += len;
+      ++j;
+    }
+    return j == decoded.size();
+  }
+}  // namespace impl_query
+
+std::string percent_decode(std::string_view data, bool plus_as_space) {
+  std::string res;
+  res.reserve(data.size());
+  for (std::size_t i = 0; i < data.size();) {
+    auto [c, len] = impl_query::decode_at(data, i, plus_as_space);
+    res.push_back(c);
+    i += len;
+  }
+  return res;
+}
+
+void QueryView::Iterator::next() noexcept {
+  while (!this->_rest.empty()) {
+    std::size_t amp = this->_rest.find('&');
+    auto pair = this->_rest.substr(0, amp);
+    this->_rest = this->_rest.substr(amp == std::string_view::npos ? this->_rest.size() : amp + 1);
+    if (pair.empty()) {
+      continue;
+    }
+    std::size_t eq = pair.find('=');
+    if (eq == std::string_view::npos) {
+      this->_pair = {pair, std::string_view{}};
+    } else {
+      this->_pair = {pair.substr(0, eq), pair.substr(eq + 1)};
+    }
+    return;
+  }
+  this->_end = true;
+}
+
+std::optional<std::string_view> QueryView::find(std::string_view key) const noexcept {
+  for (auto [name, value] : *this) {
+    if (impl_query::decoded_equal(name, key)) {
+      return value;
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<std::string> QueryView::get(std::string_view key) const {
+  return this->find(key).transform([](std::string_view value) { return percent_decode(value); });
+}
+XSL_HTTP_NE
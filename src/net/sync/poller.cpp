@@ -2,10 +2,50 @@
 #include "xsl/sync/def.h"
 #include "xsl/sync/poller.h"
 
+#include <sys/eventfd.h>
+#include <sys/resource.h>
 #include <sys/signal.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
 #include <cstdint>
+#include <cstring>
+#include <utility>
 XSL_SYNC_NB
+namespace impl_poller {
+  const uint64_t URING_POLL_TAG = 1;
+  const uint64_t URING_IGNORE_TAG = 2;
+  static_assert(alignof(Completion) > (URING_POLL_TAG | URING_IGNORE_TAG),
+                "the low bits of the completion pointer are used as tags");
+  /// @brief the events which are meaningless for io_uring poll
+  const IOM_EVENTS URING_POLL_IGNORED
+      = IOM_EVENTS::ET | IOM_EVENTS::ONESHOT | IOM_EVENTS::EXCLUSIVE | IOM_EVENTS::WAKEUP;
+
+  /// @brief the max number of fds in the table, also keeps the fd in 30 bits for io_uring
+  const std::size_t MAX_FDS = std::size_t{1} << 22;
+
+  static uint64_t epoll_data(int fd, uint32_t generation) {
+    return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+  }
+  static uint64_t poll_data(int fd, uint32_t generation) {
+    return (static_cast<uint64_t>(generation) << 32)
+           | (static_cast<uint64_t>(static_cast<uint32_t>(fd)) << 2) | URING_POLL_TAG;
+  }
+  /// @brief the poller polled by the current thread
+  static thread_local Poller* current_poller = nullptr;
+  /// @brief the max number of posted functions run in one poll, the rest wait for the next poll
+  const std::size_t POSTED_BUDGET = 1024;
+
+  static sigset_t poll_mask() {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGQUIT);
+    return mask;
+  }
+}  // namespace impl_poller
 IOM_EVENTS operator|(IOM_EVENTS a, IOM_EVENTS b) {
   return static_cast<IOM_EVENTS>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
 }
@@ -23,6 +63,17 @@ IOM_EVENTS& operator&=(IOM_EVENTS& a, IOM_EVENTS b) {
 IOM_EVENTS operator~(IOM_EVENTS a) { return static_cast<IOM_EVENTS>(~static_cast<uint32_t>(a)); }
 bool operator!(IOM_EVENTS a) { return a == IOM_EVENTS::NONE; }
 
+std::string_view to_string(PollEngine engine) {
+  switch (engine) {
+    case PollEngine::EPOLL:
+      return "EPOLL";
+    case PollEngine::IO_URING:
+      return "IO_URING";
+    default:
+      return "UNKNOWN";
+  }
+}
+
 std::string_view to_string(PollHandleHintTag tag) {
   switch (tag) {
     case PollHandleHintTag::NONE:
@@ -36,94 +87,561 @@ std::string_view to_string(PollHandleHintTag tag) {
   }
 }
 
-Poller::Poller()
-    : Poller(
-          std::make_shared<HandleProxy>([](std::function<PollHandleHint()>&& f) { return f(); })) {}
-Poller::Poller(std::shared_ptr<HandleProxy>&& proxy) : fd(-1), handlers(), proxy(std::move(proxy)) {
-  this->fd = epoll_create(1);
-  LOG5("Poller fd: {}", this->fd.load());
+PollTable::PollTable() : _capacity(0), _segments(), _retired() {
+  std::size_t max_fds = impl_poller::MAX_FDS;
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_max != RLIM_INFINITY) {
+    max_fds = std::min(max_fds, static_cast<std::size_t>(limit.rlim_max));
+  }
+  this->_capacity = (max_fds + SEGMENT_SIZE - 1) >> SEGMENT_BITS;
+  this->_segments = std::make_unique<std::atomic<std::atomic<PollEntry*>*>[]>(this->_capacity);
+}
+PollTable::~PollTable() {
+  for (std::size_t i = 0; i < this->_capacity; ++i) {
+    auto segment = this->_segments[i].load(std::memory_order_relaxed);
+    if (segment == nullptr) {
+      continue;
+    }
+    for (std::size_t j = 0; j < SEGMENT_SIZE; ++j) {
+      if (auto entry = segment[j].load(std::memory_order_relaxed); entry != nullptr) {
+        entry->retire();
+      }
+    }
+    delete[] segment;
+  }
+  this->reclaim();
+}
+bool PollTable::store(int fd, PollEntry* entry) {
+  auto index = static_cast<std::size_t>(fd) >> SEGMENT_BITS;
+  if (fd < 0 || index >= this->_capacity) {
+    return false;
+  }
+  auto segment = this->_segments[index].load(std::memory_order_relaxed);
+  if (segment == nullptr) {
+    if (entry == nullptr) {
+      return true;
+    }
+    segment = new std::atomic<PollEntry*>[SEGMENT_SIZE] {};
+    this->_segments[index].store(segment, std::memory_order_release);
+  }
+  if (auto old = segment[fd & (SEGMENT_SIZE - 1)].exchange(entry, std::memory_order_acq_rel);
+      old != nullptr) {
+    this->_retired.push_back(old);
+  }
+  return true;
+}
+void PollTable::reclaim() {
+  for (auto entry : this->_retired) {
+    entry->retire();
+  }
+  this->_retired.clear();
+}
+
+Poller::Poller() : Poller(DEFAULT_POLL_ENGINE) {}
+Poller::Poller(PollEngine engine)
+    : Poller(engine, std::make_shared<HandleProxy>(
+                         [](std::function<PollHandleHint()>&& f) { return f(); })) {}
+Poller::Poller(std::shared_ptr<HandleProxy>&& proxy)
+    : Poller(DEFAULT_POLL_ENGINE, std::move(proxy)) {}
+Poller::Poller(PollEngine engine, std::shared_ptr<HandleProxy>&& proxy)
+    : fd(-1),
+      handlers(),
+      handlers_mutex(),
+      generation(0),
+      has_retired(false),
+      proxy(std::move(proxy)),
+      poll_engine(PollEngine::EPOLL),
+      ring(),
+      sq_mutex(),
+      loop_thread(),
+      next_bgid(0),
+      timers(),
+      timers_mutex(),
+      posted(),
+      wake_fd(-1),
+      woken(false) {
+  if (engine == PollEngine::IO_URING) {
+    auto ring = std::make_shared<IoUring>(URING_ENTRIES);
+    if (ring->valid()) {
+      this->fd = ring->raw();
+      this->ring = std::move(ring);
+      this->poll_engine = PollEngine::IO_URING;
+    } else {
+      WARN("io_uring is not available, fall back to epoll");
+    }
+  }
+  if (this->poll_engine == PollEngine::EPOLL) {
+    this->fd = epoll_create(1);
+  }
+  LOG5("Poller fd: {}, engine: {}", this->fd.load(), to_string(this->poll_engine));
+  if (!this->valid()) {
+    return;
+  }
+  this->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (this->wake_fd == -1) {
+    WARN("Failed to create eventfd, {}:{}", errno, strerror(errno));
+    return;
+  }
+  this->add(this->wake_fd, IOM_EVENTS::IN, [this](int fd, IOM_EVENTS events) {
+    if (!events) {
+      return PollHandleHint{PollHandleHintTag::DELETE};
+    }
+    // drained before the flag is cleared, otherwise a wakeup in between is drained while the flag
+    // stays set, and every later wakeup is skipped. A wakeup skipped after the drain is not lost,
+    // the posted functions, the timers and the validity are checked again after the dispatch
+    uint64_t cnt;
+    while (read(fd, &cnt, sizeof(cnt)) == sizeof(cnt)) {
+    }
+    this->woken.store(false, std::memory_order_release);
+    return PollHandleHint{PollHandleHintTag::NONE};
+  });
 }
 bool Poller::valid() { return this->fd != -1; }
 
 bool Poller::add(int fd, IOM_EVENTS events, PollHandler&& handler) {
-  epoll_event event;
-  event.events = static_cast<uint32_t>(events);
-  event.data.fd = fd;
-  auto guard = this->handlers.lock();
-  // must be here, otherwise the handler may be not registered
+  return this->add(fd, events, new HandlerEntry(events, std::move(handler)));
+}
+bool Poller::add(int fd, IOM_EVENTS events, PollEntry* entry) {
+  // must hold the lock, otherwise the handler may be not registered
   // in time when the event comes
-  if (epoll_ctl(this->fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+  std::unique_lock guard(this->handlers_mutex);
+  if (!this->handlers.in_range(fd)) {
+    WARN("Failed to add handler for fd: {}, out of range", fd);
+    guard.unlock();
+    entry->retire();
+    return false;
+  }
+  entry->events = events;
+  entry->generation = ++this->generation;
+  // stored before armed, otherwise the first edge may come before the entry and be dropped
+  this->replace(fd, entry);
+  bool armed;
+  if (this->poll_engine == PollEngine::IO_URING) {
+    std::lock_guard sq_guard(this->sq_mutex);
+    armed = this->arm(fd, *entry);
+    if (armed) {
+      this->kick();
+    }
+  } else {
+    epoll_event event;
+    event.events = static_cast<uint32_t>(events);
+    event.data.u64 = impl_poller::epoll_data(fd, entry->generation);
+    armed = epoll_ctl(this->fd, EPOLL_CTL_ADD, fd, &event) != -1;
+  }
+  if (!armed) {
+    // a lookup may have seen the entry, so it is retired by the table
+    this->replace(fd, nullptr);
     return false;
   }
   LOG5("Register {} for fd: {}", static_cast<uint32_t>(events), fd);
-  guard->insert_or_assign(fd, make_shared<PollHandler>(handler));
   return true;
 }
 bool Poller::modify(int fd, IOM_EVENTS events, std::optional<PollHandler>&& handler) {
-  epoll_event event;
-  event.events = (uint32_t)events;
-  event.data.fd = fd;
-  if (epoll_ctl(this->fd, EPOLL_CTL_MOD, fd, &event) == -1) {
-    WARN("Failed to modify handler for fd: {}, {}:{}", fd, errno, strerror(errno));
+  std::lock_guard guard(this->handlers_mutex);
+  auto old = this->handlers.load(fd);
+  if (old == nullptr) {
+    WARN("Failed to modify handler for fd: {}, not registered", fd);
     return false;
   }
+  // only a new handler needs a new entry, otherwise the events are updated in place
+  std::unique_ptr<PollEntry> entry;
   if (handler.has_value()) {
-    this->handlers.lock()->insert_or_assign(fd, make_shared<PollHandler>(*handler));
+    entry = std::make_unique<HandlerEntry>(events, std::move(*handler));
+    entry->generation = ++this->generation;
+  }
+  const PollEntry& target = entry ? *entry : *old;
+  if (this->poll_engine == PollEngine::IO_URING) {
+    std::lock_guard sq_guard(this->sq_mutex);
+    // io_uring poll can not be updated if it has been terminated, so remove and add it again
+    auto sqe = this->acquire_sqe();
+    if (sqe == nullptr) {
+      WARN("Failed to modify handler for fd: {}, submission queue is full", fd);
+      return false;
+    }
+    prep_poll_remove(sqe, impl_poller::poll_data(fd, old->generation));
+    sqe->user_data = impl_poller::URING_IGNORE_TAG;
+    old->events = events;
+    if (!this->arm(fd, target)) {
+      WARN("Failed to modify handler for fd: {}, submission queue is full", fd);
+      return false;
+    }
+    this->kick();
+  } else {
+    epoll_event event;
+    event.events = (uint32_t)events;
+    event.data.u64 = impl_poller::epoll_data(fd, target.generation);
+    if (epoll_ctl(this->fd, EPOLL_CTL_MOD, fd, &event) == -1) {
+      WARN("Failed to modify handler for fd: {}, {}:{}", fd, errno, strerror(errno));
+      return false;
+    }
+    old->events = events;
+  }
+  if (entry) {
+    this->replace(fd, entry.release());
   }
   return true;
 }
 void Poller::poll() {
   if (!this->valid()) {
+    // the ring is left to the polling thread if shutdown from another thread
+    this->close_ring();
     return;
   }
+  // no lookup is in progress between two polls, so the retired entries can be freed
+  if (this->has_retired.load(std::memory_order_acquire)) {
+    this->reclaim();
+  }
+  this->loop_thread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+  impl_poller::current_poller = this;
+  if (this->poll_engine == PollEngine::IO_URING) {
+    this->poll_uring(this->timeout());
+  } else {
+    this->poll_epoll(this->timeout());
+  }
+  this->expire();
+  this->run_posted(impl_poller::POSTED_BUDGET);
+  if (!this->valid()) {
+    this->close_ring();
+  }
+}
+void Poller::poll_epoll(int timeout) {
   // LOG6("Start polling");
   epoll_event events[10];
-  sigset_t mask;
-  sigemptyset(&mask);
-  sigaddset(&mask, SIGINT);
-  sigaddset(&mask, SIGTERM);
-  sigaddset(&mask, SIGQUIT);
-  int n = epoll_pwait(this->fd, events, 10, TIMEOUT, &mask);
+  sigset_t mask = impl_poller::poll_mask();
+  int n = epoll_pwait(this->fd, events, 10, timeout, &mask);
   if (n == -1) {
     LOG2("Failed to poll");
     return;
   }
   // LOG6("Polling {} events", n);
   for (int i = 0; i < n; i++) {
-    auto handler = this->handlers.lock_shared()->at(events[i].data.fd);
-    auto fd = events[i].data.fd;
-    auto ev = static_cast<IOM_EVENTS>(events[i].events);
-    LOG6("Handling {} for fd: {}", static_cast<uint32_t>(ev), fd);
-    PollHandleHint hint = (*this->proxy)(bind(*handler, fd, ev));
-    LOG5("HandleRes {} for fd: {}", to_string(hint.tag), (int)events[i].data.fd);
-    switch (hint.tag) {
-      case PollHandleHintTag::DELETE:
-        this->remove(events[i].data.fd);
-        break;
-      case PollHandleHintTag::MODIFY:
-        this->modify(events[i].data.fd, hint.data.events, std::nullopt);
-        break;
-      default:
-        break;
-    }
+    auto data = events[i].data.u64;
+    this->dispatch(static_cast<int>(static_cast<uint32_t>(data)), static_cast<uint32_t>(data >> 32),
+                   static_cast<IOM_EVENTS>(events[i].events));
   }
   // LOG6("Polling done");
 }
+void Poller::poll_uring(int timeout) {
+  unsigned to_submit;
+  {
+    std::lock_guard guard(this->sq_mutex);
+    to_submit = this->ring->flush();
+  }
+  // submit all the sqes prepared since the last poll and wait in one syscall
+  sigset_t mask = impl_poller::poll_mask();
+  int res = this->ring->enter(to_submit, 1, timeout, &mask);
+  if (res < 0 && res != -ETIME && res != -EINTR && res != -EBUSY) {
+    LOG2("Failed to poll, {}", strerror(-res));
+    return;
+  }
+  this->ring->for_each_cqe([this](const io_uring_cqe& cqe) {
+    if ((cqe.user_data & impl_poller::URING_IGNORE_TAG) != 0) {
+      return;
+    }
+    if ((cqe.user_data & impl_poller::URING_POLL_TAG) == 0) {
+      reinterpret_cast<Completion*>(cqe.user_data)->complete(cqe.res, cqe.flags);
+      return;
+    }
+    int fd = static_cast<int>((cqe.user_data >> 2) & 0x3fffffff);
+    auto generation = static_cast<uint32_t>(cqe.user_data >> 32);
+    if (cqe.res < 0) {
+      // the poll is removed or modified
+      if (cqe.res != -ECANCELED && cqe.res != -ENOENT) {
+        LOG3("Poll for fd: {} failed, {}", fd, strerror(-cqe.res));
+        this->dispatch(fd, generation, IOM_EVENTS::ERR | IOM_EVENTS::HUP);
+      }
+      return;
+    }
+    this->dispatch(fd, generation, static_cast<IOM_EVENTS>(cqe.res));
+    if ((cqe.flags & IORING_CQE_F_MORE) == 0) {
+      // the multishot poll is terminated by the kernel, arm it again if still registered
+      std::lock_guard guard(this->handlers_mutex);
+      if (auto entry = this->handlers.load(fd);
+          entry != nullptr && entry->generation == generation) {
+        std::lock_guard sq_guard(this->sq_mutex);
+        this->arm(fd, *entry);
+      }
+    }
+  });
+}
+int Poller::timeout() {
+  if (!this->posted.empty()) {
+    return 0;
+  }
+  std::lock_guard guard(this->timers_mutex);
+  // nothing to do until an event arrives, the other threads wake the poller up
+  return this->timers.timeout(TimerWheel::clock_type::now(), -1);
+}
+void Poller::expire() {
+  Timer* expired;
+  {
+    std::lock_guard guard(this->timers_mutex);
+    if (this->timers.empty()) {
+      return;
+    }
+    expired = this->timers.advance(TimerWheel::clock_type::now());
+  }
+  // the callbacks may rearm or destroy their timers, so the chain is walked ahead
+  while (expired != nullptr) {
+    std::exchange(expired, TimerWheel::next(expired))->fire();
+  }
+}
+bool Poller::add_timer(Timer* timer, TimerWheel::clock_type::time_point deadline) {
+  {
+    std::lock_guard guard(this->timers_mutex);
+    if (!this->valid()) {
+      return false;
+    }
+    this->timers.arm(timer, deadline);
+  }
+  if (!this->in_loop()) {
+    // the poll timeout may be longer than the new deadline
+    this->wake();
+  }
+  return true;
+}
+bool Poller::remove_timer(Timer* timer) {
+  std::lock_guard guard(this->timers_mutex);
+  return this->timers.cancel(timer);
+}
+Poller* Poller::current() noexcept { return impl_poller::current_poller; }
+bool Poller::post(_coro::move_only_function<void()>&& func) {
+  if (!this->valid()) {
+    return false;
+  }
+  this->posted.push(new Posted{std::move(func)});
+  if (!this->in_loop()) {
+    this->wake();
+  }
+  return true;
+}
+void Poller::wake() {
+  if (this->wake_fd == -1 || this->woken.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+  uint64_t one = 1;
+  if (write(this->wake_fd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+    WARN("Failed to wake up the poller, {}:{}", errno, strerror(errno));
+  }
+}
+bool Poller::run_posted(std::size_t budget) {
+  for (; budget > 0; --budget) {
+    auto task = this->posted.pop();
+    if (task == nullptr) {
+      return true;
+    }
+    task->func();
+    delete task;
+  }
+  return this->posted.empty();
+}
+void Poller::dispatch(int fd, uint32_t generation, IOM_EVENTS ev) {
+  auto entry = this->handlers.load(fd);
+  if (entry == nullptr || entry->generation != generation) {
+    LOG5("No handler for fd: {}", fd);
+    return;
+  }
+  LOG6("Handling {} for fd: {}", static_cast<uint32_t>(ev), fd);
+  PollHandleHint hint = (*this->proxy)([entry, fd, ev] { return entry->handle(fd, ev); });
+  LOG5("HandleRes {} for fd: {}", to_string(hint.tag), fd);
+  switch (hint.tag) {
+    case PollHandleHintTag::DELETE:
+      this->remove(fd);
+      break;
+    case PollHandleHintTag::MODIFY:
+      this->modify(fd, hint.data.events, std::nullopt);
+      break;
+    default:
+      break;
+  }
+}
+void Poller::reclaim() {
+  std::lock_guard guard(this->handlers_mutex);
+  this->has_retired.store(false, std::memory_order_relaxed);
+  this->handlers.reclaim();
+}
+PollEntry* Poller::replace(int fd, PollEntry* entry) {
+  auto old = this->handlers.load(fd);
+  this->handlers.store(fd, entry);
+  if (old != nullptr) {
+    this->has_retired.store(true, std::memory_order_release);
+  }
+  return old;
+}
+bool Poller::arm(int fd, const PollEntry& entry) {
+  auto sqe = this->acquire_sqe();
+  if (sqe == nullptr) {
+    return false;
+  }
+  prep_poll_add(sqe, fd, static_cast<uint32_t>(entry.events & ~impl_poller::URING_POLL_IGNORED),
+                true);
+  sqe->user_data = impl_poller::poll_data(fd, entry.generation);
+  return true;
+}
+io_uring_sqe* Poller::acquire_sqe() {
+  if (this->fd == -1 || !this->ring) {
+    return nullptr;
+  }
+  auto sqe = this->ring->get_sqe();
+  if (sqe == nullptr) {
+    // the submission queue is full, submit the pending sqes to make room
+    this->ring->enter(this->ring->flush(), 0);
+    sqe = this->ring->get_sqe();
+  }
+  return sqe;
+}
+void Poller::kick() {
+  // the polling thread submits the sqes in batch before waiting
+  if (this->loop_thread.load(std::memory_order_relaxed) != std::this_thread::get_id()) {
+    this->ring->enter(this->ring->flush(), 0);
+  }
+}
+bool Poller::cancel(Completion* completion) {
+  std::lock_guard guard(this->sq_mutex);
+  if (!this->queue_cancel(completion)) {
+    return false;
+  }
+  this->kick();
+  return true;
+}
+bool Poller::queue_cancel(Completion* completion) {
+  auto sqe = this->acquire_sqe();
+  if (sqe == nullptr) {
+    LOG3("Failed to cancel the operation, the submission queue is full");
+    return false;
+  }
+  prep_cancel(sqe, reinterpret_cast<uint64_t>(completion), 0);
+  sqe->user_data = impl_poller::URING_IGNORE_TAG;
+  return true;
+}
+std::shared_ptr<BufferRing> Poller::make_buffer_ring(uint16_t count, uint32_t size) {
+  std::shared_ptr<IoUring> ring;
+  {
+    std::lock_guard guard(this->sq_mutex);
+    if (!this->valid() || !this->ring) {
+      return nullptr;
+    }
+    ring = this->ring;
+  }
+  auto br = std::make_shared<BufferRing>(std::move(ring), this->next_bgid++, count, size);
+  if (!br->valid()) {
+    return nullptr;
+  }
+  return br;
+}
 void Poller::remove(int fd) {
-  epoll_ctl(this->fd, EPOLL_CTL_DEL, fd, nullptr);
-  (*this->handlers.lock()).erase(fd);
+  std::lock_guard guard(this->handlers_mutex);
+  auto old = this->handlers.load(fd);
+  if (this->poll_engine == PollEngine::IO_URING) {
+    if (old != nullptr) {
+      std::lock_guard sq_guard(this->sq_mutex);
+      if (auto sqe = this->acquire_sqe(); sqe != nullptr) {
+        prep_poll_remove(sqe, impl_poller::poll_data(fd, old->generation));
+        sqe->user_data = impl_poller::URING_IGNORE_TAG;
+        this->kick();
+      }
+    }
+  } else {
+    epoll_ctl(this->fd, EPOLL_CTL_DEL, fd, nullptr);
+  }
+  this->replace(fd, nullptr);
 }
 void Poller::shutdown() {
-  if (!this->valid()) {
+  int old;
+  {
+    // no more submissions from now on
+    std::lock_guard guard(this->sq_mutex);
+    old = this->fd.exchange(-1);
+  }
+  if (old == -1) {
     return;
   }
+  // the polling thread stops once it is woken up
+  this->wake();
+  if (this->poll_engine == PollEngine::IO_URING
+      && (this->in_loop()
+          || this->loop_thread.load(std::memory_order_relaxed) == std::thread::id{})) {
+    // otherwise the polling thread may be consuming the ring, it closes the ring once woken up
+    this->close_ring();
+  }
   LOG5("call all handlers with NONE");
-  for (auto& [key, value] : *this->handlers.lock()) {
-    (*value)(key, IOM_EVENTS::NONE);
+  // the handlers may remove themselves, so they are called without the lock
+  std::vector<std::pair<int, PollEntry*>> entries;
+  {
+    std::lock_guard guard(this->handlers_mutex);
+    this->handlers.for_each(
+        [&entries](int fd, PollEntry& entry) { entries.emplace_back(fd, &entry); });
+  }
+  for (auto& [key, value] : entries) {
+    value->handle(key, IOM_EVENTS::NONE);
+  }
+  if (this->poll_engine == PollEngine::EPOLL) {
+    LOG5("close poller");
+    close(old);
+  }
+  LOG5("fire all timers");
+  // no timer can be armed once the poller is invalid
+  Timer* fired;
+  {
+    std::lock_guard guard(this->timers_mutex);
+    fired = this->timers.clear();
+  }
+  while (fired != nullptr) {
+    std::exchange(fired, TimerWheel::next(fired))->fire();
+  }
+  if (this->in_loop() || this->loop_thread.load(std::memory_order_relaxed) == std::thread::id{}) {
+    LOG5("run the posted functions");
+    while (!this->run_posted(impl_poller::POSTED_BUDGET)) {
+    }
+  }
+  if (impl_poller::current_poller == this) {
+    impl_poller::current_poller = nullptr;
   }
+}
+void Poller::close_ring() {
+  std::shared_ptr<IoUring> ring;
+  {
+    std::lock_guard guard(this->sq_mutex);
+    if (!this->ring) {
+      return;
+    }
+    ring = this->ring;
+    LOG5("cancel all pending operations");
+    // the poller is invalid, so the sqes are acquired from the ring directly
+    auto sqe = ring->get_sqe();
+    if (sqe == nullptr) {
+      ring->enter(ring->flush(), 0);
+      sqe = ring->get_sqe();
+    }
+    if (sqe != nullptr) {
+      prep_cancel(sqe, 0, IORING_ASYNC_CANCEL_ANY);
+      sqe->user_data = impl_poller::URING_IGNORE_TAG;
+    }
+    ring->enter(ring->flush(), 0);
+  }
+  int res;
+  do {
+    ring->for_each_cqe([](const io_uring_cqe& cqe) {
+      if ((cqe.user_data & (impl_poller::URING_IGNORE_TAG | impl_poller::URING_POLL_TAG)) == 0) {
+        reinterpret_cast<Completion*>(cqe.user_data)->complete(cqe.res, cqe.flags);
+      }
+    });
+    res = ring->enter(0, 1, 10);
+  } while (res >= 0 || res == -EINTR);
   LOG5("close poller");
-  close(this->fd);
-  this->fd = -1;
+  // the buffer rings share the ring, it is closed once they are destroyed
+  std::lock_guard guard(this->sq_mutex);
+  this->ring.reset();
+}
+Poller::~Poller() {
+  this->shutdown();
+  // the polling thread may stop before it closes the ring
+  this->close_ring();
+  // no thread is polling now
+  while (!this->run_posted(impl_poller::POSTED_BUDGET)) {
+  }
+  if (this->wake_fd != -1) {
+    close(this->wake_fd);
+  }
 }
-Poller::~Poller() { this->shutdown(); }
 XSL_SYNC_NE
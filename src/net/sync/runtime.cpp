@@ -0,0 +1,95 @@
+#include "xsl/logctl.h"
+#include "xsl/sync/def.h"
+#include "xsl/sync/runtime.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cstring>
+XSL_SYNC_NB
+Reactor::Reactor(PollEngine engine)
+    : _poller(std::make_shared<Poller>(engine)), _stopped(false) {}
+
+Reactor::~Reactor() { this->_poller->shutdown(); }
+
+void Reactor::schedule(_coro::move_only_function<void()> &&func) {
+  if (!this->_poller->post(std::move(func))) {
+    // the poller is shutdown, resume the coroutine to let it observe the shutdown
+    func();
+  }
+}
+
+void Reactor::run() {
+  LOG4("Reactor start with {}", to_string(this->_poller->engine()));
+  while (!this->_stopped.load(std::memory_order_acquire) && this->_poller->valid()) {
+    this->_poller->poll();
+  }
+  // the handlers are invoked with NONE, the coroutines they release are resumed in place
+  this->_poller->shutdown();
+  LOG4("Reactor stopped");
+}
+
+void Reactor::stop() {
+  this->_stopped.store(true, std::memory_order_release);
+  this->_poller->wake();
+}
+
+Runtime::Runtime(std::size_t threads, PollEngine engine)
+    : _reactors(), _threads(), _cpus(), _next(0) {
+  if (threads == 0) {
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  this->_reactors.reserve(threads);
+  for (std::size_t i = 0; i < threads; ++i) {
+    this->_reactors.push_back(std::make_shared<Reactor>(engine));
+  }
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0
+      && static_cast<std::size_t>(CPU_COUNT(&allowed)) >= threads) {
+    // pinning more reactors than cores only makes them fight for the same core
+    for (int cpu = 0; cpu < CPU_SETSIZE && this->_cpus.size() < threads; ++cpu) {
+      if (CPU_ISSET(cpu, &allowed)) {
+        this->_cpus.push_back(cpu);
+      }
+    }
+  }
+}
+
+Runtime::~Runtime() {
+  this->stop();
+  this->join();
+}
+
+void Runtime::start() {
+  for (std::size_t i = 0; i < this->_reactors.size(); ++i) {
+    auto &thread = this->_threads.emplace_back([reactor = this->_reactors[i]] { reactor->run(); });
+    if (this->_cpus.empty()) {
+      continue;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(this->_cpus[i], &set);
+    if (int res = pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set); res != 0) {
+      WARN("Failed to pin reactor {} to cpu {}, {}", i, this->_cpus[i], strerror(res));
+    }
+  }
+  LOG4("Runtime start with {} reactors", this->_reactors.size());
+}
+
+void Runtime::stop() {
+  for (auto &reactor : this->_reactors) {
+    reactor->stop();
+  }
+}
+
+void Runtime::join() {
+  for (auto &thread : this->_threads) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+  this->_threads.clear();
+}
+XSL_SYNC_NE
@@ -0,0 +1,237 @@
+#include "xsl/sync/def.h"
+#include "xsl/sync/timer.h"
+
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <utility>
+XSL_SYNC_NB
+namespace impl_timer {
+  /// @brief the distance from the position to the first set bit, wrapping around the bitmap
+  static std::size_t distance(const uint64_t *bits, std::size_t words, std::size_t from) {
+    std::size_t total = words * 64;
+    for (std::size_t d = 0; d < total;) {
+      std::size_t pos = (from + d) % total;
+      if (uint64_t word = bits[pos / 64] >> (pos % 64); word != 0) {
+        return d + static_cast<std::size_t>(std::countr_zero(word));
+      }
+      d += 64 - pos % 64;
+    }
+    return total;
+  }
+  static std::size_t shift_of(std::size_t level) {
+    return TimerWheel::ROOT_BITS + (level - 1) * TimerWheel::LEVEL_BITS;
+  }
+}  // namespace impl_timer
+
+TimerWheel::TimerWheel()
+    : _epoch(clock_type::now()),
+      _current(0),
+      _count(0),
+      _root{},
+      _levels{},
+      _root_bits{},
+      _level_bits{} {}
+
+TimerWheel::~TimerWheel() { this->clear(); }
+
+uint64_t TimerWheel::tick(clock_type::time_point tp) const noexcept {
+  if (tp <= this->_epoch) {
+    return 0;
+  }
+  return static_cast<uint64_t>(
+      std::chrono::ceil<std::chrono::milliseconds>(tp - this->_epoch).count());
+}
+
+uint64_t TimerWheel::elapsed(clock_type::time_point now) const noexcept {
+  if (now <= this->_epoch) {
+    return 0;
+  }
+  return static_cast<uint64_t>(
+      std::chrono::floor<std::chrono::milliseconds>(now - this->_epoch).count());
+}
+
+void TimerWheel::arm(Timer *timer, clock_type::time_point deadline) {
+  if (timer->_armed) {
+    this->unlink(timer);
+  } else {
+    timer->_armed = true;
+    ++this->_count;
+  }
+  timer->_expiry = this->tick(deadline);
+  this->link(timer);
+}
+
+bool TimerWheel::cancel(Timer *timer) noexcept {
+  if (!timer->_armed) {
+    return false;
+  }
+  this->unlink(timer);
+  timer->_armed = false;
+  --this->_count;
+  return true;
+}
+
+Timer *TimerWheel::advance(clock_type::time_point now) {
+  auto target = this->elapsed(now);
+  Timer *expired = nullptr;
+  while (this->_current <= target) {
+    if (this->_count == 0) {
+      // nothing to cascade or expire, jump to the target directly
+      this->_current = target + 1;
+      break;
+    }
+    auto idx = static_cast<std::size_t>(this->_current & (ROOT_SIZE - 1));
+    if (idx == 0) {
+      // the root level wraps, refill it from the upper levels
+      for (std::size_t level = 1; level < LEVELS; ++level) {
+        auto slot = static_cast<uint8_t>((this->_current >> impl_timer::shift_of(level))
+                                         & (LEVEL_SIZE - 1));
+        this->cascade(static_cast<uint8_t>(level), slot);
+        if (slot != 0) {
+          break;
+        }
+      }
+    }
+    if (this->_root[idx] == nullptr) {
+      // skip the empty slots until the next timer, the next wrap or the target
+      auto next = impl_timer::distance(this->_root_bits.data(), this->_root_bits.size(), idx);
+      auto step = std::min({next, ROOT_SIZE - idx,
+                            static_cast<std::size_t>(target + 1 - this->_current)});
+      this->_current += std::max<std::size_t>(step, 1);
+      continue;
+    }
+    auto head = std::exchange(this->_root[idx], nullptr);
+    this->_root_bits[idx / 64] &= ~(uint64_t{1} << (idx % 64));
+    while (head != nullptr) {
+      auto next = head->_next;
+      head->_armed = false;
+      --this->_count;
+      head->_prev = nullptr;
+      head->_next = expired;
+      expired = head;
+      head = next;
+    }
+    ++this->_current;
+  }
+  return expired;
+}
+
+Timer *TimerWheel::clear() noexcept {
+  Timer *cleared = nullptr;
+  auto take = [&cleared](Timer *&head) {
+    while (head != nullptr) {
+      auto next = head->_next;
+      head->_armed = false;
+      head->_prev = nullptr;
+      head->_next = cleared;
+      cleared = head;
+      head = next;
+    }
+  };
+  std::ranges::for_each(this->_root, take);
+  for (auto &level : this->_levels) {
+    std::ranges::for_each(level, take);
+  }
+  this->_root_bits.fill(0);
+  this->_level_bits.fill(0);
+  this->_count = 0;
+  return cleared;
+}
+
+int TimerWheel::timeout(clock_type::time_point now, int max) const noexcept {
+  if (this->_count == 0) {
+    return max;
+  }
+  auto idx = static_cast<std::size_t>(this->_current & (ROOT_SIZE - 1));
+  uint64_t next = this->_current
+                  + impl_timer::distance(this->_root_bits.data(), this->_root_bits.size(), idx);
+  for (std::size_t level = 1; level < LEVELS; ++level) {
+    if (this->_level_bits[level - 1] == 0) {
+      continue;
+    }
+    auto shift = impl_timer::shift_of(level);
+    auto cur = static_cast<std::size_t>((this->_current >> shift) & (LEVEL_SIZE - 1));
+    auto d = impl_timer::distance(&this->_level_bits[level - 1], 1, cur);
+    // the current slot has been cascaded unless the current tick is just on its boundary
+    if (d == 0 && (this->_current & ((uint64_t{1} << shift) - 1)) != 0) {
+      d = LEVEL_SIZE;
+    }
+    // the timers of the slot expire no earlier than the slot is cascaded
+    next = std::min(next, ((this->_current >> shift) + d) << shift);
+  }
+  auto wait = std::chrono::ceil<std::chrono::milliseconds>(
+                  this->_epoch + std::chrono::milliseconds(next) - now)
+                  .count();
+  wait = std::max<decltype(wait)>(wait, 0);
+  if (max >= 0 && wait > max) {
+    return max;
+  }
+  return static_cast<int>(std::min<decltype(wait)>(wait, INT_MAX));
+}
+
+Timer *&TimerWheel::slot(uint8_t level, uint8_t slot) noexcept {
+  return level == 0 ? this->_root[slot] : this->_levels[level - 1][slot];
+}
+
+void TimerWheel::link(Timer *timer) {
+  auto expiry = std::max(timer->_expiry, this->_current);
+  auto delta = expiry - this->_current;
+  if (delta > MAX_TICKS) {
+    delta = MAX_TICKS;
+    expiry = this->_current + MAX_TICKS;
+  }
+  timer->_expiry = expiry;
+  if (delta < ROOT_SIZE) {
+    timer->_level = 0;
+    timer->_slot = static_cast<uint8_t>(expiry & (ROOT_SIZE - 1));
+    this->_root_bits[timer->_slot / 64] |= uint64_t{1} << (timer->_slot % 64);
+  } else {
+    std::size_t level = 1;
+    while (delta >> (impl_timer::shift_of(level) + LEVEL_BITS) != 0) {
+      ++level;
+    }
+    timer->_level = static_cast<uint8_t>(level);
+    timer->_slot
+        = static_cast<uint8_t>((expiry >> impl_timer::shift_of(level)) & (LEVEL_SIZE - 1));
+    this->_level_bits[level - 1] |= uint64_t{1} << timer->_slot;
+  }
+  auto &head = this->slot(timer->_level, timer->_slot);
+  timer->_prev = nullptr;
+  timer->_next = head;
+  if (head != nullptr) {
+    head->_prev = timer;
+  }
+  head = timer;
+}
+
+void TimerWheel::unlink(Timer *timer) noexcept {
+  auto &head = this->slot(timer->_level, timer->_slot);
+  if (timer->_prev != nullptr) {
+    timer->_prev->_next = timer->_next;
+  } else {
+    head = timer->_next;
+  }
+  if (timer->_next != nullptr) {
+    timer->_next->_prev = timer->_prev;
+  }
+  timer->_prev = timer->_next = nullptr;
+  if (head == nullptr) {
+    if (timer->_level == 0) {
+      this->_root_bits[timer->_slot / 64] &= ~(uint64_t{1} << (timer->_slot % 64));
+    } else {
+      this->_level_bits[timer->_level - 1] &= ~(uint64_t{1} << timer->_slot);
+    }
+  }
+}
+
+void TimerWheel::cascade(uint8_t level, uint8_t slot) {
+  auto head = std::exchange(this->slot(level, slot), nullptr);
+  this->_level_bits[level - 1] &= ~(uint64_t{1} << slot);
+  while (head != nullptr) {
+    auto next = head->_next;
+    this->link(head);
+    head = next;
+  }
+}
+XSL_SYNC_NE
@@ -0,0 +1,232 @@
+#include "xsl/logctl.h"
+#include "xsl/sync/def.h"
+#include "xsl/sync/uring.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <utility>
+XSL_SYNC_NB
+namespace impl_uring {
+  static int setup(unsigned entries, io_uring_params *p) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+  }
+  static int enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags,
+                   const void *arg, std::size_t argsz) {
+    return static_cast<int>(
+        syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz));
+  }
+  static int register_(int fd, unsigned opcode, const void *arg, unsigned nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+  }
+  template <class T>
+  static T *offset(void *base, uint32_t off) {
+    return reinterpret_cast<T *>(static_cast<std::byte *>(base) + off);
+  }
+}  // namespace impl_uring
+
+IoUring::IoUring(unsigned entries)
+    : _fd(-1),
+      _features(0),
+      _sq_ptr(MAP_FAILED),
+      _sq_size(0),
+      _cq_ptr(MAP_FAILED),
+      _cq_size(0),
+      _sqes(static_cast<io_uring_sqe *>(MAP_FAILED)),
+      _sqes_size(0),
+      _sq_head(nullptr),
+      _sq_tail(nullptr),
+      _sq_array(nullptr),
+      _sq_mask(0),
+      _sq_entries(0),
+      _sqe_head(0),
+      _sqe_tail(0),
+      _cq_head(nullptr),
+      _cq_tail(nullptr),
+      _cqes(nullptr),
+      _cq_mask(0) {
+  io_uring_params p{};
+  int fd = impl_uring::setup(entries, &p);
+  if (fd < 0) {
+    WARN("Failed to setup io_uring, {}:{}", errno, strerror(errno));
+    return;
+  }
+  // single mmap and extended arguments are required, both exist since 5.11
+  if (!(p.features & IORING_FEAT_SINGLE_MMAP) || !(p.features & IORING_FEAT_EXT_ARG)) {
+    WARN("io_uring features {:#x} are not enough", p.features);
+    close(fd);
+    return;
+  }
+  this->_sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  this->_cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+  this->_sq_size = this->_cq_size = std::max(this->_sq_size, this->_cq_size);
+  this->_sq_ptr = mmap(nullptr, this->_sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       fd, IORING_OFF_SQ_RING);
+  if (this->_sq_ptr == MAP_FAILED) {
+    WARN("Failed to mmap io_uring rings, {}:{}", errno, strerror(errno));
+    close(fd);
+    return;
+  }
+  this->_cq_ptr = this->_sq_ptr;
+  this->_sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+  this->_sqes = static_cast<io_uring_sqe *>(mmap(nullptr, this->_sqes_size,
+                                                 PROT_READ | PROT_WRITE,
+                                                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+  if (this->_sqes == MAP_FAILED) {
+    WARN("Failed to mmap io_uring sqes, {}:{}", errno, strerror(errno));
+    munmap(this->_sq_ptr, this->_sq_size);
+    this->_sq_ptr = this->_cq_ptr = MAP_FAILED;
+    close(fd);
+    return;
+  }
+  this->_sq_head = impl_uring::offset<unsigned>(this->_sq_ptr, p.sq_off.head);
+  this->_sq_tail = impl_uring::offset<unsigned>(this->_sq_ptr, p.sq_off.tail);
+  this->_sq_array = impl_uring::offset<unsigned>(this->_sq_ptr, p.sq_off.array);
+  this->_sq_mask = *impl_uring::offset<unsigned>(this->_sq_ptr, p.sq_off.ring_mask);
+  this->_sq_entries = p.sq_entries;
+  this->_cq_head = impl_uring::offset<unsigned>(this->_cq_ptr, p.cq_off.head);
+  this->_cq_tail = impl_uring::offset<unsigned>(this->_cq_ptr, p.cq_off.tail);
+  this->_cqes = impl_uring::offset<io_uring_cqe>(this->_cq_ptr, p.cq_off.cqes);
+  this->_cq_mask = *impl_uring::offset<unsigned>(this->_cq_ptr, p.cq_off.ring_mask);
+  this->_features = p.features;
+  this->_fd = fd;
+  LOG5("io_uring fd: {}, sq entries: {}, cq entries: {}", fd, p.sq_entries, p.cq_entries);
+}
+
+IoUring::~IoUring() {
+  if (this->_sqes != MAP_FAILED) {
+    munmap(this->_sqes, this->_sqes_size);
+  }
+  if (this->_sq_ptr != MAP_FAILED) {
+    munmap(this->_sq_ptr, this->_sq_size);
+  }
+  if (this->_fd != -1) {
+    close(this->_fd);
+  }
+}
+
+io_uring_sqe *IoUring::get_sqe() noexcept {
+  auto head = std::atomic_ref(*this->_sq_head).load(std::memory_order_acquire);
+  if (this->_sqe_tail - head >= this->_sq_entries) {
+    return nullptr;
+  }
+  auto sqe = &this->_sqes[this->_sqe_tail++ & this->_sq_mask];
+  std::memset(sqe, 0, sizeof(io_uring_sqe));
+  return sqe;
+}
+
+unsigned IoUring::flush() noexcept {
+  auto tail = std::atomic_ref(*this->_sq_tail).load(std::memory_order_relaxed);
+  while (this->_sqe_head != this->_sqe_tail) {
+    this->_sq_array[tail++ & this->_sq_mask] = this->_sqe_head++ & this->_sq_mask;
+  }
+  std::atomic_ref(*this->_sq_tail).store(tail, std::memory_order_release);
+  return tail - std::atomic_ref(*this->_sq_head).load(std::memory_order_acquire);
+}
+
+int IoUring::enter(unsigned to_submit, unsigned wait_nr, int timeout_ms,
+                   const sigset_t *mask) noexcept {
+  if (to_submit == 0 && wait_nr == 0) {
+    return 0;
+  }
+  unsigned flags = 0;
+  __kernel_timespec ts{};
+  io_uring_getevents_arg arg{};
+  if (wait_nr > 0) {
+    flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    if (mask != nullptr) {
+      arg.sigmask = reinterpret_cast<uint64_t>(mask);
+      arg.sigmask_sz = _NSIG / 8;
+    }
+    if (timeout_ms >= 0) {
+      ts.tv_sec = timeout_ms / 1000;
+      ts.tv_nsec = (timeout_ms % 1000) * 1000000;
+      arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+  }
+  int res = impl_uring::enter(this->_fd, to_submit, wait_nr, flags,
+                              (flags & IORING_ENTER_EXT_ARG) ? &arg : nullptr,
+                              (flags & IORING_ENTER_EXT_ARG) ? sizeof(arg) : 0);
+  return res < 0 ? -errno : res;
+}
+
+int IoUring::register_buf_ring(io_uring_buf_ring *ring, unsigned entries, uint16_t bgid) noexcept {
+  io_uring_buf_reg reg{};
+  reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+  reg.ring_entries = entries;
+  reg.bgid = bgid;
+  int res = impl_uring::register_(this->_fd, IORING_REGISTER_PBUF_RING, &reg, 1);
+  return res < 0 ? -errno : res;
+}
+
+int IoUring::unregister_buf_ring(uint16_t bgid) noexcept {
+  io_uring_buf_reg reg{};
+  reg.bgid = bgid;
+  int res = impl_uring::register_(this->_fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+  return res < 0 ? -errno : res;
+}
+
+BufferRing::BufferRing(std::shared_ptr<IoUring> ring, uint16_t bgid, uint16_t count,
+                       uint32_t size)
+    : _ring(std::move(ring)),
+      _br(nullptr),
+      _bufs(nullptr),
+      _bgid(bgid),
+      _count(count),
+      _size(size),
+      _tail(0),
+      _mtx() {
+  if (count == 0 || (count & (count - 1)) != 0) {
+    WARN("Buffer ring size {} is not power of 2", count);
+    return;
+  }
+  std::size_t ring_size = count * sizeof(io_uring_buf) + static_cast<std::size_t>(count) * size;
+  void *ptr
+      = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ptr == MAP_FAILED) {
+    WARN("Failed to mmap buffer ring, {}:{}", errno, strerror(errno));
+    return;
+  }
+  auto br = static_cast<io_uring_buf_ring *>(ptr);
+  if (int res = this->_ring->register_buf_ring(br, count, bgid); res < 0) {
+    WARN("Failed to register buffer ring {}, {}", bgid, strerror(-res));
+    munmap(ptr, ring_size);
+    return;
+  }
+  this->_br = br;
+  this->_bufs = static_cast<std::byte *>(ptr) + count * sizeof(io_uring_buf);
+  for (uint16_t bid = 0; bid < count; ++bid) {
+    this->push(bid);
+  }
+  std::atomic_ref(this->_br->tail).store(this->_tail, std::memory_order_release);
+}
+
+BufferRing::~BufferRing() {
+  if (this->_br == nullptr) {
+    return;
+  }
+  this->_ring->unregister_buf_ring(this->_bgid);
+  munmap(this->_br, this->_count * sizeof(io_uring_buf)
+                        + static_cast<std::size_t>(this->_count) * this->_size);
+}
+
+void BufferRing::push(uint16_t bid) noexcept {
+  auto &buf = this->_br->bufs[this->_tail & (this->_count - 1)];
+  buf.addr = reinterpret_cast<uint64_t>(this->_bufs + static_cast<std::size_t>(bid) * this->_size);
+  buf.len = this->_size;
+  buf.bid = bid;
+  ++this->_tail;
+}
+
+void BufferRing::recycle(uint16_t bid) noexcept {
+  std::lock_guard guard(this->_mtx);
+  this->push(bid);
+  std::atomic_ref(this->_br->tail).store(this->_tail, std::memory_order_release);
+}
+XSL_SYNC_NE
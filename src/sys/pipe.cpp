@@ -5,6 +5,10 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+#include <cstring>
+#include <expected>
+#include <mutex>
+#include <system_error>
 #include <utility>
 XSL_SYS_NB
 std::pair<io::Device<feature::In<std::byte>>, io::Device<feature::Out<std::byte>>> pipe() {
@@ -34,4 +38,56 @@ async_pipe(std::shared_ptr<sync::Poller>& poller) {
           io::AsyncDevice<feature::Out<std::byte>>(write_sem, fds[1])};
 }
 
+PipePool::PipePool(std::size_t capacity, std::size_t max_idle)
+    : _capacity(capacity), _max_idle(max_idle), _mutex(), _idle() {}
+
+PipePool::~PipePool() {}
+
+std::expected<Pipe, std::errc> PipePool::acquire() {
+  {
+    std::lock_guard lock(this->_mutex);
+    if (!this->_idle.empty()) {
+      auto pipe = std::move(this->_idle.back());
+      this->_idle.pop_back();
+      return pipe;
+    }
+  }
+  int fds[2];
+  if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) == -1) {
+    auto err = std::errc(errno);
+    LOG2("Failed to create pipe, err: {}", strerror(errno));
+    return std::unexpected{err};
+  }
+  int size = fcntl(fds[1], F_SETPIPE_SZ, static_cast<int>(this->_capacity));
+  if (size == -1) {
+    // over /proc/sys/fs/pipe-max-size, keep the default capacity
+    LOG4("Failed to set pipe size to {}, err: {}", this->_capacity, strerror(errno));
+    size = fcntl(fds[1], F_GETPIPE_SZ);
+    if (size == -1) {
+      // saved before the log and the close may overwrite it
+      auto err = std::errc(errno);
+      LOG2("Failed to get pipe size, err: {}", strerror(errno));
+      close(fds[0]);
+      close(fds[1]);
+      return std::unexpected{err};
+    }
+  }
+  return Pipe{fds[0], fds[1], static_cast<std::size_t>(size)};
+}
+
+void PipePool::release(Pipe&& pipe, bool empty) {
+  if (!empty) {
+    return;
+  }
+  std::lock_guard lock(this->_mutex);
+  if (this->_idle.size() < this->_max_idle) {
+    this->_idle.push_back(std::move(pipe));
+  }
+}
+
+PipePool& PipePool::local() {
+  thread_local PipePool pool{};
+  return pool;
+}
+
 XSL_SYS_NE
@@ -0,0 +1,139 @@
+#include "xsl/coro.h"
+#include "xsl/logctl.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <iterator>
+#include <latch>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+using namespace xsl::coro;
+
+Lazy<void> produce(Channel<int, 2> &chan, int count) {
+  for (int i = 0; i < count; ++i) {
+    co_await chan.send(i);
+  }
+  chan.close();
+}
+
+Lazy<std::vector<int>> consume_all(Channel<int, 2> &chan) {
+  std::vector<int> values;
+  while (auto value = co_await chan.recv()) {
+    values.push_back(*value);
+  }
+  co_return values;
+}
+
+TEST(ChannelTest, Backpressure) {
+  Channel<int, 2> chan;
+  // the producer suspends once the buffer is full
+  produce(chan, 10).detach();
+  ASSERT_EQ(chan.size(), 2);
+  ASSERT_FALSE(chan.closed());
+  auto values = consume_all(chan).block();
+  ASSERT_EQ(values.size(), 10);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(values[i], i);
+  }
+}
+
+TEST(ChannelTest, Close) {
+  Channel<std::unique_ptr<int>, 4> chan;
+  ASSERT_EQ(chan.try_send(std::make_unique<int>(1)), std::nullopt);
+  chan.close();
+  auto rejected = chan.try_send(std::make_unique<int>(2));
+  ASSERT_TRUE(rejected.has_value());
+  ASSERT_EQ(**rejected, 2);
+  ASSERT_FALSE([](Channel<std::unique_ptr<int>, 4> &chan) -> Lazy<bool> {
+    co_return co_await chan.send(std::make_unique<int>(3));
+  }(chan)
+                   .block());
+  // the buffered value is drained after close
+  auto value = chan.try_recv();
+  ASSERT_TRUE(value.has_value());
+  ASSERT_EQ(**value, 1);
+  ASSERT_EQ([](Channel<std::unique_ptr<int>, 4> &chan) -> Lazy<bool> {
+    co_return(co_await chan.recv()).has_value();
+  }(chan)
+                .block(),
+            false);
+}
+
+Lazy<std::size_t> recv_many(Channel<int, 8> &chan, std::vector<int> &out, std::size_t max) {
+  co_return co_await chan.recv_many(std::back_inserter(out), max);
+}
+
+TEST(ChannelTest, RecvMany) {
+  Channel<int, 8> chan;
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(chan.try_send(int{i}), std::nullopt);
+  }
+  std::vector<int> values;
+  ASSERT_EQ(recv_many(chan, values, 3).block(), 3);
+  ASSERT_EQ(recv_many(chan, values, 8).block(), 2);
+  ASSERT_EQ(values, (std::vector<int>{0, 1, 2, 3, 4}));
+  // waits for the next value
+  values.clear();
+  auto task = recv_many(chan, values, 8);
+  std::size_t count = 0;
+  [](Lazy<std::size_t> task, std::size_t &count) -> Lazy<void> {
+    count = co_await std::move(task);
+  }(std::move(task), count)
+                                                      .detach();
+  ASSERT_EQ(count, 0);
+  ASSERT_EQ(chan.try_send(7), std::nullopt);
+  ASSERT_EQ(count, 1);
+  ASSERT_EQ(values, (std::vector<int>{7}));
+  chan.close();
+  ASSERT_EQ(recv_many(chan, values, 8).block(), 0);
+}
+
+Lazy<void> send_range(Channel<int, 16> &chan, int from, int to, std::latch &done) {
+  for (int i = from; i < to; ++i) {
+    co_await chan.send(i);
+  }
+  done.count_down();
+}
+
+Lazy<void> sum_all(Channel<int, 16> &chan, std::atomic_int64_t &sum, std::latch &done) {
+  int buffer[4];
+  while (auto n = co_await chan.recv_many(buffer, 4)) {
+    for (std::size_t i = 0; i < n; ++i) {
+      sum += buffer[i];
+    }
+  }
+  done.count_down();
+}
+
+TEST(ChannelTest, Executors) {
+  const int producers = 4, consumers = 4, count = 2000;
+  auto executor = std::make_shared<WorkStealingExecutor>(4);
+  Channel<int, 16> chan;
+  std::atomic_int64_t sum = 0;
+  std::latch sent(producers), received(consumers);
+  for (int i = 0; i < consumers; ++i) {
+    sum_all(chan, sum, received).detach(executor);
+  }
+  for (int i = 0; i < producers; ++i) {
+    send_range(chan, i * count, (i + 1) * count, sent).detach(executor);
+  }
+  sent.wait();
+  chan.close();
+  received.wait();
+  // the detached coroutines hold the executor until their frames are destroyed, it must not be
+  // destroyed by its own workers
+  while (executor.use_count() > 1) {
+    std::this_thread::yield();
+  }
+  int64_t total = producers * count;
+  ASSERT_EQ(sum, total * (total - 1) / 2);
+}
+
+int main(int argc, char **argv) {
+  xsl::no_log();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
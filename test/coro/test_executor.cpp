@@ -1,6 +1,12 @@
 #include "xsl/coro.h"
 
 #include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <semaphore>
+#include <thread>
+#include <vector>
 using namespace xsl::coro;
 
 TEST(ExecutorTest, NoopExecutor) {
@@ -10,6 +16,60 @@ TEST(ExecutorTest, NoopExecutor) {
   ASSERT_EQ(value, 1);
 }
 
+TEST(ExecutorTest, WorkStealingExecutor) {
+  std::atomic_int value = 0;
+  {
+    WorkStealingExecutor executor(4);
+    ASSERT_EQ(executor.size(), 4);
+    std::vector<std::thread> producers;
+    for (int i = 0; i < 4; ++i) {
+      producers.emplace_back([&executor, &value] {
+        for (int j = 0; j < 1000; ++j) {
+          executor.schedule([&value] { ++value; });
+        }
+      });
+    }
+    for (auto &producer : producers) {
+      producer.join();
+    }
+  }
+  // the queued functions are run before the executor is destroyed
+  ASSERT_EQ(value, 4000);
+}
+
+void spawn(WorkStealingExecutor &executor, std::atomic_int &value, int depth) {
+  ++value;
+  if (depth == 0) {
+    return;
+  }
+  for (int i = 0; i < 2; ++i) {
+    executor.schedule([&executor, &value, depth] { spawn(executor, value, depth - 1); });
+  }
+}
+
+TEST(ExecutorTest, WorkStealingExecutorNested) {
+  std::atomic_int value = 0;
+  {
+    WorkStealingExecutor executor(4);
+    executor.schedule([&executor, &value] { spawn(executor, value, 12); });
+  }
+  ASSERT_EQ(value, (1 << 13) - 1);
+}
+
+TEST(ExecutorTest, WorkStealingExecutorLazy) {
+  auto executor = std::make_shared<WorkStealingExecutor>(2);
+  std::binary_semaphore sem(0);
+  int value = 0;
+  [](int &value, std::binary_semaphore &sem) -> Lazy<void> {
+    value = 1;
+    sem.release();
+    co_return;
+  }(value, sem)
+                                                    .detach(executor);
+  sem.acquire();
+  ASSERT_EQ(value, 1);
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
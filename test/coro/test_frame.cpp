@@ -0,0 +1,119 @@
+#include "xsl/coro.h"
+#include "xsl/logctl.h"
+
+#include <gtest/gtest.h>
+
+#include <coroutine>
+#include <cstddef>
+#include <memory>
+#include <utility>
+using namespace xsl::coro;
+/**
+ * @brief the address of the frame of the awaiting coroutine, without suspending it
+ *
+ */
+class FrameAddress {
+public:
+  using executor_type = void;
+
+  bool await_ready() const noexcept { return false; }
+
+  bool await_suspend(std::coroutine_handle<> handle) noexcept {
+    this->_address = handle.address();
+    return false;
+  }
+
+  void *await_resume() const noexcept { return this->_address; }
+
+private:
+  void *_address = nullptr;
+};
+/// @brief the arena recorded in the header of the frame, nullptr for the cache of the thread
+static FrameArena *owner(void *frame) {
+  return *reinterpret_cast<FrameArena **>(static_cast<std::byte *>(frame)
+                                          - xsl::_coro::impl_frame::HEADER_SIZE);
+}
+
+using Frame = std::pair<void *, FrameArena *>;
+
+Task<Frame> frame() {
+  auto address = co_await FrameAddress{};
+  co_return Frame{address, owner(address)};
+}
+
+Task<Frame> frame(std::allocator_arg_t, FrameArena &) {
+  auto address = co_await FrameAddress{};
+  co_return Frame{address, owner(address)};
+}
+/// @brief run two tasks one after another, nothing is allocated between them
+template <class... Args>
+Lazy<std::pair<Frame, Frame>> sequential(Args &...args) {
+  auto first = co_await frame(args...);
+  auto second = co_await frame(args...);
+  co_return std::pair{first, second};
+}
+
+Task<int> add_one(std::allocator_arg_t, FrameArena &, int value) { co_return value + 1; }
+
+Lazy<int> add_two(std::allocator_arg_t, FrameArena &arena, int value) {
+  auto first = co_await add_one(std::allocator_arg, arena, value);
+  co_return co_await add_one(std::allocator_arg, arena, first);
+}
+
+class Counter {
+public:
+  Task<int> next(std::allocator_arg_t, FrameArena &) {
+    ++this->_value;
+    co_return int{this->_value};
+  }
+
+private:
+  int _value = 0;
+};
+
+TEST(Frame, thread_cache) {
+  auto task = []() -> Task<int> { co_return 1; };
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(task().block(), 1);
+  }
+}
+
+TEST(Frame, thread_cache_reuse) {
+  auto [first, second] = sequential().block();
+  ASSERT_EQ(first.second, nullptr);
+  // the freed frame is cached by the thread and handed to the next task
+  ASSERT_EQ(first.first, second.first);
+}
+
+TEST(Frame, arena_reuse) {
+  FrameArena arena;
+  std::allocator_arg_t tag = std::allocator_arg;
+  auto [first, second] = sequential(tag, arena).block();
+  ASSERT_EQ(first.second, &arena);
+  ASSERT_EQ(first.first, second.first);
+  // the frame is kept by the arena, not by the cache of the thread
+  auto [cached, _] = sequential().block();
+  ASSERT_NE(cached.first, first.first);
+  ASSERT_EQ(cached.second, nullptr);
+}
+
+TEST(Frame, arena) {
+  FrameArena arena;
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(add_one(std::allocator_arg, arena, i).block(), i + 1);
+    ASSERT_EQ(add_two(std::allocator_arg, arena, i).block(), i + 2);
+  }
+}
+
+TEST(Frame, member_arena) {
+  FrameArena arena;
+  Counter counter;
+  ASSERT_EQ(counter.next(std::allocator_arg, arena).block(), 1);
+  ASSERT_EQ(counter.next(std::allocator_arg, arena).block(), 2);
+}
+
+int main(int argc, char **argv) {
+  xsl::no_log();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -72,6 +72,23 @@ TEST(Lazy, async_exception_task) {
   ASSERT_THROW(task4.block(), std::runtime_error);
 }
 
+Lazy<int> depth(int n) {
+  if (n == 0) {
+    co_return 0;
+  }
+  co_return co_await depth(n - 1) + 1;
+}
+
+TEST(Lazy, deep_chain) {
+  // every level completes synchronously and hands off to its parent by symmetric transfer
+  ASSERT_EQ(depth(10000).block(), 10000);
+}
+
+TEST(Lazy, deep_chain_with_executor) {
+  auto executor = std::make_shared<NoopExecutor>();
+  ASSERT_EQ(depth(10000).by(executor).block(), 10000);
+}
+
 int main(int argc, char **argv) {
   xsl::no_log();
   testing::InitGoogleTest(&argc, argv);
@@ -2,8 +2,15 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <latch>
+#include <memory>
+#include <optional>
+#include <stop_token>
 #include <thread>
+#include <vector>
 using namespace xsl::coro;
 
 TEST(SemaphoreTest, Basic) {
@@ -47,6 +54,141 @@ TEST(SemaphoreTest, State) {
   ASSERT_EQ(res, 1);
 };
 
+TEST(SemaphoreTest, Ready) {
+  CountingSemaphore<1> sem{true};
+  auto task = [&]() -> Task<bool> { co_return co_await sem; };
+  ASSERT_TRUE(task().block());
+  sem.release(false);
+  sem.release(true);
+  // the last value wins
+  ASSERT_TRUE(task().block());
+}
+
+TEST(SemaphoreTest, PingPong) {
+  CountingSemaphore<1> ping{}, pong{};
+  const int rounds = 10000;
+  int count = 0;
+  std::thread t1([&] {
+    [&]() -> Task<void> {
+      for (int i = 0; i < rounds; ++i) {
+        if (co_await ping) {
+          ++count;
+        }
+        pong.release();
+      }
+    }()
+                 .block();
+  });
+  for (int i = 0; i < rounds; ++i) {
+    ping.release();
+    [&]() -> Task<void> {
+      auto res = co_await pong;
+      assert(res);
+      (void)res;
+    }()
+                 .block();
+  }
+  t1.join();
+  ASSERT_EQ(count, rounds);
+}
+
+Lazy<void> wait_stoppable(CountingSemaphore<1> &sem, std::stop_token token,
+                          std::optional<bool> &res) {
+  StopGuard guard{sem, token};
+  res = co_await sem;
+}
+
+Task<bool> wait(CountingSemaphore<1> &sem) { co_return co_await sem; }
+
+TEST(SemaphoreTest, Cancel) {
+  CountingSemaphore<1> sem{};
+  std::stop_source source;
+  std::optional<bool> res;
+  wait_stoppable(sem, source.get_token(), res).detach();
+  ASSERT_FALSE(res.has_value());
+  source.request_stop();
+  ASSERT_EQ(res, false);
+  // the cancellation is cleared with the guard, the next wait suspends
+  res.reset();
+  wait_stoppable(sem, std::stop_source{}.get_token(), res).detach();
+  ASSERT_FALSE(res.has_value());
+  sem.release(true);
+  ASSERT_EQ(res, true);
+  // a pending value is kept
+  sem.release(true);
+  sem.cancel();
+  ASSERT_TRUE(wait(sem).block());
+  // a cancellation without waiter fails the next wait
+  sem.cancel();
+  ASSERT_FALSE(wait(sem).block());
+  sem.cancel();
+  sem.clear_cancel();
+  sem.release(true);
+  ASSERT_TRUE(wait(sem).block());
+}
+
+TEST(SemaphoreTest, Callback) {
+  CountingSemaphore<1> sem{};
+  auto awaiter = sem.operator co_await();
+  int called = 0;
+  auto callback = [](void *context) { ++*static_cast<int *>(context); };
+  // the waiter is the callback with its context, no coroutine is involved
+  ASSERT_TRUE(awaiter.wait(&called, callback));
+  ASSERT_EQ(called, 0);
+  sem.release(true);
+  ASSERT_EQ(called, 1);
+  ASSERT_TRUE(awaiter.await_resume());
+  // the value is ready, so the callback is not registered
+  sem.release(false);
+  ASSERT_FALSE(awaiter.wait(&called, callback));
+  ASSERT_FALSE(awaiter.await_resume());
+  ASSERT_TRUE(awaiter.wait(&called, callback));
+  sem.cancel();
+  ASSERT_EQ(called, 2);
+  ASSERT_FALSE(awaiter.await_resume());
+}
+
+Lazy<void> consume(CountingSemaphore<> &sem, std::atomic_int &acquired, std::latch &done,
+                   int times) {
+  for (int i = 0; i < times; ++i) {
+    co_await sem;
+    ++acquired;
+  }
+  done.count_down();
+}
+
+TEST(SemaphoreTest, Counting) {
+  const int consumers = 8, producers = 4, times = 1000;
+  CountingSemaphore<> sem{0};
+  auto executor = std::make_shared<WorkStealingExecutor>(4);
+  std::atomic_int acquired = 0;
+  std::latch done(consumers);
+  for (int i = 0; i < consumers; ++i) {
+    consume(sem, acquired, done, times).detach(executor);
+  }
+  std::vector<std::thread> threads;
+  for (int i = 0; i < producers; ++i) {
+    threads.emplace_back([&sem] {
+      for (int left = consumers * times / producers; left > 0;) {
+        auto update = std::min(left, left % 3 + 1);
+        sem.release(update);
+        left -= update;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  done.wait();
+  // the detached coroutines hold the executor until their frames are destroyed, it must not be
+  // destroyed by its own workers
+  while (executor.use_count() > 1) {
+    std::this_thread::yield();
+  }
+  ASSERT_EQ(acquired, consumers * times);
+  ASSERT_FALSE(sem.try_acquire());
+}
+
 int main(int argc, char **argv) {
   xsl::no_log();
   testing::InitGoogleTest(&argc, argv);
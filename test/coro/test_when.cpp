@@ -0,0 +1,166 @@
+#include "xsl/coro.h"
+#include "xsl/logctl.h"
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <tuple>
+#include <variant>
+#include <vector>
+using namespace xsl::coro;
+
+Lazy<int> value_of(int value) { co_return value; }
+
+Lazy<void> nothing() { co_return; }
+
+Lazy<int> wait_for(CountingSemaphore<1> &sem, int value) {
+  co_await sem;
+  co_return value;
+}
+
+Lazy<int> fail() {
+  throw std::runtime_error("fail");
+  co_return 0;
+}
+
+TEST(WhenTest, All) {
+  auto [a, b, c] = when_all(value_of(1), nothing(), value_of(3)).block();
+  ASSERT_EQ(a, 1);
+  ASSERT_EQ(b, std::monostate{});
+  ASSERT_EQ(c, 3);
+}
+
+TEST(WhenTest, AllRange) {
+  std::vector<Lazy<int>> tasks;
+  for (int i = 0; i < 100; ++i) {
+    tasks.push_back(value_of(i));
+  }
+  auto values = when_all(std::move(tasks)).block();
+  ASSERT_EQ(values.size(), 100);
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(values[i], i);
+  }
+  ASSERT_TRUE(when_all(std::vector<Lazy<int>>{}).block().empty());
+}
+
+Lazy<std::tuple<int, int>> all_suspended(CountingSemaphore<1> &first,
+                                         CountingSemaphore<1> &second) {
+  co_return co_await when_all(wait_for(first, 1), wait_for(second, 2));
+}
+
+TEST(WhenTest, AllConcurrent) {
+  CountingSemaphore<1> first, second;
+  std::tuple<int, int> result{};
+  bool done = false;
+  [](CountingSemaphore<1> &first, CountingSemaphore<1> &second, std::tuple<int, int> &result,
+     bool &done) -> Lazy<void> {
+    result = co_await all_suspended(first, second);
+    done = true;
+  }(first, second, result, done)
+                      .detach();
+  // both are started before either finishes
+  second.release();
+  ASSERT_FALSE(done);
+  first.release();
+  ASSERT_TRUE(done);
+  ASSERT_EQ(result, std::make_tuple(1, 2));
+}
+
+TEST(WhenTest, AllException) {
+  ASSERT_THROW(when_all(value_of(1), fail()).block(), std::runtime_error);
+}
+
+TEST(WhenTest, Any) {
+  CountingSemaphore<1> never;
+  auto result = when_any(wait_for(never, 1), value_of(2)).block();
+  ASSERT_EQ(result.index(), 1);
+  ASSERT_EQ(std::get<1>(result), 2);
+  // the loser is still waiting, let it finish
+  never.release();
+}
+
+TEST(WhenTest, AnyRange) {
+  CountingSemaphore<1> sems[3];
+  std::vector<Lazy<int>> tasks;
+  for (int i = 0; i < 3; ++i) {
+    tasks.push_back(wait_for(sems[i], i * 10));
+  }
+  std::pair<std::size_t, int> result{};
+  [](std::vector<Lazy<int>> tasks, std::pair<std::size_t, int> &result) -> Lazy<void> {
+    result = co_await when_any(std::move(tasks));
+  }(std::move(tasks), result)
+                                                                              .detach();
+  sems[2].release();
+  sems[0].release();
+  sems[1].release();
+  ASSERT_EQ(result, std::make_pair(std::size_t{2}, 20));
+}
+
+TEST(WhenTest, AnyEmptyRange) {
+  ASSERT_THROW(when_any(std::vector<Lazy<int>>{}).block(), std::invalid_argument);
+}
+
+Lazy<bool> wait_stoppable(CountingSemaphore<1> &sem, std::stop_token token, bool &stopped) {
+  StopGuard guard{sem, token};
+  auto ready = co_await sem;
+  stopped = token.stop_requested();
+  co_return ready;
+}
+
+TEST(WhenTest, AnyStop) {
+  CountingSemaphore<1> never;
+  bool stopped = false;
+  auto loser = [&](std::stop_token token) { return wait_stoppable(never, token, stopped); };
+  auto result = when_any(loser, value_of(2)).block();
+  ASSERT_EQ(result.index(), 1);
+  // the loser is cancelled by the winner, not left waiting
+  ASSERT_TRUE(stopped);
+}
+
+TEST(WhenTest, AnyStopRange) {
+  CountingSemaphore<1> sems[3];
+  bool stopped[3] = {false, false, false};
+  std::vector<std::function<Lazy<bool>(std::stop_token)>> children;
+  for (int i = 0; i < 3; ++i) {
+    children.emplace_back([&, i](std::stop_token token) {
+      return wait_stoppable(sems[i], std::move(token), stopped[i]);
+    });
+  }
+  std::pair<std::size_t, bool> result{};
+  [](auto children, std::pair<std::size_t, bool> &result) -> Lazy<void> {
+    result = co_await when_any(std::move(children));
+  }(std::move(children), result)
+                                  .detach();
+  sems[1].release();
+  ASSERT_EQ(result, std::make_pair(std::size_t{1}, true));
+  ASSERT_TRUE(stopped[0]);
+  ASSERT_FALSE(stopped[1]);
+  ASSERT_TRUE(stopped[2]);
+}
+
+TEST(WhenTest, AllExecutor) {
+  auto executor = std::make_shared<WorkStealingExecutor>(4);
+  std::vector<Lazy<int>> tasks;
+  for (int i = 0; i < 1000; ++i) {
+    tasks.push_back(value_of(i));
+  }
+  auto values = when_all<WorkStealingExecutor>(std::move(tasks)).by(executor).block();
+  int sum = 0;
+  for (auto value : values) {
+    sum += value;
+  }
+  ASSERT_EQ(sum, 999 * 1000 / 2);
+  while (executor.use_count() > 1) {
+    std::this_thread::yield();
+  }
+}
+
+int main(int argc, char **argv) {
+  xsl::no_log();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,11 +1,22 @@
 #include "xsl/net.h"
+#include "xsl/sync.h"
+#include "xsl/sys/net/block.h"
+#include "xsl/sys/net/dev.h"
 
 #include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <memory>
 #include <stdexcept>
+#include <string>
 #include <system_error>
+#include <thread>
 using namespace std;
 using namespace xsl;
 static string tmp_dir = "";
@@ -41,6 +52,68 @@ TEST(http_component_static, file_route_handler) {
   // ASSERT_TRUE(result.has_value());
 }
 
+using InOutDevice = xsl::sys::net::AsyncDevice<
+    feature::InOut<xsl::sys::net::SocketTraits<feature::Tcp<feature::Ip<4>>>>>;
+using InDevice = xsl::sys::net::AsyncDevice<
+    feature::In<xsl::sys::net::SocketTraits<feature::Tcp<feature::Ip<4>>>>>;
+using OutDevice = xsl::sys::net::AsyncDevice<
+    feature::Out<xsl::sys::net::SocketTraits<feature::Tcp<feature::Ip<4>>>>>;
+
+TEST(http_component_static, empty_file) {
+  using namespace xsl::net;
+  string file_path = tmp_dir + "/empty_file_test.txt";
+  ofstream(file_path).close();
+  int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  ASSERT_NE(listener, -1);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  ASSERT_EQ(::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+  ASSERT_EQ(::listen(listener, 1), 0);
+  ASSERT_EQ(::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+  int client = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  ASSERT_EQ(::connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+  int server = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  ASSERT_NE(server, -1);
+  ::close(listener);
+  auto poller = make_shared<sync::Poller>();
+  auto block = sys::net::BlockRef<sync::PollTraits>::create(
+      server, *poller, sync::IOM_EVENTS::IN | sync::IOM_EVENTS::OUT | sync::IOM_EVENTS::ET);
+  ASSERT_TRUE(block.has_value());
+  thread polling([poller] {
+    while (poller->valid()) {
+      poller->poll();
+    }
+  });
+  {
+    auto [in, out] = InOutDevice{poller.get(), std::move(*block)}.split();
+    // the header is sent with MSG_MORE by default, and no file data follows to push it
+    auto handler = http::create_static_handler<InDevice, OutDevice>(
+        http::StaticFileConfig{file_path});
+    http::HandleContext<InDevice, OutDevice> ctx{
+        "", http::Request<InDevice>{{}, http::RequestView{}, {}, in}};
+    ASSERT_FALSE(handler(ctx).block().has_value());
+    auto start = chrono::steady_clock::now();
+    auto [sz, err] = ctx.sendto(out).block();
+    ASSERT_FALSE(err.has_value());
+    string received;
+    char buf[1024];
+    while (received.find("\r\n\r\n") == string::npos) {
+      auto n = ::recv(client, buf, sizeof(buf), 0);
+      ASSERT_GT(n, 0);
+      received.append(buf, n);
+    }
+    // the cork of MSG_MORE holds the header for 200ms
+    ASSERT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(100));
+    ASSERT_EQ(received.size(), sz);
+    ASSERT_NE(received.find("Content-Length: 0\r\n"), string::npos);
+  }
+  poller->shutdown();
+  polling.join();
+  ::close(client);
+}
+
 int main() {
   init();
   ::testing::InitGoogleTest();
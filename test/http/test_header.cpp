@@ -0,0 +1,66 @@
+#include "xsl/logctl.h"
+#include "xsl/net.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+using namespace xsl::http;
+TEST(header_map, ignore_case) {
+  HeaderMap<std::string_view> headers;
+  ASSERT_TRUE(headers.emplace("content-LENGTH", "42"));
+  ASSERT_TRUE(headers.emplace("X-Request-Id", "abc"));
+  ASSERT_FALSE(headers.emplace(HeaderName::CONTENT_LENGTH, "43"));
+  ASSERT_FALSE(headers.emplace("x-request-id", "def"));
+  ASSERT_EQ(headers.size(), 2);
+  ASSERT_EQ(*headers.find(HeaderName::CONTENT_LENGTH), "42");
+  ASSERT_EQ(*headers.find("Content-Length"), "42");
+  ASSERT_EQ(*headers.find("X-REQUEST-ID"), "abc");
+  ASSERT_EQ(headers.find("X-Request"), nullptr);
+  headers.set("Content-Length", "43");
+  headers.set("x-request-id", "def");
+  ASSERT_EQ(*headers.find(HeaderName::CONTENT_LENGTH), "43");
+  ASSERT_EQ(*headers.find("X-Request-Id"), "def");
+  ASSERT_EQ(headers.size(), 2);
+}
+
+TEST(header_map, overflow) {
+  HeaderMap<std::string> headers;
+  for (int i = 0; i < HTTP_HEADER_NAME_COUNT; ++i) {
+    ASSERT_TRUE(headers.emplace(static_cast<HeaderName>(i), std::to_string(i)));
+  }
+  ASSERT_TRUE(headers.emplace("X-Custom-Header-With-A-Long-Name", "custom"));
+  ASSERT_EQ(headers.size(), HTTP_HEADER_NAME_COUNT + 1);
+  for (int i = 0; i < HTTP_HEADER_NAME_COUNT; ++i) {
+    auto name = static_cast<HeaderName>(i);
+    ASSERT_EQ(*headers.find(name), std::to_string(i));
+    ASSERT_FALSE(headers.emplace(to_string_view(name), "again"));
+  }
+  ASSERT_EQ(*headers.find("x-custom-header-with-a-long-name"), "custom");
+  std::vector<std::string_view> names;
+  headers.for_each([&names](std::string_view name, const std::string&) { names.push_back(name); });
+  ASSERT_EQ(names.size(), headers.size());
+  ASSERT_EQ(names.front(), "Accept");
+  ASSERT_EQ(names.back(), "X-Custom-Header-With-A-Long-Name");
+  headers.clear();
+  ASSERT_TRUE(headers.empty());
+  ASSERT_EQ(headers.find(HeaderName::ACCEPT), nullptr);
+}
+
+TEST(header_map, request) {
+  ParseUnit parser;
+  auto [sz, res] = parser.parse(
+      "GET / HTTP/1.1\r\nhost: localhost\r\nconnection: keep-alive\r\nX-Trace: 1\r\n\r\n");
+  ASSERT_TRUE(res.has_value());
+  auto view = std::move(*res);
+  ASSERT_EQ(*view.headers.find(HeaderName::HOST), "localhost");
+  ASSERT_EQ(*view.headers.find("Connection"), "keep-alive");
+  ASSERT_EQ(*view.headers.find("x-trace"), "1");
+}
+
+int main() {
+  xsl::no_log();
+  testing::InitGoogleTest();
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,46 @@
+#include "xsl/logctl.h"
+#include "xsl/net.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+using namespace xsl::http;
+TEST(response_part, serialize) {
+  ResponsePart part{Status::NOT_FOUND};
+  part.headers.emplace(HeaderName::CONTENT_TYPE, "text/plain");
+  part.headers.emplace("X-Trace", "1");
+  part.content_length = 1234567890123;
+  std::string out = "left";
+  out.clear();
+  part.serialize(out);
+  ASSERT_EQ(out,
+            "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nX-Trace: 1\r\n"
+            "Content-Length: 1234567890123\r\nServer: XSL/0.1\r\n\r\n");
+  ASSERT_EQ(part.to_string(), out);
+}
+
+TEST(response_part, status_line) {
+  ASSERT_EQ(to_status_line(Version::HTTP_1_0, Status::OK), "HTTP/1.0 200 OK\r\n");
+  ASSERT_EQ(to_status_line(Version::HTTP_1_1, Status::HTTP_VERSION_NOT_SUPPORTED),
+            "HTTP/1.1 505 HTTP Version Not Supported\r\n");
+  ASSERT_EQ(to_status_line(Version::HTTP_2_0, Status::OK), "");
+  ASSERT_EQ(to_status_line(Version::HTTP_1_1, static_cast<Status>(299)), "");
+  ASSERT_EQ(to_reason_phrase(Status::UPGRADE_REQUIRED), "Upgrade Required");
+  ASSERT_EQ(to_string_view(Status::CONTINUE), "100");
+  ASSERT_EQ(to_string_view(static_cast<Status>(999)), "UNKNOWN");
+}
+
+TEST(response_part, no_content) {
+  ResponsePart part{Version::HTTP_1_0, Status::NO_CONTENT};
+  part.headers.emplace(HeaderName::SERVER, "test");
+  part.content_length = 0;
+  ASSERT_EQ(part.to_string(), "HTTP/1.0 204 No Content\r\nServer: test\r\n\r\n");
+  ResponsePart custom{Version::HTTP_1_1, Status::OK, "Fine"};
+  ASSERT_EQ(custom.to_string(), "HTTP/1.1 200 Fine\r\nServer: XSL/0.1\r\n\r\n");
+}
+
+int main() {
+  xsl::no_log();
+  testing::InitGoogleTest();
+  return RUN_ALL_TESTS();
+}
@@ -3,7 +3,10 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+#include <string_view>
 #include <system_error>
+#include <vector>
 using namespace xsl::http;
 TEST(http_parse, complete) {
   ParseUnit parser;
@@ -16,7 +19,7 @@ TEST(http_parse, complete) {
   ASSERT_EQ(view.path, "/");
   ASSERT_EQ(xsl::from_string_view<Version>(view.version), Version::HTTP_1_1);
   ASSERT_EQ(view.headers.size(), 1);
-  ASSERT_EQ(view.headers["Host"], "localhost:8080");
+  ASSERT_EQ(*view.headers.find("Host"), "localhost:8080");
 }
 TEST(http_parse, partial) {
   ParseUnit parser;
@@ -53,8 +56,8 @@ TEST(http_parse, test_query) {
   ASSERT_TRUE(res.has_value());
   auto view = std::move(*res);
   ASSERT_EQ(view.query.size(), 2);
-  ASSERT_EQ(view.query["a"], "1");
-  ASSERT_EQ(view.query["b"], "2");
+  ASSERT_EQ(view.query.find("a"), "1");
+  ASSERT_EQ(view.query.find("b"), "2");
 }
 TEST(http_parse, test_query_empty) {
   ParseUnit parser;
@@ -64,8 +67,58 @@ TEST(http_parse, test_query_empty) {
   ASSERT_TRUE(res.has_value());
   auto view = std::move(*res);
   ASSERT_EQ(view.query.size(), 2);
-  ASSERT_EQ(view.query["a"], "1");
-  ASSERT_EQ(view.query["b"], "2");
+  ASSERT_EQ(view.query.find("a"), "1");
+  ASSERT_EQ(view.query.find("b"), "2");
+}
+TEST(http_parse, resume) {
+  ParseUnit parser;
+  const std::string_view data
+      = "GET / HTTP/1.1\r\nHost: localhost:8080\r\n"
+        "User-Agent: a-rather-long-user-agent-value\r\n\r\n";
+  std::size_t parsed = 0;
+  for (std::size_t end = 1; end < data.size(); ++end) {
+    auto [sz, res] = parser.parse(data.substr(parsed, end - parsed));
+    ASSERT_FALSE(res.has_value());
+    ASSERT_EQ(res.error(), std::errc::resource_unavailable_try_again);
+    parsed += sz;
+  }
+  auto [sz, res] = parser.parse(data.substr(parsed));
+  ASSERT_TRUE(res.has_value());
+  ASSERT_EQ(parsed + sz, data.size());
+  auto view = std::move(*res);
+  ASSERT_EQ(view.method, "GET");
+  ASSERT_EQ(view.headers.size(), 2);
+  ASSERT_EQ(*view.headers.find("User-Agent"), "a-rather-long-user-agent-value");
+}
+TEST(http_parse, long_line) {
+  ParseUnit parser;
+  std::string name(100, 'X'), value(100, 'v');
+  value[77] = '\t';
+  auto data = "GET / HTTP/1.1\r\n" + name + ": \t" + value + " \r\n\r\n";
+  auto [sz, res] = parser.parse(data);
+  ASSERT_TRUE(res.has_value());
+  ASSERT_EQ(sz, data.size());
+  auto view = std::move(*res);
+  ASSERT_EQ(*view.headers.find(name), value);
+  auto bad = "GET / HTTP/1.1\r\n" + name + ": " + value + "\x01\r\n\r\n";
+  auto [sz2, res2] = parser.parse(bad);
+  ASSERT_FALSE(res2.has_value());
+  ASSERT_EQ(res2.error(), std::errc::illegal_byte_sequence);
+  ASSERT_EQ(sz2, 16);
+}
+TEST(http_parse, invalid_token) {
+  ParseUnit parser;
+  for (std::string_view data : {"G(T / HTTP/1.1\r\n\r\n", "GET / HTTP/1.1\r\nHo st: a\r\n\r\n",
+                                "GET / HTTP/1.1\r\n Host: a\r\n\r\n",
+                                "GET / HTTP/1.1\r\nHost= localhost:8080\r\n\r\n",
+                                "GET / HTTP/1.1\nHost: a\r\n\r\n"}) {
+    auto [sz, res] = parser.parse(data);
+    ASSERT_FALSE(res.has_value()) << data;
+    ASSERT_EQ(res.error(), std::errc::illegal_byte_sequence) << data;
+  }
+  auto [sz, res] = parser.parse("\r\nGET / HTTP/1.1\r\n\r\n");
+  ASSERT_TRUE(res.has_value());
+  ASSERT_EQ(res->method, "GET");
 }
 
 TEST(request_target, origin_form) {
@@ -84,8 +137,8 @@ TEST(request_target, origin_form) {
   ASSERT_EQ(view2.authority, "");
   ASSERT_EQ(view2.path, "/");
   ASSERT_EQ(view2.query.size(), 2);
-  ASSERT_EQ(view2.query["a"], "1");
-  ASSERT_EQ(view2.query["b"], "2");
+  ASSERT_EQ(view2.query.find("a"), "1");
+  ASSERT_EQ(view2.query.find("b"), "2");
 }
 
 TEST(request_target, absolute_form) {
@@ -104,8 +157,8 @@ TEST(request_target, absolute_form) {
   ASSERT_EQ(view2.authority, "localhost");
   ASSERT_EQ(view2.path, "/");
   ASSERT_EQ(view2.query.size(), 2);
-  ASSERT_EQ(view2.query["a"], "1");
-  ASSERT_EQ(view2.query["b"], "2");
+  ASSERT_EQ(view2.query.find("a"), "1");
+  ASSERT_EQ(view2.query.find("b"), "2");
 }
 
 TEST(request_target, authority_form) {
@@ -126,6 +179,40 @@ TEST(request_target, authority_form) {
   ASSERT_EQ(view2.query.size(), 0);
 }
 
+TEST(request_target, asterisk_form) {
+  ParseUnit parser;
+  auto [sz, res] = parser.parse("OPTIONS * HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  ASSERT_TRUE(res.has_value());
+  ASSERT_EQ(res->path, "*");
+  ASSERT_EQ(res->authority, "");
+  auto [sz2, res2] = parser.parse("GET /index.html#top HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  ASSERT_FALSE(res2.has_value());
+  ASSERT_EQ(res2.error(), std::errc::illegal_byte_sequence);
+}
+
+TEST(request_target, query_decode) {
+  ParseUnit parser;
+  auto [sz, res]
+      = parser.parse("GET /s?q=a%20b+c&&flag&x=&%6Bey=v%2 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  ASSERT_TRUE(res.has_value());
+  auto view = std::move(*res);
+  ASSERT_EQ(view.path, "/s");
+  ASSERT_EQ(view.query.raw(), "q=a%20b+c&&flag&x=&%6Bey=v%2");
+  ASSERT_EQ(view.query.size(), 4);
+  ASSERT_EQ(view.query.find("q"), "a%20b+c");
+  ASSERT_EQ(view.query.get("q"), "a b c");
+  ASSERT_EQ(view.query.find("flag"), "");
+  ASSERT_EQ(view.query.find("x"), "");
+  ASSERT_EQ(view.query.get("key"), "v%2");
+  ASSERT_FALSE(view.query.contains("%6Bey"));
+  ASSERT_FALSE(view.query.contains("y"));
+  std::vector<std::string_view> names;
+  for (auto [name, value] : view.query) {
+    names.push_back(name);
+  }
+  ASSERT_EQ(names, (std::vector<std::string_view>{"q", "flag", "x", "%6Bey"}));
+}
+
 int main() {
   xsl::no_log();
   testing::InitGoogleTest();
@@ -0,0 +1,86 @@
+#include "xsl/coro.h"
+#include "xsl/logctl.h"
+#include "xsl/sync/deadline.h"
+#include "xsl/sync/poller.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <latch>
+#include <optional>
+#include <stop_token>
+#include <thread>
+using namespace xsl::sync;
+using namespace xsl::coro;
+using namespace std::chrono_literals;
+
+class DeadlineTest : public testing::Test {
+protected:
+  void SetUp() override {
+    this->poller = std::make_shared<Poller>();
+    this->thread = std::thread([poller = this->poller] {
+      while (poller->valid()) {
+        poller->poll();
+      }
+    });
+  }
+
+  void TearDown() override {
+    this->poller->shutdown();
+    this->thread.join();
+  }
+
+  std::shared_ptr<Poller> poller;
+  std::thread thread;
+};
+
+Lazy<void> wait_stoppable(CountingSemaphore<1> &sem, std::stop_token token,
+                          std::optional<bool> &res, std::latch &done) {
+  StopGuard guard{sem, token};
+  res = co_await sem;
+  done.count_down();
+}
+
+TEST_F(DeadlineTest, Expire) {
+  CountingSemaphore<1> sem;
+  std::optional<bool> res;
+  std::latch done(1);
+  Deadline deadline{*this->poller, 10ms};
+  wait_stoppable(sem, deadline.token(), res, done).detach();
+  done.wait();
+  ASSERT_EQ(res, false);
+  ASSERT_TRUE(deadline.expired());
+  ASSERT_TRUE(deadline.token().stop_requested());
+}
+
+TEST_F(DeadlineTest, Parent) {
+  CountingSemaphore<1> sem;
+  std::optional<bool> res;
+  std::latch done(1);
+  std::stop_source parent;
+  Deadline deadline{*this->poller, 1h, parent.get_token()};
+  wait_stoppable(sem, deadline.token(), res, done).detach();
+  ASSERT_FALSE(res.has_value());
+  parent.request_stop();
+  done.wait();
+  ASSERT_EQ(res, false);
+  ASSERT_FALSE(deadline.expired());
+}
+
+TEST_F(DeadlineTest, Disarm) {
+  {
+    Deadline deadline{*this->poller, 10ms};
+    ASSERT_FALSE(deadline.token().stop_requested());
+  }
+  // the timer is removed with the deadline
+  std::this_thread::sleep_for(20ms);
+  Deadline deadline{*this->poller, 1h};
+  ASSERT_FALSE(deadline.expired());
+}
+
+int main(int argc, char **argv) {
+  xsl::no_log();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,228 @@
+#include "xsl/logctl.h"
+#include "xsl/sync/poller.h"
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+using namespace xsl::sync;
+using namespace std::chrono_literals;
+/**
+ * @brief an entry owned by the test, counts its calls and its retirement
+ *
+ */
+class CountEntry final : public PollEntry {
+public:
+  CountEntry(int &retired, PollHandleHintTag tag = PollHandleHintTag::NONE)
+      : PollEntry(), handled(0), retired(retired), tag(tag) {}
+
+  PollHandleHint handle(int, IOM_EVENTS events) override {
+    if (!!events) {
+      ++this->handled;
+    }
+    return PollHandleHint{this->tag};
+  }
+
+  void retire() noexcept override { ++this->retired; }
+
+  int handled;
+  int &retired;
+  PollHandleHintTag tag;
+};
+
+TEST(PollTableTest, DeferredReclaim) {
+  int retired = 0;
+  CountEntry a{retired}, b{retired};
+  PollTable table;
+  ASSERT_TRUE(table.store(3, &a));
+  ASSERT_EQ(table.load(3), &a);
+  ASSERT_TRUE(table.store(3, &b));
+  ASSERT_EQ(table.load(3), &b);
+  // the replaced entry may still be used by a lookup in progress
+  ASSERT_EQ(retired, 0);
+  table.reclaim();
+  ASSERT_EQ(retired, 1);
+  ASSERT_TRUE(table.store(3, nullptr));
+  ASSERT_EQ(table.load(3), nullptr);
+  ASSERT_EQ(retired, 1);
+  table.reclaim();
+  ASSERT_EQ(retired, 2);
+}
+
+TEST(PollTableTest, Range) {
+  PollTable table;
+  ASSERT_FALSE(table.in_range(-1));
+  ASSERT_FALSE(table.store(-1, nullptr));
+  ASSERT_EQ(table.load(-1), nullptr);
+  // the segment is not allocated yet
+  ASSERT_TRUE(table.in_range(0));
+  ASSERT_EQ(table.load(0), nullptr);
+}
+
+class PollerTest : public testing::TestWithParam<PollEngine> {};
+
+TEST_P(PollerTest, StaleEvent) {
+  int a[2], b[2], fresh[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, a), 0);
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, b), 0);
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fresh), 0);
+  int stale = 0;
+  bool reused = false;
+  Poller poller{GetParam()};
+  ASSERT_TRUE(poller.valid());
+  // the first handler closes the other fd and reuses its number, the event of the other fd in the
+  // same batch is stale then
+  auto reuse = [&](int other) -> PollHandler {
+    return [&, other](int, IOM_EVENTS) {
+      if (!std::exchange(reused, true)) {
+        ::dup2(fresh[0], other);
+        poller.add(other, IOM_EVENTS::IN, [&](int, IOM_EVENTS events) {
+          if (!!events) {
+            ++stale;
+          }
+          return PollHandleHint{};
+        });
+      }
+      return PollHandleHint{};
+    };
+  };
+  ASSERT_TRUE(poller.add(a[0], IOM_EVENTS::IN, reuse(b[0])));
+  ASSERT_TRUE(poller.add(b[0], IOM_EVENTS::IN, reuse(a[0])));
+  ASSERT_EQ(::send(a[1], "a", 1, 0), 1);
+  ASSERT_EQ(::send(b[1], "b", 1, 0), 1);
+  poller.poll();
+  ASSERT_TRUE(reused);
+  // the reused fd is not readable, so no event belongs to it
+  ASSERT_EQ(stale, 0);
+  poller.shutdown();
+  for (int fd : {a[0], a[1], b[0], b[1], fresh[0], fresh[1]}) {
+    ::close(fd);
+  }
+}
+
+TEST_P(PollerTest, DeferredReclaim) {
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+  int retired = 0;
+  CountEntry entry{retired, PollHandleHintTag::DELETE};
+  Poller poller{GetParam()};
+  ASSERT_TRUE(poller.add(fds[0], IOM_EVENTS::IN, &entry));
+  ASSERT_EQ(::send(fds[1], "a", 1, 0), 1);
+  poller.poll();
+  // removed by its own handler, but retired only when no lookup can be in progress
+  ASSERT_EQ(entry.handled, 1);
+  ASSERT_EQ(retired, 0);
+  ASSERT_TRUE(poller.post([] {}));
+  poller.poll();
+  ASSERT_EQ(retired, 1);
+  ASSERT_EQ(entry.handled, 1);
+  poller.shutdown();
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+TEST_P(PollerTest, PostWakes) {
+  Poller poller{GetParam()};
+  std::thread::id ran_on;
+  // no timer is armed, so the poll blocks until the function is posted
+  std::thread thread([&poller] { poller.poll(); });
+  std::this_thread::sleep_for(20ms);
+  ASSERT_TRUE(poller.post([&ran_on] { ran_on = std::this_thread::get_id(); }));
+  auto polling = thread.get_id();
+  thread.join();
+  ASSERT_EQ(ran_on, polling);
+  poller.shutdown();
+}
+
+TEST_P(PollerTest, Wake) {
+  Poller poller{GetParam()};
+  std::thread thread([&poller] { poller.poll(); });
+  std::this_thread::sleep_for(20ms);
+  // the wakeups are coalesced, a single poll consumes them all
+  poller.wake();
+  poller.wake();
+  thread.join();
+  poller.shutdown();
+}
+
+TEST_P(PollerTest, WakeRace) {
+  // a wakeup racing with the drain of the eventfd must not swallow the later ones, otherwise the
+  // shutdown is never noticed and the join hangs
+  for (int round = 0; round < 200; ++round) {
+    Poller poller{GetParam()};
+    std::thread polling([&poller] {
+      while (poller.valid()) {
+        poller.poll();
+      }
+    });
+    std::vector<std::thread> wakers;
+    for (int i = 0; i < 4; ++i) {
+      wakers.emplace_back([&poller, i] {
+        for (int j = 0; j < 200; ++j) {
+          if (i % 2 == 0) {
+            poller.wake();
+          } else {
+            poller.post([] {});
+          }
+          std::this_thread::yield();
+        }
+      });
+    }
+    for (auto &waker : wakers) {
+      waker.join();
+    }
+    poller.shutdown();
+    polling.join();
+  }
+}
+
+TEST_P(PollerTest, ShutdownOnLoop) {
+  Poller poller{GetParam()};
+  ASSERT_TRUE(poller.post([] {}));
+  poller.poll();
+  int ran = 0;
+  ASSERT_TRUE(poller.post([&ran] { ++ran; }));
+  ASSERT_TRUE(poller.post([&ran] { ++ran; }));
+  // called from the polling thread, the queued functions are run at once
+  poller.shutdown();
+  ASSERT_EQ(ran, 2);
+  ASSERT_FALSE(poller.post([&ran] { ++ran; }));
+  ASSERT_EQ(ran, 2);
+}
+
+TEST_P(PollerTest, ShutdownOffLoop) {
+  auto poller = std::make_unique<Poller>(GetParam());
+  std::thread([&poller] {
+    EXPECT_TRUE(poller->post([] {}));
+    poller->poll();
+  }).join();
+  int ran = 0;
+  auto owned = std::make_shared<int>(0);
+  ASSERT_TRUE(poller->post([&ran, owned] { ++ran; }));
+  // the polling thread may still be running the queue, so it is left until the poller is destroyed
+  poller->shutdown();
+  ASSERT_EQ(ran, 0);
+  ASSERT_FALSE(poller->post([&ran] { ++ran; }));
+  poller.reset();
+  ASSERT_EQ(ran, 1);
+  // the function is destroyed after it is run
+  ASSERT_EQ(owned.use_count(), 1);
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, PollerTest,
+                         testing::Values(PollEngine::EPOLL, PollEngine::IO_URING),
+                         [](const testing::TestParamInfo<PollEngine> &info) {
+                           return std::string(to_string(info.param));
+                         });
+
+int main(int argc, char **argv) {
+  xsl::no_log();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,159 @@
+#include "xsl/logctl.h"
+#include "xsl/sync/mpmc.h"
+#include "xsl/sync/mpsc.h"
+#include "xsl/sync/spsc.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+using namespace xsl::sync;
+
+TEST(SPSCTest, Full) {
+  SPSC<int, 4> queue;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(queue.push(int{i}));
+  }
+  ASSERT_FALSE(queue.push(4));
+  ASSERT_EQ(queue.size(), 4);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(queue.pop(), i);
+  }
+  ASSERT_EQ(queue.pop(), std::nullopt);
+}
+
+TEST(SPSCTest, Batch) {
+  SPSC<int, 8> queue;
+  std::array<int, 6> in{0, 1, 2, 3, 4, 5};
+  ASSERT_EQ(queue.push_n(in.begin(), in.size()), 6);
+  // only 2 slots left
+  ASSERT_EQ(queue.push_n(in.begin(), in.size()), 2);
+  std::array<int, 8> out{};
+  ASSERT_EQ(queue.pop_n(out.begin(), 5), 5);
+  ASSERT_EQ(out[4], 4);
+  ASSERT_EQ(queue.pop_n(out.begin(), out.size()), 3);
+  ASSERT_EQ(out[0], 5);
+  ASSERT_EQ(out[2], 1);
+  ASSERT_EQ(queue.pop_n(out.begin(), out.size()), 0);
+}
+
+TEST(SPSCTest, Threads) {
+  const uint64_t count = 1000000;
+  auto queue = std::make_unique<SPSC<uint64_t, 1024>>();
+  std::thread producer([&] {
+    for (uint64_t i = 0; i < count;) {
+      if (queue->push(uint64_t{i})) {
+        ++i;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  std::array<uint64_t, 64> buffer{};
+  uint64_t expected = 0;
+  while (expected < count) {
+    auto n = queue->pop_n(buffer.begin(), buffer.size());
+    if (n == 0) {
+      std::this_thread::yield();
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      ASSERT_EQ(buffer[i], expected++);
+    }
+  }
+  producer.join();
+}
+
+TEST(MPMCTest, Full) {
+  MPMC<int, 4> queue;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(queue.push(int{i}));
+  }
+  ASSERT_FALSE(queue.push(4));
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(queue.pop(), i);
+  }
+  ASSERT_EQ(queue.pop(), std::nullopt);
+  // the next lap
+  ASSERT_TRUE(queue.push(5));
+  ASSERT_EQ(queue.pop(), 5);
+}
+
+TEST(MPMCTest, Threads) {
+  const uint64_t producers = 4, consumers = 4, count = 100000;
+  MPMC<uint64_t, 256> queue;
+  std::atomic_uint64_t sum = 0, popped = 0;
+  std::vector<std::thread> threads;
+  for (uint64_t p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p] {
+      for (uint64_t i = 0; i < count;) {
+        if (queue.push(p * count + i)) {
+          ++i;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (uint64_t c = 0; c < consumers; ++c) {
+    threads.emplace_back([&] {
+      while (popped.load() < producers * count) {
+        if (auto value = queue.pop()) {
+          sum += *value;
+          ++popped;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto total = producers * count;
+  ASSERT_EQ(sum.load(), total * (total - 1) / 2);
+}
+
+struct Item : MPSCNode {
+  uint64_t value = 0;
+};
+
+TEST(MPSCTest, Threads) {
+  const uint64_t producers = 4, count = 100000;
+  MPSC<Item> queue;
+  std::vector<Item> items(producers * count);
+  std::vector<std::thread> threads;
+  for (uint64_t p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p] {
+      for (uint64_t i = 0; i < count; ++i) {
+        auto &item = items[p * count + i];
+        item.value = i;
+        queue.push(&item);
+      }
+    });
+  }
+  // the values of every producer come in order
+  std::vector<uint64_t> next(producers, 0);
+  for (uint64_t popped = 0; popped < producers * count;) {
+    if (auto item = queue.pop()) {
+      auto p = static_cast<uint64_t>(item - items.data()) / count;
+      ASSERT_EQ(item->value, next[p]++);
+      ++popped;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_TRUE(queue.empty());
+}
+
+int main(int argc, char **argv) {
+  xsl::no_log();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,93 @@
+#include "xsl/coro.h"
+#include "xsl/logctl.h"
+#include "xsl/sync/runtime.h"
+
+#include <gtest/gtest.h>
+
+#include <latch>
+#include <memory>
+#include <thread>
+#include <vector>
+using namespace xsl::coro;
+using namespace xsl::sync;
+
+TEST(ReactorTest, RunStop) {
+  Reactor reactor{PollEngine::EPOLL};
+  std::thread thread([&reactor] { reactor.run(); });
+  std::latch done(1);
+  bool in_loop = false;
+  reactor.schedule([&] {
+    in_loop = reactor.in_loop();
+    done.count_down();
+  });
+  done.wait();
+  ASSERT_TRUE(in_loop);
+  reactor.stop();
+  thread.join();
+  // the poller is shutdown by the reactor thread, the functions are run in place from now on
+  ASSERT_FALSE(reactor.poller()->valid());
+  bool ran = false;
+  reactor.schedule([&ran] { ran = true; });
+  ASSERT_TRUE(ran);
+}
+
+TEST(RuntimeTest, StartStopJoin) {
+  Runtime runtime{2, PollEngine::EPOLL};
+  ASSERT_EQ(runtime.size(), 2);
+  runtime.start();
+  std::latch done(2);
+  for (std::size_t i = 0; i < runtime.size(); ++i) {
+    runtime.reactor(i)->schedule([&done] { done.count_down(); });
+  }
+  done.wait();
+  runtime.stop();
+  runtime.join();
+  for (std::size_t i = 0; i < runtime.size(); ++i) {
+    ASSERT_FALSE(runtime.reactor(i)->poller()->valid());
+  }
+}
+
+TEST(RuntimeTest, RoundRobin) {
+  Runtime runtime{3, PollEngine::EPOLL};
+  std::vector<Reactor *> picked;
+  for (int i = 0; i < 6; ++i) {
+    picked.push_back(runtime.next().get());
+  }
+  for (std::size_t i = 0; i < picked.size(); ++i) {
+    ASSERT_EQ(picked[i], runtime.reactor(i % runtime.size()).get());
+  }
+}
+
+Lazy<void> record_thread(std::shared_ptr<Reactor> reactor, std::thread::id &id, bool &in_loop,
+                         std::latch &done) {
+  id = std::this_thread::get_id();
+  in_loop = reactor->in_loop();
+  done.count_down();
+  co_return;
+}
+
+TEST(RuntimeTest, DetachOnReactor) {
+  Runtime runtime{2, PollEngine::EPOLL};
+  runtime.start();
+  std::thread::id ids[2];
+  bool in_loop[2] = {false, false};
+  std::latch done(2);
+  for (std::size_t i = 0; i < runtime.size(); ++i) {
+    record_thread(runtime.reactor(i), ids[i], in_loop[i], done).detach(runtime.reactor(i));
+  }
+  done.wait();
+  // every coroutine runs on the thread of the reactor it is detached on
+  ASSERT_TRUE(in_loop[0]);
+  ASSERT_TRUE(in_loop[1]);
+  ASSERT_NE(ids[0], ids[1]);
+  ASSERT_NE(ids[0], std::this_thread::get_id());
+  ASSERT_NE(ids[1], std::this_thread::get_id());
+  runtime.stop();
+  runtime.join();
+}
+
+int main(int argc, char **argv) {
+  xsl::no_log();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
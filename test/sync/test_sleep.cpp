@@ -0,0 +1,135 @@
+#include "xsl/coro.h"
+#include "xsl/logctl.h"
+#include "xsl/sync/poller.h"
+#include "xsl/sync/sleep.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <expected>
+#include <latch>
+#include <memory>
+#include <optional>
+#include <system_error>
+#include <thread>
+using namespace xsl::coro;
+using namespace xsl::sync;
+using namespace std::chrono_literals;
+using clock_type = TimerWheel::clock_type;
+
+class SleepTest : public testing::Test {
+public:
+  void SetUp() override {
+    this->poller = std::make_shared<Poller>();
+    this->thread = std::thread([poller = this->poller] {
+      while (poller->valid()) {
+        poller->poll();
+      }
+    });
+  }
+
+  void TearDown() override {
+    this->poller->shutdown();
+    this->thread.join();
+  }
+
+  std::shared_ptr<Poller> poller;
+  std::thread thread;
+};
+
+Lazy<void> sleep_until_into(Poller &poller, clock_type::time_point deadline,
+                            std::optional<clock_type::time_point> &woken, std::latch &done) {
+  co_await sleep_until(poller, deadline);
+  woken = clock_type::now();
+  done.count_down();
+}
+
+TEST_F(SleepTest, SleepUntil) {
+  auto deadline = clock_type::now() + 20ms;
+  std::optional<clock_type::time_point> woken;
+  std::latch done(1);
+  sleep_until_into(*this->poller, deadline, woken, done).detach();
+  done.wait();
+  ASSERT_GE(*woken, deadline);
+}
+
+Lazy<void> sleep_for_into(Poller &poller, clock_type::duration duration,
+                          std::optional<clock_type::time_point> &woken, std::latch &done) {
+  co_await sleep_for(poller, duration);
+  woken = clock_type::now();
+  done.count_down();
+}
+
+TEST_F(SleepTest, SleepFor) {
+  auto start = clock_type::now();
+  std::optional<clock_type::time_point> woken;
+  std::latch done(1);
+  sleep_for_into(*this->poller, 20ms, woken, done).detach();
+  done.wait();
+  ASSERT_GE(*woken - start, 20ms);
+}
+
+Lazy<void> sleep_on_loop(Poller &poller, std::optional<clock_type::time_point> &woken,
+                         bool &in_loop, std::latch &done) {
+  auto start = clock_type::now();
+  // the poller of the current thread is used
+  co_await sleep_for(20ms);
+  woken = clock_type::now();
+  in_loop = poller.in_loop() && woken >= start + 20ms;
+  done.count_down();
+}
+
+TEST_F(SleepTest, SleepOnLoop) {
+  std::optional<clock_type::time_point> woken;
+  bool in_loop = false;
+  std::latch done(1);
+  ASSERT_TRUE(
+      this->poller->post([&] { sleep_on_loop(*this->poller, woken, in_loop, done).detach(); }));
+  done.wait();
+  ASSERT_TRUE(in_loop);
+}
+
+TEST(SleepDeathTest, OffLoop) {
+  // nothing would wake the sleep up, the poller must be passed explicitly
+  EXPECT_DEBUG_DEATH(sleep_for(20ms), "not on a polling thread");
+}
+
+Lazy<bool> wait(CountingSemaphore<1> &sem) { co_return co_await sem; }
+
+Lazy<int> answer() { co_return 42; }
+
+template <class T>
+Lazy<void> timeout_into(Poller &poller, Lazy<T> task, clock_type::duration timeout,
+                        std::optional<std::expected<T, std::errc>> &res, std::latch &done) {
+  res = co_await with_timeout(poller, std::move(task), timeout);
+  done.count_down();
+}
+
+TEST_F(SleepTest, Timeout) {
+  auto sem = std::make_shared<CountingSemaphore<1>>();
+  auto start = clock_type::now();
+  std::optional<std::expected<bool, std::errc>> res;
+  std::latch done(1);
+  // the semaphore is not released, so the wait never completes in time
+  timeout_into(*this->poller, wait(*sem), 20ms, res, done).detach();
+  done.wait();
+  ASSERT_GE(clock_type::now() - start, 20ms);
+  ASSERT_FALSE(res->has_value());
+  ASSERT_EQ(res->error(), std::errc::timed_out);
+  // the abandoned wait finishes in the background, its result is dropped
+  sem->release();
+}
+
+TEST_F(SleepTest, Complete) {
+  std::optional<std::expected<int, std::errc>> res;
+  std::latch done(1);
+  timeout_into(*this->poller, answer(), 1h, res, done).detach();
+  done.wait();
+  ASSERT_EQ(*res, 42);
+}
+
+int main(int argc, char **argv) {
+  xsl::no_log();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
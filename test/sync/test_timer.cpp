@@ -0,0 +1,97 @@
+#include "xsl/logctl.h"
+#include "xsl/sync/timer.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+using namespace xsl::sync;
+using namespace std::chrono_literals;
+
+class CountTimer : public Timer {
+public:
+  CountTimer() : Timer(&CountTimer::on_expire), count(0) {}
+  int count;
+
+private:
+  static void on_expire(Timer *self) { ++static_cast<CountTimer *>(self)->count; }
+};
+
+static int fire(Timer *expired) {
+  int n = 0;
+  while (expired != nullptr) {
+    auto next = TimerWheel::next(expired);
+    expired->fire();
+    expired = next;
+    ++n;
+  }
+  return n;
+}
+
+TEST(TimerWheelTest, Expire) {
+  TimerWheel wheel;
+  auto start = TimerWheel::clock_type::now();
+  CountTimer timer;
+  wheel.arm(&timer, start + 10ms);
+  ASSERT_TRUE(timer.armed());
+  ASSERT_EQ(fire(wheel.advance(start + 5ms)), 0);
+  ASSERT_EQ(fire(wheel.advance(start + 11ms)), 1);
+  ASSERT_EQ(timer.count, 1);
+  ASSERT_FALSE(timer.armed());
+  ASSERT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, Cancel) {
+  TimerWheel wheel;
+  auto start = TimerWheel::clock_type::now();
+  CountTimer a, b;
+  wheel.arm(&a, start + 10ms);
+  wheel.arm(&b, start + 10ms);
+  ASSERT_TRUE(wheel.cancel(&a));
+  ASSERT_FALSE(wheel.cancel(&a));
+  ASSERT_EQ(fire(wheel.advance(start + 20ms)), 1);
+  ASSERT_EQ(a.count, 0);
+  ASSERT_EQ(b.count, 1);
+}
+
+TEST(TimerWheelTest, Cascade) {
+  TimerWheel wheel;
+  auto start = TimerWheel::clock_type::now();
+  std::vector<CountTimer> timers(64);
+  for (std::size_t i = 0; i < timers.size(); ++i) {
+    wheel.arm(&timers[i], start + std::chrono::milliseconds(i * i * i * 97));
+  }
+  // follow the timeout like a poller does, no timer may fire early or be skipped
+  auto now = start;
+  while (!wheel.empty()) {
+    now += std::chrono::milliseconds(std::max(wheel.timeout(now, -1), 1));
+    for (auto expired = wheel.advance(now); expired != nullptr;) {
+      auto next = TimerWheel::next(expired);
+      auto idx = static_cast<CountTimer *>(expired) - timers.data();
+      ASSERT_GE(now, start + std::chrono::milliseconds(idx * idx * idx * 97));
+      expired->fire();
+      expired = next;
+    }
+  }
+  for (auto &timer : timers) {
+    ASSERT_EQ(timer.count, 1);
+  }
+}
+
+TEST(TimerWheelTest, Timeout) {
+  TimerWheel wheel;
+  auto start = TimerWheel::clock_type::now();
+  ASSERT_EQ(wheel.timeout(start, 100), 100);
+  ASSERT_EQ(wheel.timeout(start, -1), -1);
+  CountTimer timer;
+  wheel.arm(&timer, start + 30ms);
+  ASSERT_LE(wheel.timeout(start, 100), 31);
+  ASSERT_EQ(wheel.timeout(start, 10), 10);
+}
+
+int main(int argc, char **argv) {
+  xsl::no_log();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
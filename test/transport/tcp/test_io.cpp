@@ -0,0 +1,474 @@
+#include "xsl/coro.h"
+#include "xsl/logctl.h"
+#include "xsl/sync.h"
+#include "xsl/sys/net/block.h"
+#include "xsl/sys/net/dev.h"
+#include "xsl/sys/net/io.h"
+#include "xsl/sys/pipe.h"
+
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <latch>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+using namespace xsl::coro;
+using namespace xsl;
+using namespace std::chrono_literals;
+/**
+ * @brief a pair of connected nonblocking sockets registered to a polling thread
+ *
+ */
+class IoTest : public testing::Test {
+public:
+  void SetUp() override {
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, this->fds), 0);
+    this->poller = std::make_shared<sync::Poller>();
+    for (int i = 0; i < 2; ++i) {
+      this->read_sems[i] = std::make_shared<CountingSemaphore<1>>();
+      this->write_sems[i] = std::make_shared<CountingSemaphore<1>>();
+      this->poller->add(this->fds[i],
+                        sync::IOM_EVENTS::IN | sync::IOM_EVENTS::OUT | sync::IOM_EVENTS::ET,
+                        sync::PollCallback<sync::PollTraits, sync::IOM_EVENTS::IN,
+                                           sync::IOM_EVENTS::OUT>{this->read_sems[i],
+                                                                  this->write_sems[i]});
+    }
+    this->thread = std::thread([poller = this->poller] {
+      while (poller->valid()) {
+        poller->poll();
+      }
+    });
+  }
+
+  void TearDown() override {
+    this->poller->shutdown();
+    this->thread.join();
+    ::close(this->fds[0]);
+    ::close(this->fds[1]);
+  }
+
+  sys::net::RecvAwaiter recv(int idx, std::span<std::byte> buf, std::stop_token token = {}) {
+    return {this->fds[idx], *this->read_sems[idx], buf, std::move(token)};
+  }
+
+  sys::net::SendAwaiter send(int idx, std::span<const std::byte> data) {
+    return {this->fds[idx], *this->write_sems[idx], data, {}};
+  }
+
+  int fds[2];
+  std::shared_ptr<CountingSemaphore<1>> read_sems[2], write_sems[2];
+  std::shared_ptr<sync::Poller> poller;
+  std::thread thread;
+};
+
+Lazy<void> await_into(sys::net::RecvAwaiter awaiter, std::optional<ai::Result> &res,
+                      std::latch &done) {
+  res = co_await awaiter;
+  done.count_down();
+}
+
+Lazy<void> await_into(sys::net::SendAwaiter awaiter, std::optional<ai::Result> &res,
+                      std::latch &done) {
+  res = co_await awaiter;
+  done.count_down();
+}
+
+Lazy<void> await_into(sys::net::WritevAwaiter awaiter, std::optional<ai::Result> &res,
+                      std::latch &done) {
+  res = co_await awaiter;
+  done.count_down();
+}
+
+TEST_F(IoTest, Ready) {
+  std::string_view msg = "hello";
+  auto [sz, err] = [](IoTest &t, std::string_view msg) -> Lazy<ai::Result> {
+    co_return co_await t.send(0, std::as_bytes(std::span(msg)));
+  }(*this, msg)
+                                                                 .block();
+  ASSERT_EQ(sz, msg.size());
+  ASSERT_FALSE(err.has_value());
+  std::byte buf[16];
+  auto [r_sz, r_err] = [](IoTest &t, std::span<std::byte> buf) -> Lazy<ai::Result> {
+    co_return co_await t.recv(1, buf);
+  }(*this, buf)
+                                                                   .block();
+  ASSERT_EQ(r_sz, msg.size());
+  ASSERT_FALSE(r_err.has_value());
+  ASSERT_EQ(std::string_view(reinterpret_cast<const char *>(buf), r_sz), msg);
+}
+
+TEST_F(IoTest, WaitRecv) {
+  std::byte buf[16];
+  std::optional<ai::Result> res;
+  std::latch done(1);
+  await_into(this->recv(1, buf), res, done).detach();
+  ASSERT_FALSE(res.has_value());
+  ASSERT_EQ(::send(this->fds[0], "ping", 4, 0), 4);
+  done.wait();
+  ASSERT_EQ(std::get<0>(*res), 4);
+  ASSERT_FALSE(std::get<1>(*res).has_value());
+}
+
+TEST_F(IoTest, WaitSend) {
+  // larger than the buffer of the socket, the send waits for the reader
+  std::vector<std::byte> data(4 * 1024 * 1024, std::byte{'x'});
+  std::optional<ai::Result> res;
+  std::latch done(1);
+  await_into(this->send(0, data), res, done).detach();
+  std::size_t total = 0;
+  std::byte buf[64 * 1024];
+  while (total < data.size()) {
+    auto n = ::recv(this->fds[1], buf, sizeof(buf), 0);
+    if (n > 0) {
+      total += n;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  done.wait();
+  ASSERT_EQ(std::get<0>(*res), data.size());
+  ASSERT_FALSE(std::get<1>(*res).has_value());
+}
+
+TEST_F(IoTest, Writev) {
+  std::string_view parts[] = {"HTTP/1.1 200 OK\r\n\r\n", "", "hello", " world"};
+  std::vector<iovec> iov;
+  std::string expected;
+  for (auto part : parts) {
+    iov.push_back({const_cast<char *>(part.data()), part.size()});
+    expected += part;
+  }
+  std::optional<ai::Result> res;
+  std::latch done(1);
+  await_into(sys::net::WritevAwaiter{this->fds[0], *this->write_sems[0], iov, {}}, res, done)
+      .detach();
+  done.wait();
+  ASSERT_EQ(std::get<0>(*res), expected.size());
+  ASSERT_FALSE(std::get<1>(*res).has_value());
+  char buf[64];
+  ASSERT_EQ(::recv(this->fds[1], buf, sizeof(buf), 0), expected.size());
+  ASSERT_EQ(std::string_view(buf, expected.size()), expected);
+}
+
+TEST_F(IoTest, WaitWritev) {
+  // the buffers are sent partially, the rest of a buffer is sent before the following ones
+  std::vector<char> first(2 * 1024 * 1024, 'a'), second(2 * 1024 * 1024, 'b');
+  iovec iov[] = {{first.data(), first.size()}, {second.data(), second.size()}};
+  std::optional<ai::Result> res;
+  std::latch done(1);
+  await_into(sys::net::WritevAwaiter{this->fds[0], *this->write_sems[0], iov, {}}, res, done)
+      .detach();
+  std::string received;
+  char buf[64 * 1024];
+  while (received.size() < first.size() + second.size()) {
+    auto n = ::recv(this->fds[1], buf, sizeof(buf), 0);
+    if (n > 0) {
+      received.append(buf, n);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  done.wait();
+  ASSERT_EQ(std::get<0>(*res), first.size() + second.size());
+  ASSERT_FALSE(std::get<1>(*res).has_value());
+  ASSERT_EQ(received.find('b'), first.size());
+  ASSERT_EQ(received.find('a', first.size()), std::string::npos);
+}
+
+/**
+ * @brief connect a pair of tcp sockets on the loopback
+ *
+ * @param fds the client and the accepted socket
+ */
+void loopback_pair(int (&fds)[2]) {
+  int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  ASSERT_NE(listener, -1);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  ASSERT_EQ(::bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+  ASSERT_EQ(::listen(listener, 1), 0);
+  ASSERT_EQ(::getsockname(listener, reinterpret_cast<sockaddr *>(&addr), &len), 0);
+  fds[0] = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  ASSERT_EQ(::connect(fds[0], reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+  fds[1] = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  ASSERT_NE(fds[1], -1);
+  ::close(listener);
+}
+
+TEST(Coalesce, Cork) {
+  int fds[2];
+  ASSERT_NO_FATAL_FAILURE(loopback_pair(fds));
+  auto [client, server] = fds;
+  char buf[16];
+  {
+    sys::net::TcpCork cork{server};
+    ASSERT_EQ(::send(server, "header", 6, 0), 6);
+    // the partial segment is held back while corked
+    ASSERT_EQ(::recv(client, buf, sizeof(buf), MSG_DONTWAIT), -1);
+  }
+  ASSERT_EQ(::recv(client, buf, sizeof(buf), 0), 6);
+  ::close(server);
+  ::close(client);
+}
+
+TEST(Coalesce, Push) {
+  int fds[2];
+  ASSERT_NO_FATAL_FAILURE(loopback_pair(fds));
+  auto [client, server] = fds;
+  char buf[16];
+  {
+    sys::net::TcpPush push{server};
+    ASSERT_EQ(::send(server, "header", 6, MSG_MORE), 6);
+    ASSERT_EQ(::recv(client, buf, sizeof(buf), MSG_DONTWAIT), -1);
+  }
+  // pushed at once, rather than after the cork timeout
+  ASSERT_EQ(::recv(client, buf, sizeof(buf), MSG_DONTWAIT), 6);
+  {
+    sys::net::TcpPush push{server};
+    ASSERT_EQ(::send(server, "header", 6, MSG_MORE), 6);
+    ASSERT_EQ(::send(server, "body", 4, 0), 4);
+    // the following send pushed both
+    push.release();
+  }
+  ASSERT_EQ(::recv(client, buf, sizeof(buf), 0), 10);
+  ::close(server);
+  ::close(client);
+}
+
+using OutDevice = sys::net::AsyncDevice<
+    feature::Out<sys::net::SocketTraits<feature::Tcp<feature::Ip<4>>>>>;
+
+Lazy<void> write_into(OutDevice &dev, std::span<const std::byte> data,
+                      std::optional<ai::Result> &res, std::latch &done) {
+  res = co_await dev.write(data);
+  done.count_down();
+}
+
+TEST_F(IoTest, ZeroCopy) {
+  int fds[2];
+  ASSERT_NO_FATAL_FAILURE(loopback_pair(fds));
+  auto [client, server] = fds;
+  auto block = sys::net::BlockRef<sync::PollTraits>::create(
+      server, *this->poller, sync::IOM_EVENTS::IN | sync::IOM_EVENTS::OUT | sync::IOM_EVENTS::ET);
+  ASSERT_TRUE(block.has_value());
+  OutDevice dev{this->poller.get(), std::move(*block)};
+  if (!dev.set_zerocopy(64 * 1024)) {
+    ::close(client);
+    GTEST_SKIP() << "SO_ZEROCOPY is not supported";
+  }
+  std::string data(4 * 1024 * 1024, '\0');
+  for (std::size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>('a' + i % 26);
+  }
+  std::optional<ai::Result> res;
+  std::latch done(1);
+  write_into(dev, std::as_bytes(std::span(data)), res, done).detach();
+  std::string received;
+  char buf[64 * 1024];
+  while (received.size() < data.size()) {
+    auto n = ::recv(client, buf, sizeof(buf), 0);
+    ASSERT_GT(n, 0);
+    received.append(buf, n);
+  }
+  // the task completes once all completions are reaped from the error queue
+  done.wait();
+  ASSERT_EQ(std::get<0>(*res), data.size());
+  ASSERT_FALSE(std::get<1>(*res).has_value());
+  ASSERT_EQ(received, data);
+  ::close(client);
+}
+
+using InOutDevice = sys::net::AsyncDevice<
+    feature::InOut<sys::net::SocketTraits<feature::Tcp<feature::Ip<4>>>>>;
+
+Lazy<void> write_into(OutDevice &dev, std::span<const std::byte> data, std::stop_token token,
+                      std::optional<ai::Result> &res, std::latch &done) {
+  res = co_await dev.write(data, std::move(token));
+  done.count_down();
+}
+
+TEST_F(IoTest, ZeroCopyCancel) {
+  int fds[2];
+  ASSERT_NO_FATAL_FAILURE(loopback_pair(fds));
+  auto [client, server] = fds;
+  auto block = sys::net::BlockRef<sync::PollTraits>::create(
+      server, *this->poller, sync::IOM_EVENTS::IN | sync::IOM_EVENTS::OUT | sync::IOM_EVENTS::ET);
+  ASSERT_TRUE(block.has_value());
+  InOutDevice skt{this->poller.get(), std::move(*block)};
+  if (!skt.set_zerocopy(64 * 1024)) {
+    ::close(client);
+    GTEST_SKIP() << "SO_ZEROCOPY is not supported";
+  }
+  // the threshold is kept by the half sending
+  auto [in, dev] = std::move(skt).split();
+  ASSERT_EQ(dev.zerocopy(), 64 * 1024);
+  // far larger than the buffers of both sockets, the peer does not read until the stop
+  std::string data(32 * 1024 * 1024, '\0');
+  for (std::size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>('a' + i % 26);
+  }
+  std::optional<ai::Result> res;
+  std::latch done(1);
+  std::stop_source source;
+  write_into(dev, std::as_bytes(std::span(data)), source.get_token(), res, done).detach();
+  std::this_thread::sleep_for(20ms);
+  source.request_stop();
+  // the pages queued in the socket are still in use, so the task waits for their completions
+  std::this_thread::sleep_for(50ms);
+  ASSERT_FALSE(done.try_wait());
+  std::string received;
+  char buf[64 * 1024];
+  while (!done.try_wait()) {
+    auto n = ::recv(client, buf, sizeof(buf), MSG_DONTWAIT);
+    if (n > 0) {
+      received.append(buf, n);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  ASSERT_EQ(std::get<1>(*res), std::errc::operation_canceled);
+  auto sent = std::get<0>(*res);
+  ASSERT_LT(sent, data.size());
+  // nothing is sent after the stop
+  while (received.size() < sent) {
+    auto n = ::recv(client, buf, sizeof(buf), 0);
+    ASSERT_GT(n, 0);
+    received.append(buf, n);
+  }
+  ASSERT_EQ(received, data.substr(0, sent));
+  ::close(client);
+}
+
+TEST_F(IoTest, Cancel) {
+  std::byte buf[16];
+  std::optional<ai::Result> res;
+  std::latch done(1);
+  std::stop_source source;
+  await_into(this->recv(1, buf, source.get_token()), res, done).detach();
+  ASSERT_FALSE(res.has_value());
+  source.request_stop();
+  done.wait();
+  ASSERT_EQ(std::get<1>(*res), std::errc::operation_canceled);
+}
+
+TEST_F(IoTest, Block) {
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+  auto block = sys::net::BlockRef<sync::PollTraits>::create(
+      fds[0], *this->poller, sync::IOM_EVENTS::IN | sync::IOM_EVENTS::OUT | sync::IOM_EVENTS::ET);
+  ASSERT_TRUE(block.has_value());
+  auto other = *block;
+  std::byte buf[16];
+  std::optional<ai::Result> res;
+  std::latch done(1);
+  await_into(sys::net::RecvAwaiter{other.raw(), other.read_sem(), buf, {}}, res, done).detach();
+  ASSERT_FALSE(res.has_value());
+  ASSERT_EQ(::send(fds[1], "ping", 4, 0), 4);
+  done.wait();
+  ASSERT_EQ(std::get<0>(*res), 4);
+  // the fd is closed with the last user
+  { auto first = std::move(*block); }
+  ASSERT_NE(::fcntl(fds[0], F_GETFD), -1);
+  { auto last = std::move(other); }
+  ASSERT_EQ(::fcntl(fds[0], F_GETFD), -1);
+  ::close(fds[1]);
+}
+
+TEST(BlockTest, AttachFailed) {
+  sync::Poller poller{sync::PollEngine::EPOLL};
+  // a regular file can not be polled by epoll
+  int fd = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+  ASSERT_NE(fd, -1);
+  auto block = sys::net::BlockRef<sync::PollTraits>::create(
+      fd, poller, sync::IOM_EVENTS::IN | sync::IOM_EVENTS::ET);
+  ASSERT_FALSE(block.has_value());
+  ASSERT_EQ(block.error(), std::errc::operation_not_permitted);
+  // the fd is owned by the block, so it is closed on failure too
+  ASSERT_EQ(::fcntl(fd, F_GETFD), -1);
+  poller.shutdown();
+}
+
+/// @brief a half of a socket, as the relay sees it
+struct Half {
+  int fd;
+  CountingSemaphore<1> &ready;
+
+  int raw() const { return this->fd; }
+
+  CountingSemaphore<1> &sem() { return this->ready; }
+};
+
+Lazy<void> relay_into(Half from, Half to, sys::PipePool &pool, std::optional<ai::Result> &res,
+                      std::latch &done) {
+  res = co_await sys::relay(from, to, pool);
+  done.count_down();
+}
+
+TEST_F(IoTest, Relay) {
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+  auto block = sys::net::BlockRef<sync::PollTraits>::create(
+      fds[0], *this->poller, sync::IOM_EVENTS::IN | sync::IOM_EVENTS::OUT | sync::IOM_EVENTS::ET);
+  ASSERT_TRUE(block.has_value());
+  sys::PipePool pool{64 * 1024};
+  std::optional<ai::Result> res;
+  std::latch done(1);
+  // larger than the pipe and the buffers of the sockets, both directions wait
+  std::string data(4 * 1024 * 1024, '\0');
+  for (std::size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>('a' + i % 26);
+  }
+  relay_into({this->fds[1], *this->read_sems[1]}, {block->raw(), block->write_sem()}, pool, res,
+             done)
+      .detach();
+  std::size_t sent = 0;
+  std::string received;
+  char buf[64 * 1024];
+  while (received.size() < data.size()) {
+    if (sent < data.size()) {
+      auto n = ::send(this->fds[0], data.data() + sent, data.size() - sent, 0);
+      if (n > 0) {
+        sent += n;
+        if (sent == data.size()) {
+          ::shutdown(this->fds[0], SHUT_WR);
+        }
+      }
+    }
+    auto n = ::recv(fds[1], buf, sizeof(buf), 0);
+    if (n > 0) {
+      received.append(buf, n);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  done.wait();
+  ASSERT_EQ(std::get<0>(*res), data.size());
+  ASSERT_FALSE(std::get<1>(*res).has_value());
+  ASSERT_EQ(received, data);
+  // the drained pipe is back in the pool
+  auto pipe = pool.acquire();
+  ASSERT_TRUE(pipe.has_value());
+  ASSERT_GE(pipe->capacity(), 64 * 1024);
+  ::close(fds[1]);
+}
+
+int main(int argc, char **argv) {
+  xsl::no_log();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
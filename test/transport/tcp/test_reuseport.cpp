@@ -0,0 +1,132 @@
+#include "xsl/feature.h"
+#include "xsl/logctl.h"
+#include "xsl/net/tcp.h"
+#include "xsl/sys.h"
+
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace xsl;
+
+const std::size_t CONNECTIONS_PER_CPU = 8;
+
+/// @brief a free port on the loopback
+static uint16_t free_port() {
+  int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  ::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+  ::getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len);
+  ::close(fd);
+  return ntohs(addr.sin_port);
+}
+/// @brief connect from a thread pinned to the cpu, so that the connection is received by it
+static std::vector<int> connect_on(int cpu, uint16_t port, std::size_t count) {
+  std::vector<int> fds;
+  std::thread([&] {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    for (std::size_t i = 0; i < count; ++i) {
+      int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0) {
+        fds.push_back(fd);
+      } else {
+        ::close(fd);
+      }
+    }
+  }).join();
+  return fds;
+}
+/// @brief accept all pending connections of the nonblocking listener
+static std::size_t drain(int listener) {
+  std::size_t n = 0;
+  while (true) {
+    int fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd == -1) {
+      return n;
+    }
+    ::close(fd);
+    ++n;
+  }
+}
+
+TEST(ReusePortTest, Cbpf) {
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+  std::vector<int> cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE && cpus.size() < 4; ++cpu) {
+    if (CPU_ISSET(cpu, &allowed)) {
+      cpus.push_back(cpu);
+    }
+  }
+  ASSERT_FALSE(cpus.empty());
+  if (cpus.size() == 1) {
+    // the only cpu is served by the second listener, the hash would pick both
+    cpus.insert(cpus.begin(), -1);
+  }
+  auto port = std::to_string(free_port());
+  auto skts = _net::tcp_serv<feature::Ip<4>>("127.0.0.1", port.c_str(), cpus,
+                                             _net::ReusePortSteering::NONE);
+  ASSERT_TRUE(skts.has_value());
+  ASSERT_EQ(skts->size(), cpus.size());
+  if (auto res = sys::tcp::attach_reuseport_cbpf(skts->front(), cpus); !res) {
+    GTEST_SKIP() << "failed to attach the reuseport cbpf, "
+                 << std::make_error_code(res.error()).message();
+  }
+  std::vector<int> clients;
+  for (auto cpu : cpus) {
+    if (cpu < 0) {
+      continue;
+    }
+    auto fds = connect_on(cpu, static_cast<uint16_t>(std::stoi(port)), CONNECTIONS_PER_CPU);
+    ASSERT_EQ(fds.size(), CONNECTIONS_PER_CPU);
+    clients.insert(clients.end(), fds.begin(), fds.end());
+  }
+  // every listener accepts exactly the connections received by its cpu
+  for (std::size_t i = 0; i < cpus.size(); ++i) {
+    ASSERT_EQ(drain((*skts)[i].raw()), cpus[i] < 0 ? 0 : CONNECTIONS_PER_CPU) << "listener " << i;
+  }
+  for (int fd : clients) {
+    ::close(fd);
+  }
+}
+
+TEST(ReusePortTest, IncomingCpu) {
+  std::vector<int> cpus = {0, -1};
+  auto port = std::to_string(free_port());
+  auto skts = _net::tcp_serv<feature::Ip<4>>("127.0.0.1", port.c_str(), cpus,
+                                             _net::ReusePortSteering::INCOMING_CPU);
+  ASSERT_TRUE(skts.has_value());
+  ASSERT_EQ(skts->size(), cpus.size());
+  int cpu = -1;
+  socklen_t len = sizeof(cpu);
+  ASSERT_EQ(getsockopt((*skts)[0].raw(), SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len), 0);
+  ASSERT_EQ(cpu, 0);
+  ASSERT_TRUE(sys::tcp::set_incoming_cpu((*skts)[1], 0).has_value());
+  ASSERT_EQ(getsockopt((*skts)[1].raw(), SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len), 0);
+  ASSERT_EQ(cpu, 0);
+}
+
+int main(int argc, char **argv) {
+  xsl::no_log();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,168 @@
+#include "xsl/coro.h"
+#include "xsl/feature.h"
+#include "xsl/logctl.h"
+#include "xsl/sync.h"
+#include "xsl/sys.h"
+#include "xsl/sys/net/dev.h"
+
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+using namespace xsl::coro;
+using namespace xsl;
+using namespace std::chrono_literals;
+using clock_type = sync::TimerWheel::clock_type;
+using feature::Ip;
+using feature::Tcp;
+
+/// @brief the max delay of the timeout, far below the retransmission of the silent peer
+const auto SLACK = 500ms;
+/**
+ * @brief a listener on the loopback which never accepts and a polling thread
+ *
+ */
+class TimeoutTest : public testing::TestWithParam<sync::PollEngine> {
+public:
+  void SetUp() override {
+    this->poller = std::make_shared<sync::Poller>(GetParam());
+    if (this->poller->engine() != GetParam()) {
+      GTEST_SKIP() << "the engine is not available";
+    }
+    this->listener = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ASSERT_NE(this->listener, -1);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(::bind(this->listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+    // a small backlog, so the accept queue is easily full
+    ASSERT_EQ(::listen(this->listener, 1), 0);
+    ASSERT_EQ(::getsockname(this->listener, reinterpret_cast<sockaddr *>(&addr), &len), 0);
+    this->port = std::to_string(ntohs(addr.sin_port));
+    this->thread = std::thread([poller = this->poller] {
+      while (poller->valid()) {
+        poller->poll();
+      }
+    });
+  }
+
+  void TearDown() override {
+    this->poller->shutdown();
+    if (this->thread.joinable()) {
+      this->thread.join();
+    }
+    if (this->listener != -1) {
+      ::close(this->listener);
+    }
+  }
+
+  decltype(auto) endpoints() {
+    return net::Resolver{}.resolve<Tcp<Ip<4>>>("127.0.0.1", this->port.c_str());
+  }
+
+  int listener = -1;
+  std::string port;
+  std::shared_ptr<sync::Poller> poller;
+  std::thread thread;
+};
+
+TEST_P(TimeoutTest, ReadFor) {
+  auto eps = this->endpoints();
+  ASSERT_TRUE(eps.has_value());
+  auto skt = sys::tcp::connect(*eps, *this->poller).block();
+  ASSERT_TRUE(skt.has_value());
+  auto [in, out] = std::move(*skt).split();
+  // the peer is accepted by the kernel but never writes
+  std::byte buf[16];
+  auto start = clock_type::now();
+  auto [sz, err] = sys::net::read_for(in, buf, 20ms).block();
+  auto elapsed = clock_type::now() - start;
+  ASSERT_EQ(sz, 0);
+  ASSERT_EQ(err, std::errc::timed_out);
+  ASSERT_GE(elapsed, 20ms);
+  ASSERT_LT(elapsed, 20ms + SLACK);
+}
+
+TEST_P(TimeoutTest, WriteUntil) {
+  auto eps = this->endpoints();
+  ASSERT_TRUE(eps.has_value());
+  auto skt = sys::tcp::connect(*eps, *this->poller).block();
+  ASSERT_TRUE(skt.has_value());
+  auto [in, out] = std::move(*skt).split();
+  // larger than the buffers of both sockets, the peer never reads
+  std::vector<std::byte> data(16 * 1024 * 1024, std::byte{'x'});
+  auto start = clock_type::now();
+  auto [sz, err] = sys::net::write_until(out, data, start + 20ms).block();
+  auto elapsed = clock_type::now() - start;
+  ASSERT_LT(sz, data.size());
+  ASSERT_EQ(err, std::errc::timed_out);
+  ASSERT_GE(elapsed, 20ms);
+  ASSERT_LT(elapsed, 20ms + SLACK);
+}
+
+TEST_P(TimeoutTest, ConnectFor) {
+  auto eps = this->endpoints();
+  ASSERT_TRUE(eps.has_value());
+  // the connections fill the accept queue, the syns are dropped by the listener from then on
+  std::vector<int> pending;
+  bool timed_out = false;
+  for (int i = 0; i < 16 && !timed_out; ++i) {
+    auto start = clock_type::now();
+    auto res = sys::tcp::connect_for(*eps, *this->poller, 20ms).block();
+    auto elapsed = clock_type::now() - start;
+    if (res) {
+      pending.push_back(::dup(res->raw()));
+      continue;
+    }
+    ASSERT_EQ(res.error(), std::errc::timed_out);
+    ASSERT_GE(elapsed, 20ms);
+    ASSERT_LT(elapsed, 20ms + SLACK);
+    timed_out = true;
+  }
+  ASSERT_TRUE(timed_out);
+  for (int fd : pending) {
+    ::close(fd);
+  }
+}
+
+TEST_P(TimeoutTest, Cancel) {
+  auto eps = this->endpoints();
+  ASSERT_TRUE(eps.has_value());
+  auto skt = sys::tcp::connect(*eps, *this->poller).block();
+  ASSERT_TRUE(skt.has_value());
+  auto [in, out] = std::move(*skt).split();
+  // the stop races with the submission of the operation on the polling thread
+  for (int i = 0; i < 200; ++i) {
+    std::byte buf[16];
+    std::stop_source source;
+    std::thread stopper([&source] { source.request_stop(); });
+    auto [sz, err] = sys::net::read_for(in, buf, 1h, source.get_token()).block();
+    stopper.join();
+    ASSERT_EQ(sz, 0);
+    ASSERT_EQ(err, std::errc::operation_canceled);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, TimeoutTest,
+                         testing::Values(sync::PollEngine::EPOLL, sync::PollEngine::IO_URING),
+                         [](const testing::TestParamInfo<sync::PollEngine> &info) {
+                           return std::string(sync::to_string(info.param));
+                         });
+
+int main(int argc, char **argv) {
+  xsl::no_log();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
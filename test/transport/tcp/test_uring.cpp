@@ -0,0 +1,314 @@
+#include "xsl/coro.h"
+#include "xsl/logctl.h"
+#include "xsl/sync.h"
+#include "xsl/sys/net/socket.h"
+#include "xsl/sys/net/uring.h"
+
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <expected>
+#include <latch>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+using namespace xsl::coro;
+using namespace xsl;
+/**
+ * @brief a socket as the io_uring operations see it
+ *
+ * @tparam IO the direction of the socket
+ */
+template <template <class> class IO>
+struct Socket {
+  using socket_traits_type = sys::net::SocketTraits<feature::Tcp<feature::Ip<4>>>;
+  using device_traits_type = IO<socket_traits_type>;
+
+  int fd;
+  CountingSemaphore<1> ready;
+
+  int raw() const { return this->fd; }
+
+  CountingSemaphore<1> &sem() { return this->ready; }
+};
+/**
+ * @brief a pair of connected sockets and a polling thread with the io_uring engine
+ *
+ * @note skipped if io_uring is not available
+ */
+class UringTest : public testing::Test {
+public:
+  void SetUp() override {
+    this->poller = std::make_shared<sync::Poller>(sync::PollEngine::IO_URING);
+    if (this->poller->engine() != sync::PollEngine::IO_URING) {
+      GTEST_SKIP() << "io_uring is not available";
+    }
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+    this->out.emplace(fds[0]);
+    this->in.emplace(fds[1]);
+    this->thread = std::thread([poller = this->poller] {
+      while (poller->valid()) {
+        poller->poll();
+      }
+    });
+  }
+
+  void TearDown() override {
+    this->poller->shutdown();
+    if (this->thread.joinable()) {
+      this->thread.join();
+    }
+    if (this->out) {
+      ::close(this->out->fd);
+      ::close(this->in->fd);
+    }
+  }
+
+  std::optional<Socket<feature::Out>> out;
+  std::optional<Socket<feature::In>> in;
+  std::shared_ptr<sync::Poller> poller;
+  std::thread thread;
+};
+
+Lazy<void> recv_into(sync::Poller &poller, Socket<feature::In> &skt, std::span<std::byte> buf,
+                     std::stop_token token, std::optional<ai::Result> &res, std::latch &done) {
+  res = co_await sys::net::uring_recv(poller, skt, buf, std::move(token));
+  done.count_down();
+}
+
+TEST_F(UringTest, SendRecv) {
+  std::string_view msg = "hello";
+  auto [sz, err] = [](UringTest &t, std::string_view msg) -> Lazy<ai::Result> {
+    co_return co_await sys::net::uring_send(*t.poller, *t.out, std::as_bytes(std::span(msg)));
+  }(*this, msg)
+                                                                 .block();
+  ASSERT_EQ(sz, msg.size());
+  ASSERT_FALSE(err.has_value());
+  std::byte buf[16];
+  auto [r_sz, r_err] = [](UringTest &t, std::span<std::byte> buf) -> Lazy<ai::Result> {
+    co_return co_await sys::net::uring_recv(*t.poller, *t.in, buf);
+  }(*this, buf)
+                                                                   .block();
+  ASSERT_EQ(r_sz, msg.size());
+  ASSERT_FALSE(r_err.has_value());
+  ASSERT_EQ(std::string_view(reinterpret_cast<const char *>(buf), r_sz), msg);
+}
+
+TEST_F(UringTest, WaitRecv) {
+  std::byte buf[16];
+  std::optional<ai::Result> res;
+  std::latch done(1);
+  recv_into(*this->poller, *this->in, buf, {}, res, done).detach();
+  ASSERT_FALSE(res.has_value());
+  ASSERT_EQ(::send(this->out->fd, "ping", 4, 0), 4);
+  done.wait();
+  ASSERT_EQ(std::get<0>(*res), 4);
+  ASSERT_FALSE(std::get<1>(*res).has_value());
+}
+
+TEST_F(UringTest, Cancel) {
+  std::byte buf[16];
+  std::optional<ai::Result> res;
+  std::latch done(1);
+  std::stop_source source;
+  recv_into(*this->poller, *this->in, buf, source.get_token(), res, done).detach();
+  ASSERT_FALSE(res.has_value());
+  source.request_stop();
+  done.wait();
+  ASSERT_EQ(std::get<1>(*res), std::errc::operation_canceled);
+}
+
+TEST_F(UringTest, Shutdown) {
+  std::byte buf[16];
+  std::optional<ai::Result> res;
+  std::latch done(1);
+  recv_into(*this->poller, *this->in, buf, {}, res, done).detach();
+  ASSERT_FALSE(res.has_value());
+  // the pending operation is cancelled and completed by the polling thread
+  this->poller->shutdown();
+  done.wait();
+  ASSERT_EQ(std::get<0>(*res), 0);
+  ASSERT_TRUE(std::get<1>(*res).has_value());
+  this->thread.join();
+}
+
+Lazy<void> accept_into(sync::Poller &poller, Socket<feature::InOut> &skt,
+                       std::optional<std::expected<int, std::errc>> &res, std::latch &done) {
+  res = co_await sys::net::uring_accept(poller, skt, static_cast<sys::net::SockAddr *>(nullptr));
+  done.count_down();
+}
+
+TEST_F(UringTest, Accept) {
+  int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  ASSERT_NE(listener, -1);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  ASSERT_EQ(::bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+  ASSERT_EQ(::listen(listener, 1), 0);
+  ASSERT_EQ(::getsockname(listener, reinterpret_cast<sockaddr *>(&addr), &len), 0);
+  Socket<feature::InOut> skt{listener};
+  std::optional<std::expected<int, std::errc>> res;
+  std::latch done(1);
+  accept_into(*this->poller, skt, res, done).detach();
+  int client = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  ASSERT_EQ(::connect(client, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+  done.wait();
+  ASSERT_TRUE(res->has_value());
+  ASSERT_EQ(::send(client, "ping", 4, 0), 4);
+  char buf[16];
+  ASSERT_EQ(::recv(**res, buf, sizeof(buf), 0), 4);
+  ::close(**res);
+  ::close(client);
+  ::close(listener);
+}
+
+Lazy<void> sendfile_into(sync::Poller &poller, Socket<feature::Out> &skt,
+                         sys::net::SendfileHint hint, std::optional<ai::Result> &res,
+                         std::latch &done) {
+  res = co_await sys::net::uring_sendfile(poller, skt, std::move(hint));
+  done.count_down();
+}
+
+/// @brief a temporary file of the size filled with letters, the path is unlinked by the caller
+static std::string temp_file(std::string &data, std::size_t size) {
+  char path[] = "/tmp/xsl_uring_XXXXXX";
+  int ffd = ::mkstemp(path);
+  EXPECT_NE(ffd, -1);
+  data.assign(size, '\0');
+  for (std::size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>('a' + i % 26);
+  }
+  EXPECT_EQ(::write(ffd, data.data(), data.size()), static_cast<ssize_t>(data.size()));
+  ::close(ffd);
+  return path;
+}
+
+TEST_F(UringTest, Sendfile) {
+  std::string data;
+  // larger than a single splice
+  auto path = temp_file(data, 256 * 1024);
+  std::optional<ai::Result> res;
+  std::latch done(1);
+  sendfile_into(*this->poller, *this->out, {path, 0, data.size()}, res, done).detach();
+  std::string received;
+  char buf[64 * 1024];
+  while (received.size() < data.size()) {
+    auto n = ::recv(this->in->fd, buf, sizeof(buf), 0);
+    if (n > 0) {
+      received.append(buf, n);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  done.wait();
+  ::unlink(path.c_str());
+  ASSERT_EQ(std::get<0>(*res), data.size());
+  ASSERT_FALSE(std::get<1>(*res).has_value());
+  ASSERT_EQ(received, data);
+}
+
+TEST_F(UringTest, SendfileTcp) {
+  int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  ASSERT_NE(listener, -1);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  ASSERT_EQ(::bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+  ASSERT_EQ(::listen(listener, 1), 0);
+  ASSERT_EQ(::getsockname(listener, reinterpret_cast<sockaddr *>(&addr), &len), 0);
+  int client = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  ASSERT_EQ(::connect(client, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+  Socket<feature::Out> server{::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)};
+  ASSERT_NE(server.fd, -1);
+  ::close(listener);
+  std::string data;
+  // smaller than a segment, so it is held by the cork if the last splice has SPLICE_F_MORE
+  auto path = temp_file(data, 1000);
+  std::optional<ai::Result> res;
+  std::latch done(1);
+  auto start = std::chrono::steady_clock::now();
+  sendfile_into(*this->poller, server, {path, 0, data.size()}, res, done).detach();
+  std::string received;
+  char buf[4096];
+  while (received.size() < data.size()) {
+    auto n = ::recv(client, buf, sizeof(buf), 0);
+    ASSERT_GT(n, 0);
+    received.append(buf, n);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  done.wait();
+  ::unlink(path.c_str());
+  ASSERT_EQ(received, data);
+  // the cork holds the data for 200ms
+  ASSERT_LT(elapsed, std::chrono::milliseconds(100));
+  ::close(client);
+  ::close(server.fd);
+}
+
+TEST_F(UringTest, SendfileShutdown) {
+  std::string data;
+  // larger than the buffers of the sockets, the peer never reads
+  auto path = temp_file(data, 16 * 1024 * 1024);
+  std::optional<ai::Result> res;
+  std::latch done(1);
+  sendfile_into(*this->poller, *this->out, {path, 0, data.size()}, res, done).detach();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ASSERT_FALSE(res.has_value());
+  // the pending splice is cancelled by the shutdown, which is not a stop
+  this->poller->shutdown();
+  done.wait();
+  ::unlink(path.c_str());
+  ASSERT_LT(std::get<0>(*res), data.size());
+  ASSERT_EQ(std::get<1>(*res), std::errc::not_connected);
+  this->thread.join();
+}
+
+Lazy<ai::Result> read_once(sys::net::MultishotRecv &recv, std::span<std::byte> buf) {
+  co_return co_await recv.read(buf);
+}
+
+TEST_F(UringTest, MultishotRecv) {
+  auto ring = this->poller->make_buffer_ring(8, 4096);
+  if (!ring) {
+    GTEST_SKIP() << "provided buffer rings are not supported";
+  }
+  std::optional<sys::net::MultishotRecv> recv;
+  recv.emplace(*this->poller, ring, this->in->fd);
+  ASSERT_EQ(::send(this->out->fd, "hello", 5, 0), 5);
+  std::byte buf[16];
+  auto [sz, err] = read_once(*recv, buf).block();
+  // the buffer ring outlives the poller, it is unregistered before the ring is closed
+  recv.reset();
+  this->poller->shutdown();
+  this->thread.join();
+  this->poller.reset();
+  ring.reset();
+  this->poller = std::make_shared<sync::Poller>();
+  if (err == std::errc::no_buffer_space) {
+    GTEST_SKIP() << "provided buffer rings are not consumed by the kernel";
+  }
+  ASSERT_EQ(sz, 5);
+  ASSERT_FALSE(err.has_value());
+  ASSERT_EQ(std::string_view(reinterpret_cast<const char *>(buf), sz), "hello");
+}
+
+int main(int argc, char **argv) {
+  xsl::no_log();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
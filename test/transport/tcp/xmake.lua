@@ -36,3 +36,35 @@ target("test_tcp_listen")
     add_packages("cli11","gtest")
     on_package(function(package) end)
     add_tests("test_tcp_listen")
+
+target("test_tcp_io")
+    set_kind("binary")
+    set_default(false)
+    add_files("test_io.cpp")
+    add_packages("gtest")
+    on_package(function(package) end)
+    add_tests("test_tcp_io")
+
+target("test_tcp_uring")
+    set_kind("binary")
+    set_default(false)
+    add_files("test_uring.cpp")
+    add_packages("gtest")
+    on_package(function(package) end)
+    add_tests("test_tcp_uring")
+
+target("test_tcp_reuseport")
+    set_kind("binary")
+    set_default(false)
+    add_files("test_reuseport.cpp")
+    add_packages("gtest")
+    on_package(function(package) end)
+    add_tests("test_tcp_reuseport")
+
+target("test_tcp_timeout")
+    set_kind("binary")
+    set_default(false)
+    add_files("test_timeout.cpp")
+    add_packages("gtest")
+    on_package(function(package) end)
+    add_tests("test_tcp_timeout")
@@ -31,6 +31,28 @@ option("log_level")
     set_description("Set the log level")
 option_end()
 
+-- poll engine
+
+option("io_uring")
+    set_showmenu(true)
+    set_default(false)
+    set_description("Use io_uring as the default engine of sync::Poller")
+    add_defines("XSL_USE_IO_URING")
+option_end()
+
+add_options("io_uring")
+
+-- instruction set
+
+option("native_arch")
+    set_showmenu(true)
+    set_default(false)
+    set_description("Build for the host CPU, so the http parser scans with SSE4.2 or AVX2")
+    add_cxflags("-march=native")
+option_end()
+
+add_options("native_arch")
+
 function set_log_level(target)
     local log_level = get_config("log_level")
     local log_levels = {"none", "trace", "debug", "info", "warning", "error", "critical"}